@@ -76,6 +76,10 @@ android {
     }
 
     buildFeatures { viewBinding = true }
+
+    // Models are mmapped straight out of the APK, which only works for
+    // stored (uncompressed) entries.
+    androidResources { noCompress += "tflite" }
 }
 
 dependencies {
@@ -0,0 +1,41 @@
+#include "BufferImportCache.h"
+
+uint32_t BufferImportCache::texture(void* buffer) {
+    ++clock_;
+    for (int i = 0; i < size_; ++i) {
+        if (entries_[i].buffer == buffer) {
+            entries_[i].lastUsed = clock_;
+            if (entries_[i].texture) ++hits_;
+            return entries_[i].texture;
+        }
+    }
+
+    int slot = size_;
+    if (size_ == kCapacity) {
+        slot = 0;
+        for (int i = 1; i < size_; ++i) {
+            if (entries_[i].lastUsed < entries_[slot].lastUsed) slot = i;
+        }
+        Entry& victim = entries_[slot];
+        if (victim.texture) importer_.release(victim.buffer, victim.texture);
+        ++evictions_;
+    } else {
+        ++size_;
+    }
+
+    Entry& entry = entries_[slot];
+    entry.buffer = buffer;
+    entry.texture = importer_.import(buffer);
+    entry.lastUsed = clock_;
+    if (entry.texture) ++imports_;
+    else ++failures_;
+    return entry.texture;
+}
+
+void BufferImportCache::clear() {
+    for (int i = 0; i < size_; ++i) {
+        if (entries_[i].texture) importer_.release(entries_[i].buffer, entries_[i].texture);
+        entries_[i] = Entry{};
+    }
+    size_ = 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// Wraps a GPU buffer as a texture the shader samples in place.
+class BufferImporter {
+public:
+    virtual ~BufferImporter() = default;
+
+    // 0 if the buffer cannot be imported; the frame is then uploaded instead.
+    virtual uint32_t import(void* buffer) = 0;
+    virtual void release(void* buffer, uint32_t texture) = 0;
+};
+
+// Imports each buffer once. A camera reader cycles through the same few
+// buffers for its whole life, so after the first lap every frame is a hit
+// and no per-frame import objects are created. A buffer that failed to
+// import is remembered too, so it is not retried on every frame.
+// Least recently used entries are released when more buffers than
+// kCapacity show up. Render thread only.
+class BufferImportCache {
+public:
+    static constexpr int kCapacity = 8;  // above any stream's maxImages
+
+    explicit BufferImportCache(BufferImporter& importer) : importer_(importer) {}
+    ~BufferImportCache() { clear(); }
+    BufferImportCache(const BufferImportCache&) = delete;
+    BufferImportCache& operator=(const BufferImportCache&) = delete;
+
+    // Texture for the buffer, importing it on first sight; 0 if it cannot
+    // be imported.
+    uint32_t texture(void* buffer);
+    // Releases every import. The textures must no longer be in use.
+    void clear();
+
+    int size() const { return size_; }
+    uint64_t imports() const { return imports_; }
+    uint64_t hits() const { return hits_; }
+    uint64_t evictions() const { return evictions_; }
+    uint64_t failures() const { return failures_; }
+
+private:
+    struct Entry {
+        void* buffer = nullptr;
+        uint32_t texture = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    BufferImporter& importer_;
+    Entry entries_[kCapacity];
+    int size_ = 0;
+    uint64_t clock_ = 0;
+    uint64_t imports_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t failures_ = 0;
+};
@@ -0,0 +1,150 @@
+#define LOG_TAG "BufferPool"
+
+#include "BufferPool.h"
+#include "Log.h"
+#include <cstdlib>
+
+namespace {
+
+// Sits in the cache line in front of every buffer, so a bare data pointer is
+// enough to find its way home.
+struct Header {
+    BufferPool* pool;
+    int sizeClass;
+};
+static_assert(sizeof(Header) <= BufferPool::kAlignment, "header must fit in the prefix");
+
+Header* headerOf(void* data) { return reinterpret_cast<Header*>(static_cast<uint8_t*>(data) - BufferPool::kAlignment); }
+
+void freeBuffer(uint8_t* data) { std::free(data - BufferPool::kAlignment); }
+
+}  // namespace
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void PooledBuffer::reset() {
+    if (data_) BufferPool::recycle(data_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+uint8_t* PooledBuffer::release() {
+    uint8_t* data = data_;
+    data_ = nullptr;
+    size_ = 0;
+    return data;
+}
+
+BufferPool::~BufferPool() {
+    for (Class& c : classes_) {
+        for (auto& slot : c.cached) {
+            if (uint8_t* data = slot.exchange(nullptr, std::memory_order_acquire)) freeBuffer(data);
+        }
+    }
+}
+
+int BufferPool::classFor(size_t bytes) {
+    for (int c = 0; c < kClassCount; ++c) {
+        if (bytes <= classBytes(c)) return c;
+    }
+    return -1;
+}
+
+uint8_t* BufferPool::allocate(int sizeClass) {
+    void* block = nullptr;
+    // posix_memalign rather than aligned_alloc, which needs API 28.
+    if (posix_memalign(&block, kAlignment, kAlignment + classBytes(sizeClass)) != 0) return nullptr;
+    auto* data = static_cast<uint8_t*>(block) + kAlignment;
+    *headerOf(data) = Header{this, sizeClass};
+    return data;
+}
+
+PooledBuffer BufferPool::acquire(size_t bytes) {
+    const int sizeClass = bytes ? classFor(bytes) : -1;
+    if (sizeClass < 0) return {};
+    Class& c = classes_[sizeClass];
+
+    uint8_t* data = nullptr;
+    for (auto& slot : c.cached) {
+        // Look before exchanging so empty slots are not written to.
+        if (slot.load(std::memory_order_relaxed) && (data = slot.exchange(nullptr, std::memory_order_acquire))) break;
+    }
+    if (!data) {
+        data = allocate(sizeClass);
+        if (!data) {
+            LOGE("Out of memory for a %zu byte buffer", classBytes(sizeClass));
+            return {};
+        }
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    c.acquires.fetch_add(1, std::memory_order_relaxed);
+    int now = c.outstanding.fetch_add(1, std::memory_order_relaxed) + 1;
+    int peak = c.peakOutstanding.load(std::memory_order_relaxed);
+    while (now > peak && !c.peakOutstanding.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    return PooledBuffer(data, bytes);
+}
+
+void BufferPool::recycle(void* data) {
+    if (!data) return;
+    const Header& header = *headerOf(data);
+    header.pool->classes_[header.sizeClass].outstanding.fetch_sub(1, std::memory_order_relaxed);
+    header.pool->give(header.sizeClass, static_cast<uint8_t*>(data));
+}
+
+void BufferPool::give(int sizeClass, uint8_t* data) {
+    for (auto& slot : classes_[sizeClass].cached) {
+        uint8_t* expected = nullptr;
+        if (!slot.load(std::memory_order_relaxed) &&
+            slot.compare_exchange_strong(expected, data, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    freeBuffer(data);  // cache full
+}
+
+void BufferPool::reserve(size_t bytes, int count) {
+    const int sizeClass = classFor(bytes);
+    if (sizeClass < 0) return;
+    for (int i = 0; i < count; ++i) {
+        uint8_t* data = allocate(sizeClass);
+        if (!data) return;
+        classes_[sizeClass].allocations.fetch_add(1, std::memory_order_relaxed);
+        give(sizeClass, data);
+    }
+}
+
+BufferPool::ClassStats BufferPool::stats(int sizeClass) const {
+    const Class& c = classes_[sizeClass];
+    ClassStats s;
+    s.bytes = classBytes(sizeClass);
+    s.acquires = c.acquires.load(std::memory_order_relaxed);
+    s.allocations = c.allocations.load(std::memory_order_relaxed);
+    s.outstanding = c.outstanding.load(std::memory_order_relaxed);
+    s.peakOutstanding = c.peakOutstanding.load(std::memory_order_relaxed);
+    return s;
+}
+
+size_t BufferPool::peakBytes() const {
+    size_t total = 0;
+    for (int c = 0; c < kClassCount; ++c) total += size_t(stats(c).peakOutstanding) * classBytes(c);
+    return total;
+}
+
+void BufferPool::logStats(const char* name) const {
+    for (int c = 0; c < kClassCount; ++c) {
+        const ClassStats s = stats(c);
+        if (!s.acquires && !s.allocations) continue;
+        LOGI("%s %7zu B: %llu acquires, %llu allocations, %d outstanding, peak %d", name, s.bytes,
+             (unsigned long long)s.acquires, (unsigned long long)s.allocations, s.outstanding, s.peakOutstanding);
+    }
+    LOGI("%s peak %.1f KiB held", name, peakBytes() / 1024.0);
+}
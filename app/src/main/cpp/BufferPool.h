@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class BufferPool;
+
+// Move-only handle to a pooled buffer; returns it to its pool when destroyed.
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    PooledBuffer(PooledBuffer&& other) noexcept : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+    ~PooledBuffer() { reset(); }
+
+    uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }  // as requested; the buffer may be larger
+    explicit operator bool() const { return data_ != nullptr; }
+
+    void reset();
+    // Gives up ownership without recycling; hand the pointer to
+    // BufferPool::recycle() later, e.g. as a FramePool release function.
+    uint8_t* release();
+
+private:
+    friend class BufferPool;
+    PooledBuffer(uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Size-classed pool of cache-line-aligned buffers for memory that must
+// outlive a camera image: frame copies (copyFrame) and what FrameRecorder
+// writes. Preprocessing needs none: it writes straight into the model's
+// input tensor and only keeps index tables that change with the geometry.
+// Classes are powers of two from kMinBytes; a buffer goes back to its
+// class's cache when its handle dies, so once the pipeline has warmed up
+// every acquire is a cache hit and nothing touches the heap.
+//
+// Acquire and recycle are lock-free and may run on any thread, e.g. acquire
+// on the camera callback thread and recycle on the render or inference
+// thread. Each class caches up to kCachedPerClass idle buffers; beyond that
+// recycled buffers are freed. Misses allocate. The pool must outlive every
+// buffer it handed out.
+class BufferPool {
+public:
+    static constexpr size_t kAlignment = 64;
+    static constexpr size_t kMinBytes = 256;
+    static constexpr int kClassCount = 18;  // up to 32 MiB
+    static constexpr int kCachedPerClass = 16;
+
+    struct ClassStats {
+        size_t bytes = 0;         // capacity of each buffer in the class
+        uint64_t acquires = 0;
+        uint64_t allocations = 0;  // acquires that missed the cache
+        int outstanding = 0;      // handed out and not yet recycled
+        int peakOutstanding = 0;  // high-water mark
+    };
+
+    BufferPool() = default;
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    // Frees the cached buffers. Buffers still handed out must be gone.
+    ~BufferPool();
+
+    // A buffer of at least `bytes`, aligned to kAlignment; empty if bytes is
+    // 0, larger than the largest class, or the allocation failed.
+    PooledBuffer acquire(size_t bytes);
+    // Returns a buffer given up with PooledBuffer::release() to its pool.
+    static void recycle(void* data);
+
+    // Allocates `count` buffers of `bytes` into the cache ahead of time, so
+    // even the first frames do not hit the heap.
+    void reserve(size_t bytes, int count);
+
+    ClassStats stats(int sizeClass) const;
+    static int classFor(size_t bytes);
+    static size_t classBytes(int sizeClass) { return kMinBytes << sizeClass; }
+    // Sum over classes of peakOutstanding * class size: the most memory the
+    // pipeline ever held at once, give or take classes peaking at different
+    // times.
+    size_t peakBytes() const;
+    // Logs every class that was used.
+    void logStats(const char* name) const;
+
+private:
+    struct Class {
+        std::atomic<uint8_t*> cached[kCachedPerClass] = {};
+        std::atomic<uint64_t> acquires{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<int> outstanding{0};
+        std::atomic<int> peakOutstanding{0};
+    };
+
+    uint8_t* allocate(int sizeClass);
+    void give(int sizeClass, uint8_t* data);
+
+    Class classes_[kClassCount];
+};
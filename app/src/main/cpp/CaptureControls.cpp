@@ -0,0 +1,77 @@
+#include "CaptureControls.h"
+#include <algorithm>
+#include <cstdlib>
+
+void CaptureCapabilities::setFpsRanges(const int32_t* pairs, size_t count) {
+    fpsRanges.clear();
+    for (size_t i = 0; i + 1 < count; i += 2) fpsRanges.push_back({pairs[i], pairs[i + 1]});
+}
+
+namespace {
+
+template <typename T>
+T clampTo(T value, T low, T high) {
+    if (high <= 0 && low <= 0) return value;  // range not reported
+    return std::min(std::max(value, low), high);
+}
+
+// The listed range nearest the request: the closest maximum first (it sets
+// the frame rate AE aims for), then the closest minimum (how far AE may
+// drop it).
+FpsRange closestRange(FpsRange requested, const std::vector<FpsRange>& ranges) {
+    if (ranges.empty()) return requested;
+    auto cost = [requested](const FpsRange& range) {
+        return std::make_pair(std::abs(range.max - requested.max), std::abs(range.min - requested.min));
+    };
+    return *std::min_element(ranges.begin(), ranges.end(),
+                             [&](const FpsRange& a, const FpsRange& b) { return cost(a) < cost(b); });
+}
+
+}  // namespace
+
+CaptureControls resolveControls(const CaptureControls& requested, const CaptureCapabilities& capabilities) {
+    CaptureControls controls = requested;
+    if (controls.fps.max > 0) {
+        controls.fps.min = std::min(std::max(controls.fps.min, 1), controls.fps.max);
+        controls.fps = closestRange(controls.fps, capabilities.fpsRanges);
+    } else {
+        controls.fps = {};
+    }
+
+    if (controls.exposureTimeNs > 0 && capabilities.manualSensor) {
+        controls.exposureTimeNs =
+                clampTo(controls.exposureTimeNs, capabilities.minExposureNs, capabilities.maxExposureNs);
+        // An exposure longer than the frame stretches the frame instead.
+        if (controls.fps.max > 0) controls.exposureTimeNs = std::min<int64_t>(controls.exposureTimeNs,
+                                                                             1000000000LL / controls.fps.max);
+        if (controls.sensitivity > 0) {
+            controls.sensitivity =
+                    clampTo(controls.sensitivity, capabilities.minSensitivity, capabilities.maxSensitivity);
+        }
+    } else {
+        controls.exposureTimeNs = 0;
+        controls.sensitivity = 0;
+    }
+    controls.exposureCompensation =
+            clampTo(controls.exposureCompensation, capabilities.minCompensation, capabilities.maxCompensation);
+
+    const std::vector<FocusMode>& modes = capabilities.focusModes;
+    auto listed = [&modes](FocusMode mode) {
+        return modes.empty() || std::find(modes.begin(), modes.end(), mode) != modes.end();
+    };
+    if (!listed(controls.focus)) {
+        for (FocusMode fallback : {FocusMode::Continuous, FocusMode::Auto, FocusMode::Fixed}) {
+            if (listed(fallback)) {
+                controls.focus = fallback;
+                break;
+            }
+        }
+    }
+    if (controls.focus == FocusMode::Fixed) {
+        // A fixed-focus lens has no distance to set.
+        controls.focusDistance = capabilities.minFocusDistance > 0
+                                 ? std::min(std::max(controls.focusDistance, 0.0f), capabilities.minFocusDistance)
+                                 : 0.0f;
+    }
+    return controls;
+}
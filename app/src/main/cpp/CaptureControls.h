@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct FpsRange {
+    int min = 0;
+    int max = 0;
+
+    bool operator==(const FpsRange& other) const { return min == other.min && max == other.max; }
+};
+
+enum class FocusMode {
+    Continuous,  // continuous video AF: smooth, no hunting between frames
+    Auto,        // single sweep on trigger; holds focus otherwise
+    Fixed,       // AF off, lens at focusDistance
+};
+
+// Controls for the repeating capture request. Zero fields leave the
+// TEMPLATE_PREVIEW value alone.
+struct CaptureControls {
+    // AE target frame rate range. A fixed range such as {30, 30} keeps AE
+    // from stretching exposures (and dropping the frame rate) in low light;
+    // frames get darker and noisier instead.
+    FpsRange fps;
+    // Manual exposure when > 0: AE is switched off and these go to the sensor.
+    int64_t exposureTimeNs = 0;
+    int32_t sensitivity = 0;  // ISO; with manual exposure only
+    // AE bias in steps of the camera's compensation step, with AE on.
+    int32_t exposureCompensation = 0;
+    bool aeLock = false;
+    FocusMode focus = FocusMode::Continuous;
+    float focusDistance = 0.0f;  // diopters (1 / metres), 0 = infinity; Fixed only
+};
+
+// The ranges a camera accepts, from its static characteristics. Empty or
+// zero fields mean the camera did not report them and are not enforced.
+struct CaptureCapabilities {
+    std::vector<FpsRange> fpsRanges;  // ACAMERA_CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES
+    int64_t minExposureNs = 0;        // ACAMERA_SENSOR_INFO_EXPOSURE_TIME_RANGE
+    int64_t maxExposureNs = 0;
+    int32_t minSensitivity = 0;       // ACAMERA_SENSOR_INFO_SENSITIVITY_RANGE
+    int32_t maxSensitivity = 0;
+    int32_t minCompensation = 0;      // ACAMERA_CONTROL_AE_COMPENSATION_RANGE
+    int32_t maxCompensation = 0;
+    float minFocusDistance = 0.0f;    // ACAMERA_LENS_INFO_MINIMUM_FOCUS_DISTANCE; 0 = fixed focus
+    // ACAMERA_CONTROL_AF_AVAILABLE_MODES that have a FocusMode; a fixed-focus
+    // lens lists only AF off (Fixed).
+    std::vector<FocusMode> focusModes;
+    bool manualSensor = false;        // MANUAL_SENSOR capability: exposure time and ISO are honoured
+
+    // fpsRanges from the metadata's flat (min, max) pairs.
+    void setFpsRanges(const int32_t* pairs, size_t count);
+};
+
+// The controls the camera will actually run: the fps range becomes the
+// closest one the camera lists, and every value is clamped to its range.
+// Manual exposure is dropped without the MANUAL_SENSOR capability, and a
+// manual exposure never outlasts the frame at fps.max. A focus mode the
+// camera does not list becomes the first listed of Continuous, Auto and
+// Fixed, so a fixed-focus lens always runs with AF off.
+CaptureControls resolveControls(const CaptureControls& requested, const CaptureCapabilities& capabilities);
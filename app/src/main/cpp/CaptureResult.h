@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// What the camera did for one capture, from its result metadata.
+struct CaptureResultInfo {
+    int64_t timestampNs = 0;      // ACAMERA_SENSOR_TIMESTAMP, same as the frame's
+    int64_t frameNumber = -1;     // from capture start, +1 per capture; gaps are captures lost on the way
+    int64_t frameDurationNs = 0;  // ACAMERA_SENSOR_FRAME_DURATION
+    int64_t exposureTimeNs = 0;   // ACAMERA_SENSOR_EXPOSURE_TIME
+    int32_t sensitivity = 0;      // ACAMERA_SENSOR_SENSITIVITY
+
+    // The full result is in, not just the capture start.
+    bool complete() const { return frameDurationNs > 0; }
+    double fps() const { return frameDurationNs > 0 ? 1e9 / frameDurationNs : 0.0; }
+};
+
+// The last kCapacity capture results, looked up by sensor timestamp to join
+// them with the images of the same capture. Results and images arrive on
+// different threads in no fixed order, typically the capture start first,
+// then the image, then the full result a few milliseconds later.
+//
+// One writer (the camera's callback thread), any number of readers. Every
+// slot is a seqlock, so neither side locks or allocates; a reader that races
+// a write to the slot it wants retries.
+class CaptureResultTable {
+public:
+    static constexpr int kCapacity = 32;  // well past any frame's time in flight
+
+    // Inserts a capture, or fills in the fields `result` has set on the one
+    // with the same timestamp.
+    void record(const CaptureResultInfo& result) {
+        int index = -1;
+        for (int i = 0; i < kCapacity && index < 0; ++i) {
+            if (slots_[i].timestampNs.load(std::memory_order_relaxed) == result.timestampNs) index = i;
+        }
+        const bool merge = index >= 0;
+        if (!merge) index = next_++ % kCapacity;
+        Slot& slot = slots_[index];
+        const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestampNs.store(result.timestampNs, std::memory_order_relaxed);
+        if (!merge || result.frameNumber >= 0) slot.frameNumber.store(result.frameNumber, std::memory_order_relaxed);
+        if (!merge || result.frameDurationNs > 0) {
+            slot.frameDurationNs.store(result.frameDurationNs, std::memory_order_relaxed);
+        }
+        if (!merge || result.exposureTimeNs > 0) slot.exposureTimeNs.store(result.exposureTimeNs, std::memory_order_relaxed);
+        if (!merge || result.sensitivity > 0) slot.sensitivity.store(result.sensitivity, std::memory_order_relaxed);
+        slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies the capture with this timestamp into out; false if it has not
+    // arrived yet or was already overwritten.
+    bool find(int64_t timestampNs, CaptureResultInfo& out) const {
+        for (const Slot& slot : slots_) {
+            if (slot.timestampNs.load(std::memory_order_relaxed) != timestampNs) continue;
+            for (;;) {
+                const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+                if (seq & 1) continue;
+                CaptureResultInfo result;
+                result.timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+                result.frameNumber = slot.frameNumber.load(std::memory_order_relaxed);
+                result.frameDurationNs = slot.frameDurationNs.load(std::memory_order_relaxed);
+                result.exposureTimeNs = slot.exposureTimeNs.load(std::memory_order_relaxed);
+                result.sensitivity = slot.sensitivity.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+                if (result.timestampNs != timestampNs) return false;  // slot reused meanwhile
+                out = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Writer only, with no readers left.
+    void clear() {
+        for (Slot& slot : slots_) {
+            slot.timestampNs.store(0, std::memory_order_relaxed);
+            slot.frameNumber.store(-1, std::memory_order_relaxed);
+            slot.frameDurationNs.store(0, std::memory_order_relaxed);
+            slot.exposureTimeNs.store(0, std::memory_order_relaxed);
+            slot.sensitivity.store(0, std::memory_order_relaxed);
+        }
+        next_ = 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<int64_t> timestampNs{0};
+        std::atomic<int64_t> frameNumber{-1};
+        std::atomic<int64_t> frameDurationNs{0};
+        std::atomic<int64_t> exposureTimeNs{0};
+        std::atomic<int32_t> sensitivity{0};
+    };
+
+    Slot slots_[kCapacity];
+    uint32_t next_ = 0;  // writer only
+};
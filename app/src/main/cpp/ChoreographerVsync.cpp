@@ -0,0 +1,48 @@
+#define LOG_TAG "ChoreographerVsync"
+
+#include "ChoreographerVsync.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <android/choreographer.h>
+#include <android/looper.h>
+
+void ChoreographerVsync::start() {
+    if (running_) return;
+    open();
+    running_ = true;
+    thread_ = std::thread(&ChoreographerVsync::run, this);
+}
+
+void ChoreographerVsync::stop() {
+    running_ = false;
+    if (ALooper* looper = looper_.load()) ALooper_wake(looper);
+    if (thread_.joinable()) thread_.join();
+    close();
+}
+
+void ChoreographerVsync::onFrame(long frameTimeNanos, void* self) {
+    auto* vsync = static_cast<ChoreographerVsync*>(self);
+    // Frame times are on CLOCK_MONOTONIC, like every other pipeline
+    // timestamp, but a 32-bit long wraps every 4 s; there the callback time
+    // stands in, a fraction of a millisecond after the vsync.
+    vsync->tick(sizeof(long) >= sizeof(int64_t) ? int64_t(frameTimeNanos) : monotonicNowNs());
+    if (vsync->running_) AChoreographer_postFrameCallback(AChoreographer_getInstance(), onFrame, self);
+}
+
+void ChoreographerVsync::run() {
+    ALooper* looper = ALooper_prepare(0);
+    AChoreographer* choreographer = AChoreographer_getInstance();
+    if (!choreographer) {
+        LOGE("No choreographer on the vsync thread; frames will not be paced");
+        fail();
+        return;
+    }
+    ALooper_acquire(looper);
+    looper_ = looper;
+    // postFrameCallback64 would need API 29.
+    AChoreographer_postFrameCallback(choreographer, onFrame, this);
+    // Every callback, and stop()'s wake, returns from the poll.
+    while (running_) ALooper_pollOnce(-1, nullptr, nullptr, nullptr);
+    looper_ = nullptr;
+    ALooper_release(looper);
+}
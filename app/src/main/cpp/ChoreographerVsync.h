@@ -0,0 +1,26 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include "VsyncSource.h"
+
+struct ALooper;
+
+// Vsync ticks from AChoreographer. The choreographer only calls back on a
+// looper thread, so this runs its own: it posts a frame callback, and every
+// callback reports the vsync's frame time and posts the next one.
+class ChoreographerVsync : public VsyncSource {
+public:
+    ChoreographerVsync() = default;
+    ~ChoreographerVsync() override { stop(); }
+
+    void start() override;
+    void stop() override;
+
+private:
+    static void onFrame(long frameTimeNanos, void* self);
+    void run();
+
+    std::thread thread_;
+    std::atomic<ALooper*> looper_{nullptr};
+    std::atomic<bool> running_{false};
+};
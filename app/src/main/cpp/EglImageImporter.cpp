@@ -0,0 +1,65 @@
+#define LOG_TAG "EglImageImporter"
+
+#include "EglImageImporter.h"
+#include "Log.h"
+#include <dlfcn.h>
+
+bool EglImageImporter::init(EGLDisplay display) {
+    display_ = display;
+    getNativeClientBuffer_ = reinterpret_cast<PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC>(
+            eglGetProcAddress("eglGetNativeClientBufferANDROID"));
+    createImage_ = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(eglGetProcAddress("eglCreateImageKHR"));
+    destroyImage_ = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(eglGetProcAddress("eglDestroyImageKHR"));
+    imageTargetTexture_ = reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+            eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+    if (void* android = dlopen("libandroid.so", RTLD_NOW)) {
+        acquireBuffer_ = reinterpret_cast<BufferRefFn>(dlsym(android, "AHardwareBuffer_acquire"));
+        releaseBuffer_ = reinterpret_cast<BufferRefFn>(dlsym(android, "AHardwareBuffer_release"));
+    }
+    const bool ok = getNativeClientBuffer_ && createImage_ && destroyImage_ && imageTargetTexture_ &&
+                    acquireBuffer_ && releaseBuffer_;
+    if (!ok) LOGI("AHardwareBuffer import unavailable; frames will be uploaded");
+    return ok;
+}
+
+uint32_t EglImageImporter::import(void* buffer) {
+    if (!getNativeClientBuffer_ || !acquireBuffer_) return 0;
+    auto* hardwareBuffer = static_cast<AHardwareBuffer*>(buffer);
+    EGLClientBuffer clientBuffer = getNativeClientBuffer_(hardwareBuffer);
+    const EGLint attribs[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+    EGLImageKHR image = clientBuffer ? createImage_(display_, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+                                                    clientBuffer, attribs)
+                                     : EGL_NO_IMAGE_KHR;
+    if (image == EGL_NO_IMAGE_KHR) {
+        LOGE("eglCreateImageKHR failed: 0x%x", eglGetError());
+        return 0;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    imageTargetTexture_(GL_TEXTURE_EXTERNAL_OES, static_cast<GLeglImageOES>(image));
+    if (GLenum err = glGetError(); err != GL_NO_ERROR) {
+        LOGE("glEGLImageTargetTexture2DOES failed: 0x%x", err);
+        glDeleteTextures(1, &texture);
+        destroyImage_(display_, image);
+        return 0;
+    }
+
+    acquireBuffer_(hardwareBuffer);
+    images_[texture] = image;
+    return texture;
+}
+
+void EglImageImporter::release(void* buffer, uint32_t texture) {
+    auto it = images_.find(texture);
+    if (it == images_.end()) return;
+    glDeleteTextures(1, &texture);
+    destroyImage_(display_, it->second);
+    images_.erase(it);
+    releaseBuffer_(static_cast<AHardwareBuffer*>(buffer));
+}
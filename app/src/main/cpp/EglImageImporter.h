@@ -0,0 +1,35 @@
+#pragma once
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+#include <unordered_map>
+#include "BufferImportCache.h"
+
+struct AHardwareBuffer;
+
+// BufferImporter for AHardwareBuffers: each becomes an EGLImage bound to a
+// GL_TEXTURE_EXTERNAL_OES texture. The buffer is referenced for as long as
+// it is imported, so its address cannot be reused by a new buffer while the
+// cache still maps it. The entry points are API 26+ and looked up at run
+// time, as the app still installs on API 24.
+class EglImageImporter : public BufferImporter {
+public:
+    // False (and every import() returns 0) when the device lacks them.
+    bool init(EGLDisplay display);
+
+    uint32_t import(void* buffer) override;
+    void release(void* buffer, uint32_t texture) override;
+
+private:
+    using BufferRefFn = void (*)(AHardwareBuffer*);
+
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC getNativeClientBuffer_ = nullptr;
+    PFNEGLCREATEIMAGEKHRPROC createImage_ = nullptr;
+    PFNEGLDESTROYIMAGEKHRPROC destroyImage_ = nullptr;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC imageTargetTexture_ = nullptr;
+    BufferRefFn acquireBuffer_ = nullptr;
+    BufferRefFn releaseBuffer_ = nullptr;
+    std::unordered_map<uint32_t, EGLImageKHR> images_;
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Decides which presented frames are also drawn into a video encoder's input
+// surface. eglSwapBuffers on that surface blocks once the codec holds all of
+// its input buffers, so the render thread only submits while fewer than
+// maxInFlight frames are inside the codec: an encoder that falls behind
+// costs frames in the video, never a late preview swap.
+//
+// Also keeps timestamps strictly increasing (the muxer rejects anything
+// else) and, with a minimum interval, caps the encoded frame rate. The
+// interval is a grid with a quarter-interval tolerance so camera jitter does
+// not knock out every other frame.
+//
+// admit()/cancel() are for the render thread, onEncoded() and resync() for
+// the codec's output thread.
+class EncoderThrottle {
+public:
+    explicit EncoderThrottle(int maxInFlight = 4, int64_t minIntervalNs = 0)
+        : maxInFlight_(maxInFlight), minIntervalNs_(minIntervalNs) {}
+
+    // True if the frame should be encoded; every true must be followed by
+    // onEncoded() once the codec emits it, or cancel() if it was never
+    // submitted.
+    bool admit(int64_t timestampNs) {
+        if (lastNs_ >= 0 && timestampNs <= lastNs_) {
+            skippedStale_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (minIntervalNs_ > 0 && lastNs_ >= 0 && timestampNs < dueNs_ - minIntervalNs_ / 4) {
+            skippedRate_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        const uint64_t submitted = submitted_.load(std::memory_order_relaxed);
+        // Signed: a cancel() racing resync() can leave encoded one ahead.
+        if (int64_t(submitted - encoded_.load(std::memory_order_acquire)) >= maxInFlight_) {
+            skippedBehind_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        submitted_.store(submitted + 1, std::memory_order_relaxed);
+        // Stay on the grid unless the input fell more than a frame behind it.
+        dueNs_ = lastNs_ >= 0 && timestampNs - dueNs_ < minIntervalNs_ ? dueNs_ + minIntervalNs_
+                                                                        : timestampNs + minIntervalNs_;
+        lastNs_ = timestampNs;
+        return true;
+    }
+
+    // The frame admitted last was not submitted after all.
+    void cancel() { submitted_.fetch_sub(1, std::memory_order_relaxed); }
+
+    void onEncoded() {
+        // A frame resync() gave up on turned up after all.
+        if (encoded_.load(std::memory_order_relaxed) >= submitted_.load(std::memory_order_relaxed)) {
+            lost_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        encoded_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Gives up on every frame in flight, for when the codec has gone quiet
+    // with some still inside it: a codec that drops an input frame never
+    // emits it, and without this admit() would stay shut for good. Returns
+    // how many were given up.
+    int resync() {
+        const uint64_t submitted = submitted_.load(std::memory_order_relaxed);
+        const uint64_t encoded = encoded_.load(std::memory_order_relaxed);
+        if (int64_t(submitted - encoded) <= 0) return 0;
+        lost_.fetch_add(submitted - encoded, std::memory_order_relaxed);
+        encoded_.store(submitted, std::memory_order_release);
+        return int(submitted - encoded);
+    }
+
+    int inFlight() const {
+        return int(submitted_.load(std::memory_order_relaxed) - encoded_.load(std::memory_order_acquire));
+    }
+    uint64_t submitted() const { return submitted_.load(std::memory_order_relaxed); }
+    uint64_t encoded() const { return encoded_.load(std::memory_order_relaxed); }
+    // Frames the codec took and never emitted, as far as resync() knows.
+    uint64_t lost() const { return lost_.load(std::memory_order_relaxed); }
+    // Frames not sent because the codec was maxInFlight behind.
+    uint64_t skippedBehind() const { return skippedBehind_.load(std::memory_order_relaxed); }
+    // Frames not sent because of the frame rate cap.
+    uint64_t skippedRate() const { return skippedRate_.load(std::memory_order_relaxed); }
+    // Frames not sent because their timestamp did not move forward.
+    uint64_t skippedStale() const { return skippedStale_.load(std::memory_order_relaxed); }
+
+private:
+    const int maxInFlight_;
+    const int64_t minIntervalNs_;
+    int64_t lastNs_ = -1;  // render thread only
+    int64_t dueNs_ = 0;
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> encoded_{0};
+    std::atomic<uint64_t> lost_{0};
+    std::atomic<uint64_t> skippedBehind_{0};
+    std::atomic<uint64_t> skippedRate_{0};
+    std::atomic<uint64_t> skippedStale_{0};
+};
@@ -0,0 +1,75 @@
+#include "FrameCopy.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct Span {
+    const uint8_t* begin;
+    const uint8_t* end;
+    size_t offset;  // in the copy
+};
+
+}  // namespace
+
+FrameHandle copyFrame(const Frame& frame, FramePool& frames, BufferPool& buffers) {
+    // Merge overlapping plane ranges so each byte is copied once and aliasing
+    // planes keep their relative offsets.
+    Span spans[Frame::kMaxPlanes];
+    int spanOf[Frame::kMaxPlanes] = {};
+    int order[Frame::kMaxPlanes];
+    const int planeCount = std::min(frame.planeCount, Frame::kMaxPlanes);
+    // Insertion sort by address; std::sort on this little array trips GCC
+    // 12's -Warray-bounds.
+    for (int i = 0; i < planeCount; ++i) {
+        int k = i;
+        for (; k > 0 && frame.planes[order[k - 1]].data > frame.planes[i].data; --k) order[k] = order[k - 1];
+        order[k] = i;
+    }
+    int spanCount = 0;
+    size_t total = 0;
+    for (int k = 0; k < planeCount; ++k) {
+        const FramePlane& plane = frame.planes[order[k]];
+        const uint8_t* end = plane.data + plane.length;
+        if (spanCount > 0 && plane.data <= spans[spanCount - 1].end) {
+            Span& last = spans[spanCount - 1];
+            if (end > last.end) {
+                total += end - last.end;
+                last.end = end;
+            }
+        } else {
+            total = (total + BufferPool::kAlignment - 1) & ~(BufferPool::kAlignment - 1);
+            spans[spanCount++] = Span{plane.data, end, total};
+            total += plane.length;
+        }
+        spanOf[order[k]] = spanCount - 1;
+    }
+
+    PooledBuffer buffer = buffers.acquire(total);
+    if (!buffer) return {};
+    for (int s = 0; s < spanCount; ++s) {
+        std::memcpy(buffer.data() + spans[s].offset, spans[s].begin, spans[s].end - spans[s].begin);
+    }
+    uint8_t* data = buffer.data();
+    FrameHandle copy = frames.acquire(data, &BufferPool::recycle);
+    if (!copy) return {};  // buffer goes back with the handle
+    buffer.release();
+
+    copy->width = frame.width;
+    copy->height = frame.height;
+    copy->format = frame.format;
+    copy->stream = frame.stream;
+    copy->rotation = frame.rotation;
+    copy->timestampNs = frame.timestampNs;
+    copy->acquiredNs = frame.acquiredNs;
+    // The source's result table may be gone by the time the copy is read.
+    copy->capture = frame.captureResult();
+    copy->planeCount = planeCount;
+    for (int i = 0; i < planeCount; ++i) {
+        const FramePlane& plane = frame.planes[i];
+        const Span& span = spans[spanOf[i]];
+        copy->planes[i] = plane;
+        copy->planes[i].data = data + span.offset + (plane.data - span.begin);
+    }
+    return copy;
+}
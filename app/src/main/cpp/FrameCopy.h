@@ -0,0 +1,14 @@
+#pragma once
+#include "BufferPool.h"
+#include "FrameHandle.h"
+
+// Deep copy of a frame into one pooled buffer, for consumers that hold frames
+// longer than the source's few buffers allow (a recorder, a slow stage). The
+// source frame can be released as soon as this returns. Planes that share
+// memory, like interleaved chroma, still share it in the copy, with the same
+// strides. The copy carries the capture result as far as it is known, but no
+// hardware buffer.
+//
+// Returns an empty handle if `frames` has no free slot or no buffer could be
+// had; nothing is allocated from the heap once `buffers` has warmed up.
+FrameHandle copyFrame(const Frame& frame, FramePool& frames, BufferPool& buffers);
@@ -0,0 +1,94 @@
+#include "FrameHandle.h"
+#include <algorithm>
+
+FrameHandle::FrameHandle(const FrameHandle& other) : frame_(other.frame_) {
+    if (frame_) frame_->refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept : frame_(other.frame_) {
+    other.frame_ = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other) {
+    if (this != &other) {
+        FrameHandle copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept {
+    if (this != &other) {
+        reset();
+        frame_ = other.frame_;
+        other.frame_ = nullptr;
+    }
+    return *this;
+}
+
+FrameHandle::~FrameHandle() {
+    reset();
+}
+
+void FrameHandle::reset() {
+    Frame* frame = frame_;
+    frame_ = nullptr;
+    if (frame && frame->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        frame->pool_->recycle(frame);
+    }
+}
+
+FramePool::FramePool(int capacity)
+    : capacity_(std::clamp(capacity, 1, kMaxFrames)),
+      frames_(new Frame[capacity_]) {
+    for (int i = 0; i < capacity_; ++i) {
+        frames_[i].pool_ = this;
+        frames_[i].slot_ = i;
+    }
+}
+
+FrameHandle FramePool::acquire(void* owner, ReleaseFn release) {
+    const uint32_t full = capacity_ == 32 ? ~0u : (1u << capacity_) - 1;
+    uint32_t used = used_.load(std::memory_order_relaxed);
+    int slot;
+    do {
+        if ((used & full) == full) {
+            exhausted_.fetch_add(1, std::memory_order_relaxed);
+            return {};
+        }
+        slot = __builtin_ctz(~used);
+    } while (!used_.compare_exchange_weak(used, used | (1u << slot),
+                                          std::memory_order_acquire, std::memory_order_relaxed));
+
+    Frame* frame = &frames_[slot];
+    frame->owner_ = owner;
+    frame->release_ = release;
+    frame->refs_.store(1, std::memory_order_relaxed);
+
+    int now = inFlight_.fetch_add(1, std::memory_order_relaxed) + 1;
+    int peak = peakInFlight_.load(std::memory_order_relaxed);
+    while (now > peak && !peakInFlight_.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    return FrameHandle(frame);
+}
+
+CaptureResultInfo Frame::captureResult() const {
+    CaptureResultInfo result = capture;
+    if (!result.complete() && captureResults) captureResults->find(timestampNs, result);
+    return result;
+}
+
+void FramePool::recycle(Frame* frame) {
+    if (frame->release_) frame->release_(frame->owner_);
+    frame->owner_ = nullptr;
+    frame->release_ = nullptr;
+    frame->width = frame->height = frame->format = frame->stream = frame->rotation = 0;
+    frame->timestampNs = frame->acquiredNs = 0;
+    frame->planeCount = 0;
+    for (FramePlane& plane : frame->planes) plane = FramePlane{};
+    frame->hardwareBuffer = nullptr;
+    frame->capture = CaptureResultInfo{};
+    frame->captureResults = nullptr;
+
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    used_.fetch_and(~(1u << frame->slot_), std::memory_order_release);
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "CaptureResult.h"
+
+// A camera frame whose pixel memory belongs to someone else: an AImage on
+// device, a fake buffer on host. The pixels stay valid for as long as any
+// FrameHandle refers to the frame; the owner is released with the last one.
+
+class FramePool;
+
+struct FramePlane {
+    const uint8_t* data = nullptr;
+    int length = 0;
+    int rowStride = 0;
+    int pixelStride = 0;
+};
+
+struct Frame {
+    static constexpr int kMaxPlanes = 3;
+
+    int width = 0;
+    int height = 0;
+    int format = 0;
+    int stream = 0;           // index of the source stream that produced it
+    int rotation = 0;         // clockwise degrees that turn the image upright on the display
+    int64_t timestampNs = 0;  // sensor timestamp
+    int64_t acquiredNs = 0;   // monotonicNowNs() when the source took the image
+    int planeCount = 0;
+    FramePlane planes[kMaxPlanes];
+    // GPU-sampleable buffer behind the planes (an AHardwareBuffer on device),
+    // if the stream asked for one. Same pointer for every frame that reuses
+    // the buffer.
+    void* hardwareBuffer = nullptr;
+    // The capture's result metadata as far as it had arrived when the source
+    // took the image. On device the result usually trails the image by a few
+    // milliseconds, so this is often still empty.
+    CaptureResultInfo capture;
+    // Where the rest shows up; set by sources that join results later.
+    const CaptureResultTable* captureResults = nullptr;
+
+    // `capture`, completed from captureResults if the full result has come
+    // in since. Never allocates or blocks.
+    CaptureResultInfo captureResult() const;
+
+private:
+    friend class FrameHandle;
+    friend class FramePool;
+
+    std::atomic<int> refs_{0};
+    FramePool* pool_ = nullptr;
+    int slot_ = -1;
+    void* owner_ = nullptr;
+    void (*release_)(void* owner) = nullptr;
+};
+
+class FrameHandle {
+public:
+    FrameHandle() = default;
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(const FrameHandle& other);
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+    ~FrameHandle();
+
+    Frame* get() const { return frame_; }
+    Frame* operator->() const { return frame_; }
+    Frame& operator*() const { return *frame_; }
+    explicit operator bool() const { return frame_ != nullptr; }
+
+    // Drops this reference; releases the owner if it was the last one.
+    void reset();
+
+private:
+    friend class FramePool;
+    explicit FrameHandle(Frame* frame) : frame_(frame) {}
+
+    Frame* frame_ = nullptr;
+};
+
+// Fixed set of frame slots, sized to the number of images the reader can hand
+// out at once. Acquiring and releasing a slot never allocates or locks.
+class FramePool {
+public:
+    using ReleaseFn = void (*)(void* owner);
+    static constexpr int kMaxFrames = 32;
+
+    explicit FramePool(int capacity);
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Wraps `owner` in a fresh frame. Returns an empty handle when every slot
+    // is in flight, in which case the caller still owns `owner`.
+    FrameHandle acquire(void* owner, ReleaseFn release);
+
+    int capacity() const { return capacity_; }
+    int inFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+    int peakInFlight() const { return peakInFlight_.load(std::memory_order_relaxed); }
+    uint64_t exhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+
+private:
+    friend class FrameHandle;
+    void recycle(Frame* frame);
+
+    int capacity_;
+    std::unique_ptr<Frame[]> frames_;
+    std::atomic<uint32_t> used_{0};
+    std::atomic<int> inFlight_{0};
+    std::atomic<int> peakInFlight_{0};
+    std::atomic<uint64_t> exhausted_{0};
+};
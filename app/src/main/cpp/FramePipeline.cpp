@@ -0,0 +1,99 @@
+#define LOG_TAG "FramePipeline"
+
+#include "FramePipeline.h"
+#include "FrameTrace.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+
+void FramePipeline::start() {
+    if (running_) return;
+    stats_.reset();
+    ring_.reopen();
+    droppedBefore_ = ring_.droppedOldest() + ring_.skipped();
+    if (vsync_) vsync_->start();
+    running_ = true;
+    thread_ = std::thread(&FramePipeline::run, this);
+}
+
+void FramePipeline::stop() {
+    running_ = false;
+    ring_.close();
+    if (vsync_) vsync_->stop();
+    if (thread_.joinable()) thread_.join();
+    ring_.clear();
+}
+
+void FramePipeline::submit(FrameHandle frame) {
+    FrameTrace::record(TraceStage::Enqueue, frame->timestampNs);
+    ring_.publish(std::move(frame));
+}
+
+void FramePipeline::run() {
+    if (!backend_.attach()) {
+        LOGE("RenderBackend attach failed, render thread exiting");
+        return;
+    }
+    int64_t resultFrameNs = -1;  // source frame of the result being drawn
+    int64_t lastFrameNumber = -1;
+    while (running_) {
+        if (!ring_.wait()) break;
+        // Frames that arrive while we wait for the vsync replace this one.
+        // 0 from a source that never ticks means draw unpaced.
+        const int64_t vsyncNs = vsync_ ? vsync_->waitNext() : 0;
+        if (vsyncNs < 0) break;
+        FrameHandle frame;
+        if (!ring_.consumeLatest(frame)) continue;
+
+        int64_t dequeuedNs = monotonicNowNs();
+        int64_t acquiredNs = frame->acquiredNs;
+        int64_t frameId = frame->timestampNs;
+        backend_.upload(frame);
+        int64_t uploadedNs = monotonicNowNs();
+        // Looked up after the upload, which gives a trailing result time to land.
+        const CaptureResultInfo capture = frame->captureResult();
+        // Unless the backend kept its own reference to sample the buffer in
+        // place, the image goes back to the source before we draw.
+        frame.reset();
+
+        if (results_ && results_->update()) {
+            resultFrameNs = results_->read().frameTimestampNs;
+            backend_.onInferenceResult(results_->read());
+        }
+        backend_.draw();
+        int64_t drawnNs = monotonicNowNs();
+        backend_.present();
+        int64_t presentedNs = monotonicNowNs();
+
+        if (FrameTrace::enabled()) {
+            FrameTrace::record(TraceStage::Dequeue, frameId, dequeuedNs);
+            FrameTrace::record(TraceStage::Upload, frameId, uploadedNs);
+            FrameTrace::record(TraceStage::Draw, frameId, drawnNs);
+            FrameTrace::record(TraceStage::Swap, frameId, presentedNs);
+        }
+        stats_[PipelineStage::Queue].add(dequeuedNs - acquiredNs);
+        stats_[PipelineStage::Upload].add(uploadedNs - dequeuedNs);
+        stats_.uploadWait.add(backend_.lastUploadWaitNs());
+        stats_[PipelineStage::Draw].add(drawnNs - uploadedNs);
+        stats_[PipelineStage::Present].add(presentedNs - drawnNs);
+        stats_[PipelineStage::Total].add(presentedNs - acquiredNs);
+        if (resultFrameNs >= 0) stats_.resultStaleness.add(frameId - resultFrameNs);
+        if (capture.complete()) stats_.frameDuration.add(capture.frameDurationNs);
+        if (capture.frameNumber >= 0) {
+            if (lastFrameNumber >= 0 && capture.frameNumber > lastFrameNumber) {
+                stats_.captureGaps += uint64_t(capture.frameNumber - lastFrameNumber - 1);
+            }
+            lastFrameNumber = capture.frameNumber;
+        }
+        // Frame time as the user sees it: present to present.
+        if (stats_.presented++ == 0) stats_.firstPresentNs = presentedNs;
+        else stats_.frameInterval.add(presentedNs - stats_.lastPresentNs);
+        stats_.lastPresentNs = presentedNs;
+        if (vsyncNs > 0) {
+            stats_.vsyncLatency.add(presentedNs - vsyncNs);
+            const int64_t periodNs = vsync_->periodNs();
+            if (periodNs > 0 && presentedNs - vsyncNs > periodNs) ++stats_.lateFrames;
+        }
+    }
+    stats_.dropped = ring_.droppedOldest() + ring_.skipped() - droppedBefore_;
+    backend_.detach();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include "FrameHandle.h"
+#include "FrameRing.h"
+#include "InferenceStage.h"
+#include "PipelineStats.h"
+#include "RenderBackend.h"
+#include "VsyncSource.h"
+
+// Consumer half of the preview path: frames submitted from the source thread
+// go through a small latest-wins ring to a render thread that uploads, draws
+// and presents them through a RenderBackend.
+//
+// Unpaced, the render thread draws every frame as soon as it arrives. With a
+// VsyncSource it waits for the next vsync once a frame is ready and then
+// draws the newest one, so at most one frame is presented per refresh and
+// frames that were overtaken before the vsync are dropped, not queued.
+class FramePipeline {
+public:
+    using Ring = FrameRing<FrameHandle, 2>;
+
+    explicit FramePipeline(RenderBackend& backend) : backend_(backend) {}
+    ~FramePipeline() { stop(); }
+
+    void start();
+    void stop();
+
+    // Called on the source thread; never blocks.
+    void submit(FrameHandle frame);
+
+    // Results to hand to the backend as they arrive. Set before start().
+    void setInferenceResults(InferenceResults* results) { results_ = results; }
+
+    // Paces presentation to `vsync`, which the pipeline starts and stops with
+    // itself; nullptr to present as frames arrive. Set before start().
+    void setVsync(VsyncSource* vsync) { vsync_ = vsync; }
+
+    // Only stable once stop() has returned.
+    const PipelineStats& stats() const { return stats_; }
+    const Ring& ring() const { return ring_; }
+
+private:
+    void run();
+
+    RenderBackend& backend_;
+    Ring ring_{OverflowPolicy::DropOldest};
+    InferenceResults* results_ = nullptr;
+    VsyncSource* vsync_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    uint64_t droppedBefore_ = 0;  // ring counters run across restarts
+    PipelineStats stats_;
+};
@@ -0,0 +1,164 @@
+#define LOG_TAG "FrameRecorder"
+
+#include "FrameRecorder.h"
+#include "FrameCopy.h"
+#include "Log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool FrameRecorder::open(const char* path) {
+    close();
+    fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOGE("open %s: %s", path, strerror(errno));
+        return false;
+    }
+    path_ = path;
+    used_ = 0;
+    failed_ = false;
+    index_.clear();
+    recorded_ = 0;
+    dropped_ = 0;
+    if (!reserve(sizeof(RecordingHeader))) {
+        close();
+        return false;
+    }
+    RecordingHeader header = {};
+    std::memcpy(header.magic, RecordingHeader::kMagic, sizeof(header.magic));
+    header.version = RecordingHeader::kVersion;
+    std::memcpy(map_, &header, sizeof(header));
+    used_ = sizeof(header);
+
+    queue_.reopen();
+    thread_ = std::thread(&FrameRecorder::run, this);
+    LOGI("Recording frames to %s", path);
+    return true;
+}
+
+bool FrameRecorder::record(const Frame& frame) {
+    if (fd_ < 0) return false;
+    FrameHandle copy = copyFrame(frame, copies_, buffers_);
+    if (!copy) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // The camera's result table outlives the recording, so the writer can
+    // still pick up results that arrive after the image.
+    copy->captureResults = frame.captureResults;
+    if (!queue_.publish(std::move(copy))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void FrameRecorder::close() {
+    if (fd_ < 0) return;
+    queue_.close();
+    if (thread_.joinable()) thread_.join();
+    finish();
+    LOGI("Recorded %llu frames (%.1f MiB) to %s, %llu dropped", (unsigned long long)recorded(),
+         used_ / (1024.0 * 1024.0), path_.c_str(), (unsigned long long)dropped());
+}
+
+void FrameRecorder::run() {
+    FrameHandle frame;
+    for (;;) {
+        if (!queue_.consume(frame)) {
+            if (!queue_.wait()) break;
+            continue;
+        }
+        if (!failed_) append(*frame);
+        frame.reset();
+    }
+}
+
+bool FrameRecorder::reserve(size_t bytes) {
+    if (used_ + bytes <= mapped_) return true;
+    const size_t size = std::max(mapped_ + kGrowBytes, recordingAlign(used_ + bytes));
+    if (ftruncate(fd_, off_t(size)) != 0) {
+        LOGE("Growing %s to %zu bytes: %s", path_.c_str(), size, strerror(errno));
+        return false;
+    }
+    if (map_) munmap(map_, mapped_);
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        LOGE("mmap %zu bytes of %s: %s", size, path_.c_str(), strerror(errno));
+        map_ = nullptr;
+        mapped_ = 0;
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    mapped_ = size;
+    return true;
+}
+
+void FrameRecorder::append(const Frame& frame) {
+    // The copy's planes all live in one buffer; take it whole, padding and all.
+    const int planeCount = std::min(frame.planeCount, Frame::kMaxPlanes);
+    const uint8_t* begin = nullptr;
+    const uint8_t* end = nullptr;
+    for (int p = 0; p < planeCount; ++p) {
+        const FramePlane& plane = frame.planes[p];
+        if (!begin || plane.data < begin) begin = plane.data;
+        if (!end || plane.data + plane.length > end) end = plane.data + plane.length;
+    }
+    const size_t dataBytes = size_t(end - begin);
+    const size_t recordBytes = recordingAlign(sizeof(RecordedFrame) + dataBytes);
+    if (!reserve(recordBytes)) {
+        failed_ = true;
+        return;
+    }
+
+    const CaptureResultInfo capture = frame.captureResult();
+    RecordedFrame record = {};
+    record.magic = RecordedFrame::kMagic;
+    record.dataBytes = uint32_t(dataBytes);
+    record.width = frame.width;
+    record.height = frame.height;
+    record.format = frame.format;
+    record.stream = frame.stream;
+    record.rotation = frame.rotation;
+    record.planeCount = planeCount;
+    record.timestampNs = frame.timestampNs;
+    record.acquiredNs = frame.acquiredNs;
+    record.frameNumber = capture.frameNumber;
+    record.frameDurationNs = capture.frameDurationNs;
+    record.exposureTimeNs = capture.exposureTimeNs;
+    record.sensitivity = capture.sensitivity;
+    for (int p = 0; p < planeCount; ++p) {
+        const FramePlane& plane = frame.planes[p];
+        record.planes[p] = RecordedPlane{uint32_t(plane.data - begin), plane.length, plane.rowStride, plane.pixelStride};
+    }
+    uint8_t* out = map_ + used_;
+    std::memcpy(out, &record, sizeof(record));
+    std::memcpy(out + sizeof(record), begin, dataBytes);
+    index_.push_back(RecordingIndexEntry{uint64_t(used_), frame.timestampNs});
+    used_ += recordBytes;
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameRecorder::finish() {
+    if (map_ && !failed_) {
+        const size_t indexBytes = index_.size() * sizeof(RecordingIndexEntry);
+        if (reserve(indexBytes)) {
+            if (indexBytes) std::memcpy(map_ + used_, index_.data(), indexBytes);
+            RecordingHeader header;
+            std::memcpy(&header, map_, sizeof(header));
+            header.frameCount = index_.size();
+            header.indexOffset = used_;
+            std::memcpy(map_, &header, sizeof(header));
+            used_ += indexBytes;
+        }
+    }
+    if (map_) munmap(map_, mapped_);
+    map_ = nullptr;
+    mapped_ = 0;
+    if (ftruncate(fd_, off_t(used_)) != 0) LOGE("Trimming %s: %s", path_.c_str(), strerror(errno));
+    ::close(fd_);
+    fd_ = -1;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BufferPool.h"
+#include "FrameHandle.h"
+#include "FrameRecording.h"
+#include "FrameRing.h"
+
+// Records the frames a stream delivers, pixels, strides, timestamps and
+// capture results, into a FrameRecording container for replay on a host.
+//
+// record() runs on the source's callback thread and only copies the frame
+// into pooled memory and queues it, so the camera buffer goes straight back.
+// A writer thread appends the copies to the file through a shared mapping
+// that grows in kGrowBytes steps. If the writer falls behind, frames are
+// dropped (and counted) rather than stalling the camera.
+class FrameRecorder {
+public:
+    static constexpr size_t kGrowBytes = size_t(64) << 20;
+
+    FrameRecorder() = default;
+    ~FrameRecorder() { close(); }
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // Truncates `path`. Logs and returns false on failure.
+    bool open(const char* path);
+    // One producer thread at a time. False if the frame was dropped.
+    bool record(const Frame& frame);
+    // Writes what is queued, then the index, and trims the file. Call once
+    // the source has stopped calling record().
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t bytes() const { return used_; }  // stable once closed
+
+private:
+    using Queue = FrameRing<FrameHandle, 16>;
+
+    void run();
+    bool reserve(size_t bytes);
+    void append(const Frame& frame);
+    void finish();
+
+    BufferPool buffers_;
+    FramePool copies_{int(Queue::capacity()) + 4};  // queued, being written, being copied
+    Queue queue_{OverflowPolicy::DropNewest};
+    std::thread thread_;
+    std::string path_;
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t mapped_ = 0;
+    size_t used_ = 0;
+    bool failed_ = false;  // writer only
+    std::vector<RecordingIndexEntry> index_;
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
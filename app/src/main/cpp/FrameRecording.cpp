@@ -0,0 +1,101 @@
+#define LOG_TAG "FrameRecording"
+
+#include "FrameRecording.h"
+#include "Log.h"
+#include <cstring>
+
+std::unique_ptr<FrameRecording> FrameRecording::open(const char* path) {
+    std::unique_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file) return nullptr;
+    RecordingHeader header;
+    if (file->size() < sizeof(header)) {
+        LOGE("%s is too short to be a recording", path);
+        return nullptr;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, RecordingHeader::kMagic, sizeof(header.magic)) != 0 ||
+        header.version != RecordingHeader::kVersion) {
+        LOGE("%s is not a version %u frame recording", path, RecordingHeader::kVersion);
+        return nullptr;
+    }
+    std::unique_ptr<FrameRecording> recording(new FrameRecording(std::move(file)));
+    if (!recording->readIndex()) {
+        recording->scan();
+        LOGI("%s was not closed; recovered %zu frames", path, recording->size());
+    }
+    return recording;
+}
+
+const RecordedFrame& FrameRecording::info(size_t i) const {
+    return *reinterpret_cast<const RecordedFrame*>(file_->data() + offsets_[i]);
+}
+
+const uint8_t* FrameRecording::data(size_t i) const {
+    return reinterpret_cast<const uint8_t*>(file_->data() + offsets_[i] + sizeof(RecordedFrame));
+}
+
+void FrameRecording::describe(size_t i, Frame& frame) const {
+    const RecordedFrame& record = info(i);
+    const uint8_t* bytes = data(i);
+    frame.width = record.width;
+    frame.height = record.height;
+    frame.format = record.format;
+    frame.stream = record.stream;
+    frame.rotation = record.rotation;
+    frame.timestampNs = record.timestampNs;
+    frame.acquiredNs = record.acquiredNs;
+    frame.capture.timestampNs = record.timestampNs;
+    frame.capture.frameNumber = record.frameNumber;
+    frame.capture.frameDurationNs = record.frameDurationNs;
+    frame.capture.exposureTimeNs = record.exposureTimeNs;
+    frame.capture.sensitivity = record.sensitivity;
+    frame.planeCount = record.planeCount;
+    for (int p = 0; p < record.planeCount; ++p) {
+        const RecordedPlane& plane = record.planes[p];
+        frame.planes[p] = FramePlane{bytes + plane.offset, plane.length, plane.rowStride, plane.pixelStride};
+    }
+}
+
+bool FrameRecording::valid(uint64_t offset) const {
+    if (offset % kRecordingAlignment || offset + sizeof(RecordedFrame) > file_->size()) return false;
+    RecordedFrame record;
+    std::memcpy(&record, file_->data() + offset, sizeof(record));
+    if (record.magic != RecordedFrame::kMagic || record.planeCount < 0 || record.planeCount > Frame::kMaxPlanes) {
+        return false;
+    }
+    if (offset + sizeof(record) + record.dataBytes > file_->size()) return false;
+    for (int p = 0; p < record.planeCount; ++p) {
+        const RecordedPlane& plane = record.planes[p];
+        if (plane.length < 0 || uint64_t(plane.offset) + plane.length > record.dataBytes) return false;
+    }
+    return true;
+}
+
+bool FrameRecording::readIndex() {
+    RecordingHeader header;
+    std::memcpy(&header, file_->data(), sizeof(header));
+    if (header.indexOffset == 0) return false;
+    const uint64_t bytes = header.frameCount * sizeof(RecordingIndexEntry);
+    if (header.indexOffset + bytes > file_->size()) return false;
+    offsets_.resize(header.frameCount);
+    for (uint64_t i = 0; i < header.frameCount; ++i) {
+        RecordingIndexEntry entry;
+        std::memcpy(&entry, file_->data() + header.indexOffset + i * sizeof(entry), sizeof(entry));
+        if (!valid(entry.offset)) {
+            offsets_.clear();
+            return false;
+        }
+        offsets_[i] = entry.offset;
+    }
+    indexed_ = true;
+    return true;
+}
+
+void FrameRecording::scan() {
+    offsets_.clear();
+    uint64_t offset = sizeof(RecordingHeader);
+    while (valid(offset)) {
+        offsets_.push_back(offset);
+        offset += recordingAlign(sizeof(RecordedFrame) + info(offsets_.size() - 1).dataBytes);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FrameHandle.h"
+#include "MappedFile.h"
+
+// Container for recorded camera frames, written by FrameRecorder and read
+// back by FrameRecording. Native byte order, every record 64-byte aligned so
+// plane data can be used in place from a mapping:
+//
+//   RecordingHeader
+//   RecordedFrame, then its bytes     once per frame, in arrival order
+//   RecordingIndexEntry[frameCount]   written on close
+//
+// A frame's bytes are laid out as copyFrame() lays them out: planes that
+// share memory (interleaved chroma) share it in the file too, with the
+// original strides. A recording that was never closed has no index; the
+// reader rebuilds one by walking the records.
+
+struct RecordingHeader {
+    static constexpr char kMagic[8] = {'F', 'R', 'A', 'M', 'E', 'R', 'E', 'C'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    uint64_t frameCount;   // 0 until closed
+    uint64_t indexOffset;  // 0 until closed
+    uint8_t reserved[32];
+};
+static_assert(sizeof(RecordingHeader) == 64, "header is one cache line");
+
+struct RecordedPlane {
+    uint32_t offset;  // from the start of the frame's bytes
+    int32_t length;
+    int32_t rowStride;
+    int32_t pixelStride;
+};
+
+struct RecordedFrame {
+    static constexpr uint32_t kMagic = 0x314d5246;  // "FRM1"
+
+    uint32_t magic;
+    uint32_t dataBytes;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    int32_t stream;
+    int32_t rotation;
+    int32_t planeCount;
+    int64_t timestampNs;  // sensor timestamp
+    int64_t acquiredNs;
+    int64_t frameNumber;
+    int64_t frameDurationNs;
+    int64_t exposureTimeNs;
+    int32_t sensitivity;
+    int32_t reserved0;
+    RecordedPlane planes[Frame::kMaxPlanes];
+};
+static_assert(sizeof(RecordedFrame) == 128, "frame records keep the data 64-byte aligned");
+
+struct RecordingIndexEntry {
+    uint64_t offset;  // of the RecordedFrame
+    int64_t timestampNs;
+};
+
+constexpr size_t kRecordingAlignment = 64;
+
+inline size_t recordingAlign(size_t bytes) { return (bytes + kRecordingAlignment - 1) & ~(kRecordingAlignment - 1); }
+
+// Read side: maps a recording and hands out its frames without copying.
+class FrameRecording {
+public:
+    // Returns nullptr (and logs why) if the file is not a recording.
+    static std::unique_ptr<FrameRecording> open(const char* path);
+
+    size_t size() const { return offsets_.size(); }
+    // False if the recorder never closed it and the index was rebuilt.
+    bool indexed() const { return indexed_; }
+    const RecordedFrame& info(size_t i) const;
+    const uint8_t* data(size_t i) const;
+    // Fills in everything but the pool bookkeeping, with the planes pointing
+    // into the mapping; valid while the recording is.
+    void describe(size_t i, Frame& frame) const;
+
+private:
+    explicit FrameRecording(std::unique_ptr<MappedFile> file) : file_(std::move(file)) {}
+    bool readIndex();
+    void scan();
+    bool valid(uint64_t offset) const;
+
+    std::unique_ptr<MappedFile> file_;
+    std::vector<uint64_t> offsets_;
+    bool indexed_ = false;
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "FrameSignal.h"
+
+// What publish() does when the ring is full.
+enum class OverflowPolicy {
+    DropOldest,  // evict the oldest queued item to make room (latest frame wins)
+    DropNewest,  // discard the item being published
+    Block,       // wait for the consumer to make room
+};
+
+// Fixed-capacity single-producer/single-consumer ring. Slots are allocated
+// once with the ring; publishing and consuming only move values in and out.
+//
+// With DropOldest the producer evicts through the same claim the consumer
+// uses (a CAS on head_), so both sides stay lock-free. publish() is bounded
+// by Capacity steps for the two drop policies: if the consumer is still
+// moving out of the one slot the producer needs, the new item is dropped
+// instead of waiting.
+template <typename T, size_t Capacity>
+class FrameRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "FrameRing capacity must be a power of two");
+
+public:
+    explicit FrameRing(OverflowPolicy policy = OverflowPolicy::DropOldest) : policy_(policy) {
+        for (size_t i = 0; i < Capacity; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Producer side. Returns false if `value` (not an older item) was dropped.
+    bool publish(T&& value) {
+        if (closed_.load(std::memory_order_acquire)) {
+            droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!tryPush(value)) {
+            switch (policy_) {
+                case OverflowPolicy::DropNewest:
+                    droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case OverflowPolicy::DropOldest: {
+                    T evicted;
+                    if (tryPop(evicted)) droppedOldest_.fetch_add(1, std::memory_order_relaxed);
+                    if (!tryPush(value)) {
+                        droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    break;
+                }
+                case OverflowPolicy::Block:
+                    for (;;) {
+                        uint32_t seen = space_.prepare();
+                        if (tryPush(value)) break;
+                        if (closed_.load(std::memory_order_acquire)) {
+                            droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                            return false;
+                        }
+                        space_.wait(seen);
+                    }
+                    break;
+            }
+        }
+        published_.fetch_add(1, std::memory_order_relaxed);
+        data_.notify();
+        return true;
+    }
+
+    // Consumer side: takes the oldest queued item.
+    bool consume(T& out) {
+        if (!tryPop(out)) return false;
+        if (policy_ == OverflowPolicy::Block) space_.notify();
+        return true;
+    }
+
+    // Consumer side: takes the newest queued item and discards the rest.
+    bool consumeLatest(T& out) {
+        if (!consume(out)) return false;
+        T newer;
+        while (consume(newer)) {
+            out = std::move(newer);
+            skipped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer side: sleeps until an item is queued or the ring is closed.
+    // Returns false on close or timeout (negative = wait forever).
+    bool wait(int64_t timeoutNs = -1) {
+        for (;;) {
+            uint32_t seen = data_.prepare();
+            if (!empty()) return true;
+            if (closed_.load(std::memory_order_acquire)) return false;
+            data_.wait(seen, timeoutNs);
+            if (timeoutNs >= 0) return !empty();
+        }
+    }
+
+    // Wakes both sides and rejects further items until reopen().
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        data_.notify();
+        space_.notify();
+    }
+    void reopen() { closed_.store(false, std::memory_order_release); }
+
+    // Destroys every queued item. Only call while the producer is quiet.
+    void clear() {
+        T item;
+        while (tryPop(item)) item = T();
+    }
+
+    bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    static constexpr size_t capacity() { return Capacity; }
+    OverflowPolicy policy() const { return policy_; }
+
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t droppedOldest() const { return droppedOldest_.load(std::memory_order_relaxed); }
+    uint64_t droppedNewest() const { return droppedNewest_.load(std::memory_order_relaxed); }
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq{0};
+        T value{};
+    };
+
+    // Only the producer calls this; a slot is free once its seq equals pos.
+    bool tryPush(T& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & kMask];
+        if (slot.seq.load(std::memory_order_acquire) != pos) return false;
+        slot.value = std::move(value);
+        slot.seq.store(pos + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Called by the consumer, and by the producer when evicting.
+    bool tryPop(T& out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & kMask];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff < 0) return false;
+            if (diff > 0) {
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                out = std::move(slot.value);
+                slot.value = T();
+                slot.seq.store(pos + Capacity, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    const OverflowPolicy policy_;
+    Slot slots_[Capacity];
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::atomic<bool> closed_{false};
+    FrameSignal data_;
+    FrameSignal space_;
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> droppedOldest_{0};
+    std::atomic<uint64_t> droppedNewest_{0};
+    std::atomic<uint64_t> skipped_{0};
+};
@@ -0,0 +1,32 @@
+#include "FrameSignal.h"
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+void FrameSignal::wait(uint32_t seen, int64_t timeoutNs) {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    if (epoch_.load(std::memory_order_seq_cst) == seen) {
+        timespec timeout{};
+        timespec* timeoutPtr = nullptr;
+        if (timeoutNs >= 0) {
+            timeout.tv_sec = static_cast<time_t>(timeoutNs / 1000000000);
+            timeout.tv_nsec = static_cast<long>(timeoutNs % 1000000000);
+            timeoutPtr = &timeout;
+        }
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, seen,
+                timeoutPtr, nullptr, 0);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FrameSignal::notify() {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) != 0) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX,
+                nullptr, nullptr, 0);
+    }
+}
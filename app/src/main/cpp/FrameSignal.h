@@ -0,0 +1,22 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lets one thread sleep until another reports progress. notify() never takes
+// a lock and only enters the kernel when somebody is actually asleep, which
+// keeps it safe to call from the camera callback thread.
+class FrameSignal {
+public:
+    // Snapshot to pass to wait(); take it before re-checking the condition.
+    uint32_t prepare() const { return epoch_.load(std::memory_order_seq_cst); }
+
+    // Sleeps until notify() is called after `seen` was taken, or the timeout
+    // (negative = none) expires.
+    void wait(uint32_t seen, int64_t timeoutNs = -1);
+
+    void notify();
+
+private:
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> waiters_{0};
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "CaptureControls.h"
+#include "CaptureResult.h"
+#include "FrameHandle.h"
+
+// AIMAGE_FORMAT_YUV_420_888, the only format the pipeline consumes.
+constexpr int kFormatYuv420 = 0x23;
+
+struct StreamConfig {
+    int width = 640;
+    int height = 480;
+    int format = kFormatYuv420;
+    int maxImages = 4;  // buffers the source may have in flight at once
+    // Allocate buffers the GPU can sample in place and expose them through
+    // Frame::hardwareBuffer. The planes stay CPU-readable either way.
+    bool gpuSampled = false;
+};
+
+using FrameCallback = std::function<void(FrameHandle)>;
+
+// One output of the capture session, with its own buffers and callback.
+// Every capture fills all streams, so frames of the same capture carry the
+// same timestampNs on every stream.
+struct StreamRequest {
+    StreamConfig config;
+    FrameCallback onFrame;
+};
+
+// Something that produces camera frames: NativeCamera on device,
+// SyntheticFrameSource on a Linux host. Frames are delivered on the
+// source's own thread(s), tagged with the index of their stream.
+class FrameSource {
+public:
+    using FrameCallback = ::FrameCallback;
+
+    virtual ~FrameSource() = default;
+    // Opens one stream per request, e.g. a preview-sized stream for display
+    // and a small one sized for the model, so neither has to be rescaled in
+    // software.
+    virtual bool open(const std::vector<StreamRequest>& streams) = 0;
+    virtual void close() = 0;
+
+    // Updates the controls of the running capture without reopening
+    // anything; they also apply to the next open(). Returns what the source
+    // will actually run (see resolveControls()).
+    virtual CaptureControls setControls(const CaptureControls& controls) = 0;
+    // What the most recent capture ran with; zeros until one completes.
+    // Any thread.
+    virtual CaptureResultInfo lastCapture() const = 0;
+
+    // True once the open source has stopped delivering for good, e.g. the
+    // camera was taken by another app or hit a device error; only a new
+    // open() brings it back. Any thread.
+    bool lost() const { return lost_.load(std::memory_order_acquire); }
+
+    bool open(const StreamConfig& config, FrameCallback cb) { return open({StreamRequest{config, std::move(cb)}}); }
+
+protected:
+    // From the source's own threads; open() clears it.
+    void setLost(bool lost) { lost_.store(lost, std::memory_order_release); }
+
+private:
+    std::atomic<bool> lost_{false};
+};
@@ -0,0 +1,255 @@
+#define LOG_TAG "FrameTrace"
+
+#include "FrameTrace.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kMaxThreads = 32;
+constexpr int kMaxNamedThreads = 128;
+constexpr uint64_t kCapacity = FrameTrace::kEventsPerThread;
+static_assert((kCapacity & (kCapacity - 1)) == 0, "kEventsPerThread must be a power of two");
+
+// Each record carries its thread: a buffer outlives the thread that filled
+// it and keeps its events when the next thread takes it over.
+struct Record {
+    std::atomic<int64_t> frameId{0};
+    std::atomic<int64_t> timeNs{0};
+    std::atomic<int32_t> tid{0};
+    std::atomic<uint8_t> stage{0};
+};
+
+struct ThreadBuffer {
+    std::atomic<bool> owned{false};
+    std::atomic<uint64_t> written{0};
+    int32_t tid = 0;  // the owner's
+    Record records[kCapacity];
+};
+
+struct ThreadName {
+    int32_t tid;
+    char name[16];
+};
+
+std::atomic<bool> gEnabled{false};
+std::unique_ptr<ThreadBuffer> gBuffers[kMaxThreads];
+std::atomic<int> gBufferCount{0};
+// Every thread that has recorded, for the trace's thread names. Threads past
+// the table's end show up by tid alone.
+ThreadName gNames[kMaxNamedThreads];
+std::atomic<int> gNameCount{0};
+// Guards appending to gBuffers and gNames, which happens once per thread,
+// never from record()'s steady state, so a spin lock is fine.
+std::atomic<bool> gAppending{false};
+
+// Hands the buffer back for reuse when its thread exits; the render thread is
+// recreated with every window, so buffers would otherwise run out.
+struct ThreadSlot {
+    ThreadBuffer* buffer = nullptr;
+    bool exhausted = false;
+    ~ThreadSlot() {
+        if (buffer) buffer->owned.store(false, std::memory_order_release);
+    }
+};
+thread_local ThreadSlot tSlot;
+
+ThreadBuffer* claimBuffer() {
+    int count = gBufferCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        bool expected = false;
+        if (gBuffers[i]->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return gBuffers[i].get();
+    }
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->owned.store(true, std::memory_order_relaxed);
+    ThreadBuffer* raw = nullptr;
+    while (gAppending.exchange(true, std::memory_order_acquire)) {}
+    int index = gBufferCount.load(std::memory_order_relaxed);
+    if (index < kMaxThreads) {
+        raw = buffer.get();
+        gBuffers[index] = std::move(buffer);
+        gBufferCount.store(index + 1, std::memory_order_release);
+    }
+    gAppending.store(false, std::memory_order_release);
+    return raw;
+}
+
+void addThreadName(int32_t tid) {
+    while (gAppending.exchange(true, std::memory_order_acquire)) {}
+    int index = gNameCount.load(std::memory_order_relaxed);
+    if (index < kMaxNamedThreads) {
+        gNames[index].tid = tid;
+        prctl(PR_GET_NAME, gNames[index].name);
+        gNameCount.store(index + 1, std::memory_order_release);
+    }
+    gAppending.store(false, std::memory_order_release);
+}
+
+ThreadBuffer* threadBuffer() {
+    if (tSlot.buffer || tSlot.exhausted) return tSlot.buffer;
+    ThreadBuffer* buffer = claimBuffer();
+    if (!buffer) {
+        tSlot.exhausted = true;
+        return nullptr;
+    }
+    buffer->tid = int32_t(syscall(SYS_gettid));
+    addThreadName(buffer->tid);
+    tSlot.buffer = buffer;
+    return buffer;
+}
+
+}  // namespace
+
+const char* traceStageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::Acquire: return "acquire";
+        case TraceStage::Enqueue: return "enqueue";
+        case TraceStage::Dequeue: return "dequeue";
+        case TraceStage::Upload: return "upload";
+        case TraceStage::Draw: return "draw";
+        case TraceStage::Swap: return "swap";
+        default: return "?";
+    }
+}
+
+void FrameTrace::setEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool FrameTrace::enabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void FrameTrace::record(TraceStage stage, int64_t frameId, int64_t timeNs) {
+    if (!enabled()) return;
+    ThreadBuffer* buffer = threadBuffer();
+    if (!buffer) return;
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    Record& record = buffer->records[index & (kCapacity - 1)];
+    record.frameId.store(frameId, std::memory_order_relaxed);
+    record.timeNs.store(timeNs, std::memory_order_relaxed);
+    record.tid.store(buffer->tid, std::memory_order_relaxed);
+    record.stage.store(uint8_t(stage), std::memory_order_relaxed);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+std::vector<FrameTrace::Event> FrameTrace::snapshot() {
+    std::vector<Event> events;
+    int count = gBufferCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        ThreadBuffer& buffer = *gBuffers[i];
+        uint64_t end = buffer.written.load(std::memory_order_acquire);
+        uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+        size_t first = events.size();
+        for (uint64_t j = begin; j < end; ++j) {
+            const Record& record = buffer.records[j & (kCapacity - 1)];
+            Event event;
+            event.frameId = record.frameId.load(std::memory_order_relaxed);
+            event.timeNs = record.timeNs.load(std::memory_order_relaxed);
+            event.stage = TraceStage(record.stage.load(std::memory_order_relaxed));
+            event.tid = record.tid.load(std::memory_order_relaxed);
+            events.push_back(event);
+        }
+        // Anything the writer lapped while we copied may be torn; drop it.
+        uint64_t after = buffer.written.load(std::memory_order_acquire);
+        if (after > begin + kCapacity) {
+            uint64_t lapped = std::min<uint64_t>(after - kCapacity - begin, end - begin);
+            events.erase(events.begin() + first, events.begin() + first + lapped);
+        }
+    }
+    return events;
+}
+
+void FrameTrace::clear() {
+    int count = gBufferCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) gBuffers[i]->written.store(0, std::memory_order_release);
+}
+
+void FrameTrace::summarize(Summary& out) {
+    for (StageStats& stage : out.stages) stage.reset();
+    out.total.reset();
+    out.frames = 0;
+
+    std::vector<Event> events = snapshot();
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.frameId != b.frameId ? a.frameId < b.frameId : a.stage < b.stage;
+    });
+    for (size_t i = 0; i < events.size();) {
+        size_t j = i;
+        while (j < events.size() && events[j].frameId == events[i].frameId) ++j;
+        for (size_t k = i + 1; k < j; ++k) {
+            if (events[k].stage != events[k - 1].stage)
+                out.stages[int(events[k].stage)].add(events[k].timeNs - events[k - 1].timeNs);
+        }
+        if (events[i].stage == TraceStage::Acquire && events[j - 1].stage == TraceStage::Swap)
+            out.total.add(events[j - 1].timeNs - events[i].timeNs);
+        ++out.frames;
+        i = j;
+    }
+}
+
+void FrameTrace::logSummary() {
+    auto summary = std::make_unique<Summary>();
+    summarize(*summary);
+    LOGI("%llu frames traced", (unsigned long long)summary->frames);
+    auto line = [](const char* name, const StageStats& s) {
+        LOGI("%-8s n=%-7llu p50 %7.3f  p95 %7.3f  p99 %7.3f ms", name, (unsigned long long)s.count(),
+             s.percentileNs(50) / 1e6, s.percentileNs(95) / 1e6, s.percentileNs(99) / 1e6);
+    };
+    for (int i = 1; i < kStageCount; ++i) line(traceStageName(TraceStage(i)), summary->stages[i]);
+    line("total", summary->total);
+}
+
+bool FrameTrace::writeChromeTrace(const char* path) {
+    std::vector<Event> events = snapshot();
+    FILE* out = std::fopen(path, "w");
+    if (!out) {
+        LOGE("Cannot write trace to %s", path);
+        return false;
+    }
+    const int pid = int(getpid());
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    int count = gNameCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"name\":\"%s\"}}",
+                     first ? "" : ",\n", pid, gNames[i].tid, gNames[i].name);
+        first = false;
+    }
+
+    // Each stage becomes a slice from the frame's previous stage to this one,
+    // on the thread that reached it.
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.frameId != b.frameId ? a.frameId < b.frameId : a.stage < b.stage;
+    });
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        bool chained = i > 0 && events[i - 1].frameId == e.frameId && events[i - 1].stage < e.stage;
+        if (chained) {
+            int64_t startNs = events[i - 1].timeNs;
+            std::fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                              "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%lld}}",
+                         first ? "" : ",\n", traceStageName(e.stage), pid, e.tid, startNs / 1e3,
+                         (e.timeNs - startNs) / 1e3, (long long)e.frameId);
+        } else {
+            std::fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,"
+                              "\"tid\":%d,\"ts\":%.3f,\"args\":{\"frame\":%lld}}",
+                         first ? "" : ",\n", traceStageName(e.stage), pid, e.tid, e.timeNs / 1e3,
+                         (long long)e.frameId);
+        }
+        first = false;
+    }
+    std::fprintf(out, "\n]}\n");
+    bool ok = std::fclose(out) == 0;
+    LOGI("Wrote %zu trace events to %s", events.size(), path);
+    return ok;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MonotonicClock.h"
+#include "PipelineStats.h"
+
+// Points in a frame's life that FrameTrace timestamps. Acquire is the sensor
+// timestamp mapped onto CLOCK_MONOTONIC; the rest are taken when they happen.
+enum class TraceStage : uint8_t { Acquire, Enqueue, Dequeue, Upload, Draw, Swap, Count };
+
+const char* traceStageName(TraceStage stage);
+
+// Per-frame latency tracing. Each thread appends to its own fixed-size
+// buffer, so record() is a handful of relaxed stores: no locks, no
+// allocation after the thread's first event, nothing that can stall the
+// camera or render thread. Exporting reads the buffers from any other
+// thread while recording continues; the oldest records are overwritten
+// once a buffer wraps.
+class FrameTrace {
+public:
+    static constexpr int kStageCount = int(TraceStage::Count);
+    // Retained per recording thread; a power of two.
+    static constexpr uint64_t kEventsPerThread = 8192;
+
+    struct Event {
+        int64_t frameId = 0;  // the frame's sensor timestamp
+        int64_t timeNs = 0;
+        int32_t tid = 0;
+        TraceStage stage = TraceStage::Acquire;
+    };
+
+    static void setEnabled(bool enabled);
+    static bool enabled();
+
+    static void record(TraceStage stage, int64_t frameId, int64_t timeNs);
+    static void record(TraceStage stage, int64_t frameId) {
+        if (enabled()) record(stage, frameId, monotonicNowNs());
+    }
+
+    // Everything currently retained, oldest first within each thread.
+    static std::vector<Event> snapshot();
+    // Forgets all retained events; only call while nothing is recording.
+    static void clear();
+
+    // Stage-to-stage latency over the retained frames. stages[i] holds the
+    // time from the previous recorded stage to stage i; total is Acquire to
+    // Swap for frames that reached both.
+    struct Summary {
+        StageStats stages[kStageCount];
+        StageStats total;
+        uint64_t frames = 0;
+    };
+    static void summarize(Summary& out);
+    static void logSummary();
+
+    // Chrome trace-event JSON, which Perfetto and chrome://tracing both open.
+    static bool writeChromeTrace(const char* path);
+};
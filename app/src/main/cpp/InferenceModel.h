@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+enum class TensorType { Float32, UInt8 };
+
+// What a float model expects its pixels mapped to: (pixel - mean) * scale.
+// The default is [0, 1]; SSD and MobileNet models trained on [-1, 1] want
+// mean 127.5, scale 1/127.5. Uint8 inputs ignore it.
+struct InputNormalization {
+    float mean = 0.0f;
+    float scale = 1.0f / 255.0f;
+};
+
+// The model's (single) image input, NHWC.
+struct TensorShape {
+    int height = 0;
+    int width = 0;
+    int channels = 3;
+    TensorType type = TensorType::Float32;
+    // Float inputs get (pixel - mean) * scale; uint8 inputs take raw pixels.
+    float mean = InputNormalization().mean;
+    float scale = InputNormalization().scale;
+
+    int elements() const { return height * width * channels; }
+    int bytes() const { return elements() * (type == TensorType::Float32 ? 4 : 1); }
+};
+
+// One loaded model with its input and output tensors already allocated.
+// Not thread-safe: a model belongs to the thread that invokes it.
+class InferenceModel {
+public:
+    virtual ~InferenceModel() = default;
+
+    virtual const TensorShape& inputShape() const = 0;
+    // The input tensor's storage; stays valid for the model's lifetime.
+    virtual void* inputData() = 0;
+    virtual bool invoke() = 0;
+    // Values readOutputs() produces in all: every output tensor's elements.
+    virtual int outputValues() const = 0;
+    // Flattens every output tensor, dequantized, into dst. Returns the number
+    // of values written, at most capacity.
+    virtual int readOutputs(float* dst, int capacity) const = 0;
+};
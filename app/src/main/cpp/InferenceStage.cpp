@@ -0,0 +1,200 @@
+#define LOG_TAG "InferenceStage"
+
+#include "InferenceStage.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <algorithm>
+#include <cstdio>
+#include <sys/prctl.h>
+
+InferenceStage::InferenceStage(const std::vector<InferenceModel*>& models, DispatchPolicy policy)
+    : policy_(policy) {
+    for (InferenceModel* model : models) {
+        workers_.push_back(std::make_unique<Worker>(*model));
+        workers_.back()->pending.values.resize(size_t(std::max(0, model->outputValues())));
+    }
+}
+
+void InferenceStage::start() {
+    if (running_) return;
+    for (auto& worker : workers_) {
+        worker->preprocess.reset();
+        worker->invoke.reset();
+        worker->completed = 0;
+        worker->hasPending = false;
+        worker->runningTimestampNs = kIdle;
+        worker->ring.reopen();
+    }
+    latency_.reset();
+    submitted_ = 0;
+    started_ = 0;
+    completed_ = 0;
+    failed_ = 0;
+    discarded_ = 0;
+    sequence_ = 0;
+    lastPublishedNs_ = std::numeric_limits<int64_t>::min();
+    firstNs_ = lastNs_ = 0;
+    next_ = 0;
+    running_ = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&InferenceStage::run, this, std::ref(*workers_[i]), int(i));
+    }
+}
+
+void InferenceStage::stop() {
+    running_ = false;
+    for (auto& worker : workers_) worker->ring.close();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+        worker->ring.clear();
+    }
+}
+
+void InferenceStage::submit(FrameHandle frame) {
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    pick().ring.publish(std::move(frame));
+}
+
+InferenceStage::Worker& InferenceStage::pick() {
+    const size_t n = workers_.size();
+    size_t chosen = next_ % n;
+    if (policy_ == DispatchPolicy::LeastLoaded && n > 1) {
+        // Start the scan after the last pick so ties rotate.
+        size_t bestLoad = SIZE_MAX;
+        for (size_t k = 0; k < n; ++k) {
+            const size_t i = (next_ + k) % n;
+            const Worker& worker = *workers_[i];
+            size_t load = worker.ring.size() +
+                          (worker.runningTimestampNs.load(std::memory_order_relaxed) != kIdle ? 1 : 0);
+            if (load < bestLoad) {
+                bestLoad = load;
+                chosen = i;
+                if (load == 0) break;
+            }
+        }
+    }
+    next_ = chosen + 1;
+    return *workers_[chosen];
+}
+
+void InferenceStage::run(Worker& worker, int index) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "inference-%d", index);
+    prctl(PR_SET_NAME, name);
+
+    InferenceModel& model = worker.model;
+    const TensorShape& shape = model.inputShape();
+    void* input = model.inputData();
+
+    while (running_) {
+        if (!worker.ring.wait()) break;
+        FrameHandle frame;
+        if (!worker.ring.consumeLatest(frame)) continue;
+        const int64_t timestampNs = frame->timestampNs;
+        const int64_t acquiredNs = frame->acquiredNs;
+        const int frameWidth = frame->width;
+        const int frameHeight = frame->height;
+        worker.runningTimestampNs.store(timestampNs, std::memory_order_release);
+        started_.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t startNs = monotonicNowNs();
+        worker.preprocessor.run(*frame, shape, input);
+        const CaptureResultInfo capture = frame->captureResult();
+        // The tensor now holds everything we need from the camera buffer.
+        frame.reset();
+        int64_t preprocessedNs = monotonicNowNs();
+
+        bool ok = model.invoke();
+        int64_t invokedNs = monotonicNowNs();
+        if (!ok) failed_.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(reorderMutex_);
+        if (ok) {
+            // An older result of ours still held back is superseded.
+            if (worker.hasPending) discarded_.fetch_add(1, std::memory_order_relaxed);
+            InferenceResult& result = worker.pending;
+            result.frameTimestampNs = timestampNs;
+            result.frameAcquiredNs = acquiredNs;
+            result.capture = capture;
+            result.completedNs = invokedNs;
+            result.worker = index;
+            result.crop = worker.preprocessor.lastCrop();
+            result.frameWidth = frameWidth;
+            result.frameHeight = frameHeight;
+            result.count = model.readOutputs(result.values.data(), int(result.values.size()));
+            worker.hasPending = true;
+            worker.preprocess.add(preprocessedNs - startNs);
+            worker.invoke.add(invokedNs - preprocessedNs);
+            worker.completed.fetch_add(1, std::memory_order_relaxed);
+        }
+        worker.runningTimestampNs.store(kIdle, std::memory_order_release);
+        releaseInOrder();
+    }
+}
+
+void InferenceStage::releaseInOrder() {
+    for (;;) {
+        Worker* oldest = nullptr;
+        int64_t oldestRunningNs = kIdle;
+        for (auto& worker : workers_) {
+            oldestRunningNs = std::min(oldestRunningNs, worker->runningTimestampNs.load(std::memory_order_acquire));
+            if (worker->hasPending &&
+                (!oldest || worker->pending.frameTimestampNs < oldest->pending.frameTimestampNs)) {
+                oldest = worker.get();
+            }
+        }
+        // Hold it while some worker is still on an older frame.
+        if (!oldest || oldest->pending.frameTimestampNs > oldestRunningNs) return;
+
+        oldest->hasPending = false;
+        const InferenceResult& pending = oldest->pending;
+        if (pending.frameTimestampNs <= lastPublishedNs_) {
+            discarded_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        lastPublishedNs_ = pending.frameTimestampNs;
+
+        InferenceResult& result = results_.writeBuffer();
+        result.sequence = ++sequence_;
+        result.frameTimestampNs = pending.frameTimestampNs;
+        result.frameAcquiredNs = pending.frameAcquiredNs;
+        result.capture = pending.capture;
+        result.completedNs = pending.completedNs;
+        result.worker = pending.worker;
+        result.crop = pending.crop;
+        result.frameWidth = pending.frameWidth;
+        result.frameHeight = pending.frameHeight;
+        result.count = pending.count;
+        result.values.assign(pending.values.begin(), pending.values.begin() + pending.count);
+        results_.publish();
+
+        int64_t nowNs = monotonicNowNs();
+        latency_.add(nowNs - pending.frameAcquiredNs);
+        if (completed_.fetch_add(1, std::memory_order_relaxed) == 0) firstNs_ = nowNs;
+        lastNs_ = nowNs;
+    }
+}
+
+double InferenceStage::rate() const {
+    uint64_t done = completed();
+    return done > 1 && lastNs_ > firstNs_ ? (done - 1) * 1e9 / double(lastNs_ - firstNs_) : 0.0;
+}
+
+void InferenceStage::logStats() const {
+    LOGI("%llu inferences (%.1f/s) on %d worker%s, %llu failed, %llu discarded out of order, "
+         "%llu of %llu frames skipped while busy",
+         (unsigned long long)completed(), rate(), workers(), workers() == 1 ? "" : "s",
+         (unsigned long long)failed(), (unsigned long long)discarded(),
+         (unsigned long long)skipped(), (unsigned long long)submitted());
+    for (int i = 0; i < workers(); ++i) {
+        const Worker& worker = *workers_[i];
+        LOGI("worker %d: %llu done, preprocess (%s) p50 %.3f  p95 %.3f ms   "
+             "invoke p50 %.3f  p95 %.3f  p99 %.3f ms",
+             i, (unsigned long long)worker.completed.load(), Preprocessor::isaName(worker.preprocessor.isa()),
+             worker.preprocess.percentileNs(50) / 1e6, worker.preprocess.percentileNs(95) / 1e6,
+             worker.invoke.percentileNs(50) / 1e6, worker.invoke.percentileNs(95) / 1e6,
+             worker.invoke.percentileNs(99) / 1e6);
+    }
+    LOGI("capture to result p50 %.3f  p95 %.3f  max %.3f ms",
+         latency_.percentileNs(50) / 1e6, latency_.percentileNs(95) / 1e6, latency_.maxNs() / 1e6);
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameHandle.h"
+#include "FrameRing.h"
+#include "InferenceModel.h"
+#include "LatestValue.h"
+#include "PipelineStats.h"
+#include "Preprocess.h"
+
+struct InferenceResult {
+    uint64_t sequence = 0;         // 1 for the first result, then counts up
+    int64_t frameTimestampNs = 0;  // sensor timestamp of the source frame
+    int64_t frameAcquiredNs = 0;
+    // Exposure, frame duration and frame number of the source capture, as
+    // far as its result had arrived.
+    CaptureResultInfo capture;
+    int64_t completedNs = 0;
+    int worker = 0;                // which model instance produced it
+    // The part of the source frame the model saw. Outputs in model-input
+    // coordinates, such as detection boxes, map back to the frame through it.
+    CropRect crop;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    // The model's outputs as readOutputs() flattens them, count values. Sized
+    // to the model once, so a segmentation mask arrives whole and refilling
+    // a result does not allocate.
+    int count = 0;
+    std::vector<float> values;
+};
+
+using InferenceResults = LatestValue<InferenceResult>;
+
+// How submit() picks a worker for each frame.
+enum class DispatchPolicy {
+    RoundRobin,   // frame i goes to worker i % N
+    LeastLoaded,  // idle workers first, then the one with the fewest queued frames
+};
+
+// Schedules one or more InferenceModels, each on its own thread, decoupled
+// from the preview. Every camera frame is offered to one worker through that
+// worker's small latest-wins ring; a worker that is free takes the newest
+// frame it was given and the rest are skipped, so a slow model never builds
+// a backlog or slows the render thread. Frames are preprocessed straight
+// into the model's input tensor and released before invoke(), so a busy
+// worker holds at most one camera buffer.
+//
+// With several workers, results can finish out of order. They are released
+// in frame-timestamp order: a result waits while another worker is still on
+// an older frame, and one that finishes behind a newer published result is
+// discarded. Results carry their source frame's timestamps and go out
+// through a wait-free mailbox the renderer polls, which lets it tell how
+// stale the result it draws is.
+class InferenceStage {
+public:
+    // One worker per model. Each model must be a separate instance (its own
+    // interpreter and tensors); they may share weights.
+    InferenceStage(const std::vector<InferenceModel*>& models, DispatchPolicy policy);
+    explicit InferenceStage(InferenceModel& model)
+        : InferenceStage(std::vector<InferenceModel*>{&model}, DispatchPolicy::RoundRobin) {}
+    ~InferenceStage() { stop(); }
+
+    void start();
+    void stop();
+
+    // Called on the source thread for every frame; never blocks.
+    void submit(FrameHandle frame);
+
+    InferenceResults& results() { return results_; }
+
+    int workers() const { return int(workers_.size()); }
+    DispatchPolicy policy() const { return policy_; }
+
+    // Only stable once stop() has returned.
+    const StageStats& preprocessStats(int worker = 0) const { return workers_[worker]->preprocess; }
+    const StageStats& invokeStats(int worker = 0) const { return workers_[worker]->invoke; }
+    // Camera acquire to result published, including any wait for reordering.
+    const StageStats& latencyStats() const { return latency_; }
+    uint64_t submitted() const { return submitted_.load(std::memory_order_relaxed); }
+    // Results published to the renderer.
+    uint64_t completed() const { return completed_.load(std::memory_order_relaxed); }
+    uint64_t failed() const { return failed_.load(std::memory_order_relaxed); }
+    // Results dropped because a newer frame's result was already out.
+    uint64_t discarded() const { return discarded_.load(std::memory_order_relaxed); }
+    // Frames offered that no worker ever ran on.
+    uint64_t skipped() const { return submitted() - started_.load(std::memory_order_relaxed); }
+    uint64_t completedBy(int worker) const { return workers_[worker]->completed.load(std::memory_order_relaxed); }
+    // Published results per second between the first and last one.
+    double rate() const;
+
+    void logStats() const;
+
+private:
+    static constexpr int64_t kIdle = std::numeric_limits<int64_t>::max();
+
+    struct Worker {
+        explicit Worker(InferenceModel& m) : model(m) {}
+
+        InferenceModel& model;
+        Preprocessor preprocessor;
+        FrameRing<FrameHandle, 2> ring{OverflowPolicy::DropOldest};
+        std::thread thread;
+        // Timestamp of the frame being run, kIdle between frames.
+        std::atomic<int64_t> runningTimestampNs{kIdle};
+        StageStats preprocess;
+        StageStats invoke;
+        std::atomic<uint64_t> completed{0};
+        // Finished result waiting for an older frame on another worker.
+        // Guarded by reorderMutex_.
+        InferenceResult pending;
+        bool hasPending = false;
+    };
+
+    void run(Worker& worker, int index);
+    Worker& pick();
+    // Publishes every pending result no running worker can still undercut.
+    // Caller holds reorderMutex_.
+    void releaseInOrder();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    DispatchPolicy policy_;
+    size_t next_ = 0;  // source thread only
+
+    InferenceResults results_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> started_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> discarded_{0};
+
+    std::mutex reorderMutex_;
+    uint64_t sequence_ = 0;
+    int64_t lastPublishedNs_ = std::numeric_limits<int64_t>::min();
+    StageStats latency_;
+    int64_t firstNs_ = 0;
+    int64_t lastNs_ = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Wait-free single-writer/single-reader mailbox holding the most recent
+// value (a triple buffer). The writer fills writeBuffer() and publishes it;
+// the reader picks up the newest published value, if any, with update().
+// Neither side ever waits for the other or copies more than it writes.
+template <typename T>
+class LatestValue {
+public:
+    T& writeBuffer() { return buffers_[write_]; }
+
+    void publish() {
+        write_ = middle_.exchange(uint8_t(write_ | kFresh), std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Returns true if a value newer than the last read() was published.
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        read_ = middle_.exchange(read_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    const T& read() const { return buffers_[read_]; }
+
+private:
+    static constexpr uint8_t kFresh = 0x4;
+    static constexpr uint8_t kIndexMask = 0x3;
+
+    T buffers_[3] = {};
+    uint8_t write_ = 0;
+    std::atomic<uint8_t> middle_{1};
+    uint8_t read_ = 2;
+};
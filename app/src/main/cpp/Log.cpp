@@ -0,0 +1,138 @@
+#include "Log.h"
+#include "FrameSignal.h"
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+namespace {
+
+// Bounded multi-producer queue after Dmitry Vyukov's: every cell carries a
+// sequence number that says whose turn it is, so producers only contend on
+// the enqueue position and never wait for each other's copies.
+class LogQueue {
+public:
+    static constexpr size_t kCapacity = 256;  // 64 KiB of records
+
+    LogQueue() {
+        for (size_t i = 0; i < kCapacity; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+        std::thread(&LogQueue::run, this).detach();
+        std::atexit([] { Log::flush(); });
+    }
+
+    void push(const LogRecord& record) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos % kCapacity];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);  // full
+                return;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->record = record;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        ready_.notify();
+    }
+
+    void flush() {
+        const size_t target = enqueuePos_.load(std::memory_order_acquire);
+        ready_.notify();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (written_.load(std::memory_order_acquire) < target && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    void setSink(Log::Sink sink) { sink_.store(sink, std::memory_order_release); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    bool pop(LogRecord& record) {
+        Cell& cell = cells_[dequeuePos_ % kCapacity];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) return false;
+        record = cell.record;
+        cell.sequence.store(dequeuePos_ + kCapacity, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+
+    void emit(int priority, const char* tag, const char* text) {
+        if (Log::Sink sink = sink_.load(std::memory_order_acquire)) {
+            sink(priority, tag, text);
+            return;
+        }
+#ifdef __ANDROID__
+        __android_log_write(priority, tag, text);
+#else
+        static const char kLetters[] = "??VDIWEF";
+        const char letter = priority >= 0 && priority < int(sizeof(kLetters) - 1) ? kLetters[priority] : '?';
+        std::fprintf(stderr, "%c/%s: %s\n", letter, tag, text);
+#endif
+    }
+
+    void run() {
+        LogRecord record;
+        char text[1024];
+        uint64_t reportedDrops = 0;
+        for (;;) {
+            const uint32_t seen = ready_.prepare();
+            if (!pop(record)) {
+                ready_.wait(seen);
+                continue;
+            }
+            int length = record.formatter(text, sizeof(text), record.format, record.payload);
+            if (length < 0) length = 0;
+            if (record.suppressed && size_t(length) < sizeof(text)) {
+                std::snprintf(text + length, sizeof(text) - length, " (%u similar suppressed)", record.suppressed);
+            }
+            emit(record.priority, record.tag, text);
+            const uint64_t drops = dropped();
+            if (drops != reportedDrops) {
+                std::snprintf(text, sizeof(text), "%llu messages dropped with the log queue full",
+                              (unsigned long long)(drops - reportedDrops));
+                emit(LOG_LEVEL_WARN, "Log", text);
+                reportedDrops = drops;
+            }
+            written_.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    Cell cells_[kCapacity];
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_ = 0;  // writer thread only
+    std::atomic<size_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<Log::Sink> sink_{nullptr};
+    FrameSignal ready_;
+};
+
+// Started by the first message and never destroyed: the writer thread may
+// still be draining when static destructors run.
+LogQueue& queue() {
+    static LogQueue* queue = new LogQueue;
+    return *queue;
+}
+
+}  // namespace
+
+void Log::enqueue(const LogRecord& record) { queue().push(record); }
+
+void Log::flush() { queue().flush(); }
+
+uint64_t Log::dropped() { return queue().dropped(); }
+
+void Log::setSink(Sink sink) { queue().setSink(sink); }
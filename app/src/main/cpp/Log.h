@@ -0,0 +1,206 @@
+#pragma once
+
+// Logging for code that builds both into the app and on a Linux host.
+// Define LOG_TAG before including to pick the logcat tag.
+//
+//   LOGV, LOGD   detail for hot paths; LOGD is compiled in for debug builds
+//                only, LOGV only when LOG_MIN_LEVEL asks for it
+//   LOGI, LOGW, LOGE
+//
+// Calls below LOG_MIN_LEVEL compile to nothing, arguments included. The
+// rest neither format nor write on the calling thread: the arguments are
+// copied into a lock-free queue (strings by value, truncated to fit) and a
+// background thread formats them and writes them to logcat, or stderr on a
+// host. Each call site gets kLogBurst messages a second; past that they are
+// counted, and the count rides along with the site's next message.
+//
+// Messages still queued when the process dies are lost. Log::flush() waits
+// for the queue to drain; it also runs at exit.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include "MonotonicClock.h"
+
+#ifndef LOG_TAG
+#define LOG_TAG "NdkCamera"
+#endif
+
+// Same values as android_LogPriority.
+#define LOG_LEVEL_VERBOSE 2
+#define LOG_LEVEL_DEBUG 3
+#define LOG_LEVEL_INFO 4
+#define LOG_LEVEL_WARN 5
+#define LOG_LEVEL_ERROR 6
+
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+constexpr uint32_t kLogBurst = 20;
+constexpr int64_t kLogWindowNs = 1000000000;
+
+// Rate limit state for one call site; the macros give every site its own.
+struct LogSite {
+    std::atomic<int64_t> windowStartNs{0};
+    std::atomic<uint32_t> inWindow{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+// One message as queued: the arguments packed back to back, with a function
+// that knows their types and formats them.
+struct LogRecord {
+    static constexpr size_t kPayloadBytes = 224;
+    using Formatter = int (*)(char* out, size_t size, const char* format, const uint8_t* payload);
+
+    int priority = 0;
+    const char* tag = nullptr;     // string literals, so the pointers stay valid
+    const char* format = nullptr;
+    Formatter formatter = nullptr;
+    uint32_t suppressed = 0;       // messages from the site held back since the last one
+    uint8_t payload[kPayloadBytes];
+};
+
+// Payload bytes left for string characters once every argument has its
+// minimum, and how many strings are still to come.
+struct LogBudget {
+    static constexpr size_t kReservePerString = 32;  // so a long first string cannot starve the rest
+
+    size_t slack;
+    size_t strings;
+};
+
+// How one printf argument is packed: scalars and pointers by value, strings
+// by their characters.
+template <typename T>
+struct LogArg {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "log arguments must be printf arguments");
+    static constexpr size_t kMinBytes = sizeof(T);
+    static constexpr bool kString = false;
+
+    static size_t encode(uint8_t* out, T value, LogBudget&) {
+        std::memcpy(out, &value, sizeof(T));
+        return sizeof(T);
+    }
+    static T decode(const uint8_t*& in) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+};
+
+template <>
+struct LogArg<const char*> {
+    static constexpr size_t kMinBytes = 1;  // the terminator
+    static constexpr bool kString = true;
+
+    static size_t encode(uint8_t* out, const char* value, LogBudget& budget) {
+        if (!value) value = "(null)";
+        const size_t reserved = --budget.strings * LogBudget::kReservePerString;
+        const size_t room = budget.slack > reserved ? budget.slack - reserved : 0;
+        size_t length = std::strlen(value);
+        if (length > room) length = room;
+        std::memcpy(out, value, length);
+        out[length] = 0;
+        budget.slack -= length;
+        return length + 1;
+    }
+    static const char* decode(const uint8_t*& in) {
+        const char* value = reinterpret_cast<const char*>(in);
+        in += std::strlen(value) + 1;
+        return value;
+    }
+};
+
+template <>
+struct LogArg<char*> : LogArg<const char*> {
+    static char* decode(const uint8_t*& in) { return const_cast<char*>(LogArg<const char*>::decode(in)); }
+};
+
+class Log {
+public:
+    using Sink = void (*)(int priority, const char* tag, const char* text);
+
+    template <typename... Args>
+    static void write(LogSite& site, int priority, const char* tag, const char* format, Args... args) {
+        LogRecord record;
+        if (!admit(site, record.suppressed)) return;
+        record.priority = priority;
+        record.tag = tag;
+        record.format = format;
+        record.formatter = &formatPayload<Args...>;
+        constexpr size_t minBytes = (size_t(0) + ... + LogArg<Args>::kMinBytes);
+        static_assert(minBytes <= LogRecord::kPayloadBytes, "too many log arguments");
+        [[maybe_unused]] LogBudget budget{LogRecord::kPayloadBytes - minBytes,
+                                          (size_t(0) + ... + size_t(LogArg<Args>::kString))};
+        [[maybe_unused]] size_t used = 0;
+        ((used += LogArg<Args>::encode(record.payload + used, args, budget)), ...);
+        enqueue(record);
+    }
+
+    // Never called; lets the compiler check the format against the arguments.
+    __attribute__((format(printf, 1, 2))) static void checkFormat(const char*, ...) {}
+
+    // Blocks until everything logged before the call has been written, or a
+    // second has passed.
+    static void flush();
+    // Messages lost because the queue was full.
+    static uint64_t dropped();
+    // Where formatted messages go instead of logcat or stderr, on the writer
+    // thread; nullptr for the default. For tests.
+    static void setSink(Sink sink);
+
+private:
+    static bool admit(LogSite& site, uint32_t& suppressed) {
+        const int64_t now = monotonicNowNs();
+        int64_t start = site.windowStartNs.load(std::memory_order_relaxed);
+        if (now - start >= kLogWindowNs &&
+            site.windowStartNs.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            site.inWindow.store(0, std::memory_order_relaxed);
+        }
+        if (site.inWindow.fetch_add(1, std::memory_order_relaxed) >= kLogBurst) {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    template <typename... Args>
+    static int formatPayload(char* out, size_t size, const char* format, [[maybe_unused]] const uint8_t* payload) {
+        // Braced initialisation decodes the arguments in order.
+        std::tuple<Args...> args{LogArg<Args>::decode(payload)...};
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+        return std::apply([&](auto... values) { return std::snprintf(out, size, format, values...); }, args);
+#pragma GCC diagnostic pop
+    }
+
+    static void enqueue(const LogRecord& record);
+};
+
+#define LOG_AT(priority, ...)                                        \
+    do {                                                             \
+        if constexpr ((priority) >= LOG_MIN_LEVEL) {                 \
+            static LogSite logSite_;                                 \
+            if (false) Log::checkFormat(__VA_ARGS__);                \
+            Log::write(logSite_, (priority), LOG_TAG, __VA_ARGS__);  \
+        }                                                            \
+    } while (0)
+
+#define LOGV(...) LOG_AT(LOG_LEVEL_VERBOSE, __VA_ARGS__)
+#define LOGD(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOGI(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOGW(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOGE(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
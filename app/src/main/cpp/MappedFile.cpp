@@ -0,0 +1,49 @@
+#define LOG_TAG "MappedFile"
+
+#include "MappedFile.h"
+#include "Log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<MappedFile> MappedFile::open(const char* path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("open %s: %s", path, strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    std::unique_ptr<MappedFile> file;
+    if (fstat(fd, &st) != 0) {
+        LOGE("fstat %s: %s", path, strerror(errno));
+    } else {
+        file = map(fd, 0, size_t(st.st_size));
+    }
+    close(fd);
+    return file;
+}
+
+std::unique_ptr<MappedFile> MappedFile::map(int fd, off_t offset, size_t length) {
+    if (length == 0 || offset < 0) {
+        LOGE("Nothing to map (offset %lld, length %zu)", (long long)offset, length);
+        return nullptr;
+    }
+    // mmap wants a page-aligned offset; asset data inside an APK rarely is.
+    const off_t page = off_t(sysconf(_SC_PAGESIZE));
+    const off_t alignedOffset = offset & ~(page - 1);
+    const size_t slack = size_t(offset - alignedOffset);
+    void* base = mmap(nullptr, length + slack, PROT_READ, MAP_PRIVATE, fd, alignedOffset);
+    if (base == MAP_FAILED) {
+        LOGE("mmap %zu bytes at %lld: %s", length, (long long)offset, strerror(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(
+            new MappedFile(base, length + slack, static_cast<const char*>(base) + slack, length));
+}
+
+MappedFile::~MappedFile() {
+    munmap(base_, mappedLength_);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <sys/types.h>
+
+// Read-only, private mapping of (part of) a file. The pages are shared with
+// the page cache, so mapping a model costs no heap and no copy, and pages the
+// interpreter never touches are never read in.
+class MappedFile {
+public:
+    // Maps the whole file. Returns nullptr (and logs why) on failure.
+    static std::unique_ptr<MappedFile> open(const char* path);
+    // Maps `length` bytes starting at `offset`, e.g. an uncompressed APK
+    // asset from AAsset_openFileDescriptor(). The caller keeps ownership of
+    // fd and may close it straight away.
+    static std::unique_ptr<MappedFile> map(int fd, off_t offset, size_t length);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(void* base, size_t mappedLength, const char* data, size_t size)
+        : base_(base), mappedLength_(mappedLength), data_(data), size_(size) {}
+
+    void* base_;
+    size_t mappedLength_;
+    const char* data_;
+    size_t size_;
+};
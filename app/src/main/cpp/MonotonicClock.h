@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+
+// CLOCK_MONOTONIC in nanoseconds, the clock every pipeline timestamp uses.
+inline int64_t monotonicNowNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Maps a CLOCK_BOOTTIME timestamp (what cameras with a REALTIME sensor
+// timestamp source report) onto CLOCK_MONOTONIC.
+inline int64_t bootTimeToMonotonicNs(int64_t bootNs) {
+    timespec boot, mono;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    int64_t offset = (int64_t(boot.tv_sec) - mono.tv_sec) * 1000000000 + (boot.tv_nsec - mono.tv_nsec);
+    return bootNs - offset;
+}
@@ -1,477 +1,401 @@
+#define LOG_TAG "NativeCamera"
 
-// ===== native-lib.cpp =====
-#include <android/native_activity.h>
-#include <android/native_window.h>
-#include <android/log.h>
-#include "Renderer.h"
 #include "NativeCamera.h"
+#include "FrameTrace.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <algorithm>
+#include <android/hardware_buffer.h>
+#include <dlfcn.h>
+#include <unistd.h>
 
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, "NDK_MAIN", __VA_ARGS__)
-
-static Renderer     gRenderer;
-static NativeCamera gCamera;
-
-
-
-static void onWindowCreated(ANativeActivity*, ANativeWindow* window) {
-    gRenderer.init(window);
-    gRenderer.startRenderLoop();
-    gCamera.open(640, 480, [](AImage* img) {
-        gRenderer.submitFrame(img);
-    });
-}
-
-static void onWindowDestroyed(ANativeActivity*, ANativeWindow*) {
-    gCamera.close();
-    gRenderer.stopRenderLoop();
-    gRenderer.shutdown();
-}
-
-
-//    gCamera.open(640, 480, [window](AImage* img) {
-//        // Always ensure surface is valid before drawing
-////        gRenderer.setWindow(window);  // will recreate surface if changed
-////        gRenderer.ensureCurrent();
-////        gRenderer.setWindow(window);
-////
-//////        gRenderer.uploadYUV(img);
-////
-////        // Check context is still current
-////
-//        static struct timespec prev_time;
-//        struct timespec now;
-//
-//        clock_gettime(CLOCK_MONOTONIC, &now);
-//        long diff_ms = (now.tv_sec - prev_time.tv_sec) * 1000 + (now.tv_nsec - prev_time.tv_nsec) / 1000000;
-//        LOGI("Frame diff: %ld ms, ",diff_ms);
-//
-//        gRenderer.draw();
-//    });
-//}
-
+namespace {
 
-//static void onWindowDestroyed(ANativeActivity*, ANativeWindow*) {
-//    gCamera.close();
-//    gRenderer.shutdown();
-//}
+// API 26 entry points, looked up at run time because minSdk is 24.
+struct HardwareBufferApi {
+    media_status_t (*newReaderWithUsage)(int32_t, int32_t, int32_t, uint64_t, int32_t, AImageReader**) = nullptr;
+    media_status_t (*getHardwareBuffer)(const AImage*, AHardwareBuffer**) = nullptr;
 
-extern "C"
-void ANativeActivity_onCreate(ANativeActivity* activity, void*, size_t) {
-    activity->callbacks->onNativeWindowCreated = onWindowCreated;
-    activity->callbacks->onNativeWindowDestroyed = onWindowDestroyed;
-}
-// ===== Renderer.h =====
-#pragma once
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
-#include <media/NdkImage.h>
-#include <EGL/egl.h>
-#include <GLES2/gl2.h>
-#include <android/native_window.h>
-
-class Renderer {
-public:
-
-    bool ensureCurrent();
-    void setWindow(ANativeWindow* window);
-    bool init(ANativeWindow* window);
-    void draw();
-    void shutdown();
-
-    void startRenderLoop();                 // NEW
-    void stopRenderLoop();                  // NEW
-    void submitFrame(AImage* image);        // NEW
-
-private:
-    EGLDisplay display_ = EGL_NO_DISPLAY;
-    EGLSurface surface_ = EGL_NO_SURFACE;
-    EGLContext context_ = EGL_NO_CONTEXT;
-    EGLConfig  config_;
-
-    GLuint shaderProgram_ = 0;
-    GLuint vbo_ = 0;
-    GLint  positionAttrib_ = -1;
-
-    int surfaceWidth_ = 0;
-    int surfaceHeight_ = 0;
-
-
-    std::thread renderThread_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    std::atomic<bool> running_{false};
-
-    AImage* latestImage_ = nullptr;  // Will hold most recent image
+    HardwareBufferApi() {
+        if (void* mediandk = dlopen("libmediandk.so", RTLD_NOW)) {
+            newReaderWithUsage = reinterpret_cast<decltype(newReaderWithUsage)>(
+                    dlsym(mediandk, "AImageReader_newWithUsage"));
+            getHardwareBuffer = reinterpret_cast<decltype(getHardwareBuffer)>(
+                    dlsym(mediandk, "AImage_getHardwareBuffer"));
+        }
+    }
+    bool available() const { return newReaderWithUsage && getHardwareBuffer; }
 };
 
+const HardwareBufferApi& hardwareBufferApi() {
+    static const HardwareBufferApi api;
+    return api;
+}
 
-// ===== Renderer.cpp =====
-// Updated Renderer.cpp to ensure EGL context and surface are current and safe before drawing
-
-#include <android/log.h>
-#include <EGL/egl.h>
-#include <GLES2/gl2.h>
-
-#define LOG_TAG "Renderer"
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
-
-
-bool Renderer::init(ANativeWindow* window) {
-    // 1. Get EGL display
-    display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    if (display_ == EGL_NO_DISPLAY) {
-        LOGE("❌ Failed to get EGL display");
-        return false;
+void readCapabilities(const ACameraMetadata* metadata, CaptureCapabilities& capabilities) {
+    ACameraMetadata_const_entry entry;
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES, &entry) == ACAMERA_OK) {
+        capabilities.setFpsRanges(entry.data.i32, entry.count);
     }
-
-    // 2. Initialize EGL
-    if (!eglInitialize(display_, nullptr, nullptr)) {
-        LOGE("❌ Failed to initialize EGL");
-        return false;
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_SENSOR_INFO_EXPOSURE_TIME_RANGE, &entry) == ACAMERA_OK) {
+        capabilities.minExposureNs = entry.data.i64[0];
+        capabilities.maxExposureNs = entry.data.i64[1];
     }
-
-    // 3. Choose EGL config
-    const EGLint configAttribs[] = {
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-            EGL_RED_SIZE, 8,
-            EGL_GREEN_SIZE, 8,
-            EGL_BLUE_SIZE, 8,
-            EGL_NONE
-    };
-    EGLint numConfigs;
-    if (!eglChooseConfig(display_, configAttribs, &config_, 1, &numConfigs) || numConfigs == 0) {
-        LOGE("❌ Failed to choose EGL config");
-        return false;
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_SENSOR_INFO_SENSITIVITY_RANGE, &entry) == ACAMERA_OK) {
+        capabilities.minSensitivity = entry.data.i32[0];
+        capabilities.maxSensitivity = entry.data.i32[1];
     }
-
-    // 4. Create EGL context
-    const EGLint contextAttribs[] = {
-            EGL_CONTEXT_CLIENT_VERSION, 2,
-            EGL_NONE
-    };
-    context_ = eglCreateContext(display_, config_, EGL_NO_CONTEXT, contextAttribs);
-    if (context_ == EGL_NO_CONTEXT) {
-        LOGE("❌ Failed to create EGL context");
-        return false;
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_CONTROL_AE_COMPENSATION_RANGE, &entry) == ACAMERA_OK) {
+        capabilities.minCompensation = entry.data.i32[0];
+        capabilities.maxCompensation = entry.data.i32[1];
     }
-
-    // 5. Create EGL window surface
-    surface_ = eglCreateWindowSurface(display_, config_, window, nullptr);
-    if (surface_ == EGL_NO_SURFACE) {
-        LOGE("❌ Failed to create EGL surface");
-        return false;
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_LENS_INFO_MINIMUM_FOCUS_DISTANCE, &entry) == ACAMERA_OK) {
+        capabilities.minFocusDistance = entry.data.f[0];
     }
-
-    // 6. Make EGL context current
-    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-        EGLint err = eglGetError();
-        LOGE("❌ eglMakeCurrent failed with error: 0x%x", err);
-        return false;
-    }
-
-    // 7. (Optional) Query width/height or set viewport
-    EGLint width, height;
-    eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
-    eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
-    glViewport(0, 0, width, height);
-
-    LOGI("✅ Renderer initialized: %dx%d", width, height);
-    return true;
-}
-
-bool Renderer::ensureCurrent() {
-    if (eglGetCurrentContext() != context_ || eglGetCurrentSurface(EGL_DRAW) != surface_) {
-        if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-            EGLint err = eglGetError();
-            LOGE("ensureCurrent: Failed to make EGL current again: 0x%x", err);
-            return false;
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_CONTROL_AF_AVAILABLE_MODES, &entry) == ACAMERA_OK) {
+        for (uint32_t i = 0; i < entry.count; ++i) {
+            switch (entry.data.u8[i]) {
+                case ACAMERA_CONTROL_AF_MODE_CONTINUOUS_VIDEO: capabilities.focusModes.push_back(FocusMode::Continuous); break;
+                case ACAMERA_CONTROL_AF_MODE_AUTO: capabilities.focusModes.push_back(FocusMode::Auto); break;
+                case ACAMERA_CONTROL_AF_MODE_OFF: capabilities.focusModes.push_back(FocusMode::Fixed); break;
+                default: break;
+            }
         }
     }
-    return true;
-}
-
-void Renderer::setWindow(ANativeWindow* window) {
-    if (window == nullptr) return;
-
-    if (surface_ != EGL_NO_SURFACE) {
-        eglDestroySurface(display_, surface_);
-    }
-
-    surface_ = eglCreateWindowSurface(display_, config_, window, nullptr);
-    if (surface_ == EGL_NO_SURFACE) {
-        EGLint err = eglGetError();
-        LOGE("setWindow: Failed to create new surface: 0x%x", err);
-        return;
-    }
-
-    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-        EGLint err = eglGetError();
-        LOGE("setWindow: Failed to make new EGL surface current: 0x%x", err);
-    }
-}
-
-/*
-//void Renderer::draw() {
-//    if (!ensureCurrent()) return;
-//
-//    EGLint w, h;
-//    eglQuerySurface(display_, surface_, EGL_WIDTH, &w);
-//    eglQuerySurface(display_, surface_, EGL_HEIGHT, &h);
-//    LOGI("Drawing with surface size: %d x %d", w, h);
-//
-//    glViewport(0, 0, w, h);
-//    glClearColor(1.0f, 0.0f, 0.0f, 1.0f); // Red screen
-//    glClear(GL_COLOR_BUFFER_BIT);
-//
-//    if (!eglSwapBuffers(display_, surface_)) {
-//        EGLint err = eglGetError();
-//        LOGE("eglSwapBuffers failed with error: 0x%x", err);
-//    }
-//}
-
-void Renderer::draw() {
-    if (display_ == EGL_NO_DISPLAY || surface_ == EGL_NO_SURFACE) return;
-    eglSwapBuffers(display_, surface_);
-
-    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);  // red
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    eglSwapBuffers(display_, surface_);
-}
-*/
-void Renderer::submitFrame(AImage* image) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (latestImage_) {
-        AImage_delete(latestImage_);  // Drop old image if present
-    }
-    latestImage_ = image;
-    cv_.notify_one();
-}
-
-
-void Renderer::startRenderLoop() {
-    running_ = true;
-    renderThread_ = std::thread([this]() {
-        while (running_) {
-            AImage* image = nullptr;
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                cv_.wait(lock, [this]() { return !running_ || latestImage_ != nullptr; });
-
-                if (!running_) break;
-
-                image = latestImage_;
-                latestImage_ = nullptr;  // Clear it once taken
-            }
-
-            if (image) {
-                draw();  // You can change this to uploadYUV(image); draw(); etc.
-                AImage_delete(image);
-            }
+    if (ACameraMetadata_getConstEntry(metadata, ACAMERA_REQUEST_AVAILABLE_CAPABILITIES, &entry) == ACAMERA_OK) {
+        for (uint32_t i = 0; i < entry.count; ++i) {
+            if (entry.data.u8[i] == ACAMERA_REQUEST_AVAILABLE_CAPABILITIES_MANUAL_SENSOR) capabilities.manualSensor = true;
         }
-    });
-}
-
-void Renderer::stopRenderLoop() {
-    running_ = false;
-    cv_.notify_all();
-    if (renderThread_.joinable())
-        renderThread_.join();
-}
-
-
-void Renderer::draw() {
-    if (display_ == EGL_NO_DISPLAY || surface_ == EGL_NO_SURFACE || context_ == EGL_NO_CONTEXT) {
-        LOGE("draw: Missing EGL display, surface, or context");
-        return;
     }
+}
 
-    // Make sure this thread is bound to the EGL context
-    if (eglGetCurrentContext() != context_ || eglGetCurrentSurface(EGL_DRAW) != surface_) {
-        if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-            EGLint err = eglGetError();
-            LOGE("draw: eglMakeCurrent failed with error: 0x%x", err);
-            return;
+}  // namespace
+
+bool NativeCamera::open(const std::vector<StreamRequest>& streams) {
+    close();
+    setLost(false);
+    streams_.clear();
+    if (streams.empty() || !describeCamera()) return false;
+    // The previous session is closed, so its callbacks are done writing.
+    captureResults_.clear();
+    lastResultNs_.store(0, std::memory_order_relaxed);
+    capturesStarted_ = 0;
+    for (size_t i = 0; i < streams.size(); ++i) {
+        auto stream = std::make_unique<Stream>();
+        stream->camera = this;
+        stream->index = int(i);
+        stream->config = streams[i].config;
+        stream->onFrame = streams[i].onFrame;
+        stream->pool = std::make_unique<FramePool>(stream->config.maxImages);
+        streams_.push_back(std::move(stream));
+        const StreamConfig& config = streams[i].config;
+        const StreamSize listed = sizes_.find(config.width, config.height);
+        if (!listed && !sizes_.empty()) {
+            LOGE("Stream %zu: %dx%d is not a listed YUV size; the camera may reject or rescale it", i,
+                 config.width, config.height);
         }
+        if (!openReader(*streams_.back())) return false;
+        LOGI("Stream %zu: %dx%d, %d buffers, up to %.0f fps%s", i, config.width, config.height, config.maxImages,
+             listed.maxFps(), streams_.back()->hardwareBuffers ? ", GPU-sampled" : "");
     }
+    return setupCamera();
+}
 
-    // Get actual surface dimensions
-    EGLint width = 0, height = 0;
-    eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
-    eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
-    LOGI("draw: surface dimensions = %d x %d", width, height);
-
-    // Set viewport and clear color
-    glViewport(0, 0, width, height);
-    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);  // Red background
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    // Present frame
-    if (!eglSwapBuffers(display_, surface_)) {
-        EGLint err = eglGetError();
-        LOGI("draw: eglSwapBuffers failed with error: 0x%x", err);
+bool NativeCamera::openReader(Stream& stream) {
+    const StreamConfig& config = stream.config;
+    const HardwareBufferApi& api = hardwareBufferApi();
+    stream.hardwareBuffers = config.gpuSampled && api.available();
+    media_status_t status;
+    if (stream.hardwareBuffers) {
+        // CPU reads stay allowed so the upload path still works as a fallback.
+        const uint64_t usage = AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE | AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN;
+        status = api.newReaderWithUsage(config.width, config.height, config.format, usage, config.maxImages,
+                                        &stream.reader);
     } else {
-        LOGI("draw: frame swapped successfully");
+        status = AImageReader_new(config.width, config.height, config.format, config.maxImages, &stream.reader);
     }
-}
-
-
-void Renderer::shutdown() {
-    if (display_ != EGL_NO_DISPLAY) {
-        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-        if (context_ != EGL_NO_CONTEXT) eglDestroyContext(display_, context_);
-        if (surface_ != EGL_NO_SURFACE) eglDestroySurface(display_, surface_);
-        eglTerminate(display_);
+    if (status != AMEDIA_OK) {
+        LOGE("AImageReader_new %dx%d failed", config.width, config.height);
+        return false;
     }
-
-    display_ = EGL_NO_DISPLAY;
-    context_ = EGL_NO_CONTEXT;
-    surface_ = EGL_NO_SURFACE;
-}
-
-// ===== NativeCamera.h =====
-#pragma once
-#include <camera/NdkCameraManager.h>
-#include <media/NdkImageReader.h>
-#include <functional>
-#include "Renderer.h"
-
-
-class NativeCamera {
-public:
-    using FrameCallback = std::function<void(AImage*)>;
-
-    bool open(int width, int height, FrameCallback cb);
-    void close();
-    void onImage(void* ctx, AImageReader* reader);
-    Renderer gRenderer;
-
-private:
-    static void onCameraDisconnected(void*, ACameraDevice*) {}
-    static void onCameraError(void*, ACameraDevice*, int) {}
-
-    FrameCallback frameCb_;
-    ACameraManager* manager_ = nullptr;
-    ACameraDevice* camera_ = nullptr;
-    ACameraCaptureSession* session_ = nullptr;
-    ACaptureRequest* request_ = nullptr;
-    AImageReader* reader_ = nullptr;
-    ANativeWindow* readerWindow_ = nullptr;
-    ACaptureSessionOutputContainer* container_ = nullptr;
-    ACaptureSessionOutput* output_ = nullptr;
-    ACameraOutputTarget* outputTarget_ = nullptr;
-
-    void setupCamera(int width, int height);
-};
-
-// ===== NativeCamera.cpp =====
-#include "NativeCamera.h"
-#include <camera/NdkCameraManager.h>
-#include <media/NdkImageReader.h>
-#include <android/log.h>
-#include <unistd.h>
-
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, "NativeCamera", __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "NativeCamera", __VA_ARGS__)
-
-
-bool NativeCamera::open(int width, int height, FrameCallback cb) {
-    LOGI("nativecame open");
-    frameCb_ = cb;
-    manager_ = ACameraManager_create();
-
-    AImageReader_new(width, height, AIMAGE_FORMAT_YUV_420_888, 4, &reader_);
     AImageReader_ImageListener listener = {
-            .context = this,
+            .context = &stream,
             .onImageAvailable = &NativeCamera::onImage
     };
-    AImageReader_setImageListener(reader_, &listener);
+    AImageReader_setImageListener(stream.reader, &listener);
 
     const int maxWaitMs = 2000;
     int waited = 0;
-    while ((AImageReader_getWindow(reader_, &readerWindow_) != AMEDIA_OK || !readerWindow_) && waited < maxWaitMs) {
+    while ((AImageReader_getWindow(stream.reader, &stream.window) != AMEDIA_OK || !stream.window) &&
+           waited < maxWaitMs) {
         usleep(10000);
         waited += 10;
     }
-    if (!readerWindow_) {
+    if (!stream.window) {
         LOGE("\u274c Timeout: AImageReader window not ready");
         return false;
     }
-
-    setupCamera(width, height);
     return true;
 }
 
-void NativeCamera::setupCamera(int width, int height) {
+const StreamSelector& NativeCamera::streamSizes() {
+    describeCamera();
+    return sizes_;
+}
+
+bool NativeCamera::describeCamera() {
+    if (!manager_) manager_ = ACameraManager_create();
+    if (!cameraId_.empty()) return true;
     ACameraIdList* cameraIdList = nullptr;
-    ACameraManager_getCameraIdList(manager_, &cameraIdList);
+    if (ACameraManager_getCameraIdList(manager_, &cameraIdList) != ACAMERA_OK || !cameraIdList) return false;
 
-    const char* selectedCameraId = nullptr;
-    for (int i = 0; i < cameraIdList->numCameras; ++i) {
+    for (int i = 0; i < cameraIdList->numCameras && cameraId_.empty(); ++i) {
         ACameraMetadata* metadata = nullptr;
         ACameraManager_getCameraCharacteristics(manager_, cameraIdList->cameraIds[i], &metadata);
 
         ACameraMetadata_const_entry entry;
         if ((media_status_t)ACameraMetadata_getConstEntry(metadata, ACAMERA_LENS_FACING, &entry) == AMEDIA_OK &&
             entry.data.u8[0] == ACAMERA_LENS_FACING_BACK) {
-            selectedCameraId = cameraIdList->cameraIds[i];
-            ACameraMetadata_free(metadata);
-            break;
+            cameraId_ = cameraIdList->cameraIds[i];
+            // REALTIME sources stamp frames with CLOCK_BOOTTIME; anything else
+            // has an unspecified time base that cannot be compared with ours.
+            ACameraMetadata_const_entry source;
+            sensorTimeIsBootTime_ =
+                    ACameraMetadata_getConstEntry(metadata, ACAMERA_SENSOR_INFO_TIMESTAMP_SOURCE, &source) == ACAMERA_OK &&
+                    source.data.u8[0] == ACAMERA_SENSOR_INFO_TIMESTAMP_SOURCE_REALTIME;
+            ACameraMetadata_const_entry orientation;
+            sensorOrientation_ =
+                    ACameraMetadata_getConstEntry(metadata, ACAMERA_SENSOR_ORIENTATION, &orientation) == ACAMERA_OK
+                            ? orientation.data.i32[0]
+                            : 0;
+            ACameraMetadata_const_entry configurations, durations;
+            if (ACameraMetadata_getConstEntry(metadata, ACAMERA_SCALER_AVAILABLE_STREAM_CONFIGURATIONS,
+                                              &configurations) == ACAMERA_OK) {
+                const bool haveDurations = ACameraMetadata_getConstEntry(
+                        metadata, ACAMERA_SCALER_AVAILABLE_MIN_FRAME_DURATIONS, &durations) == ACAMERA_OK;
+                sizes_ = StreamSelector(configurations.data.i32, configurations.count,
+                                        haveDurations ? durations.data.i64 : nullptr,
+                                        haveDurations ? durations.count : 0);
+            }
+            readCapabilities(metadata, capabilities_);
+            LOGI("Camera %s: sensor orientation %d degrees, %zu YUV sizes", cameraId_.c_str(), sensorOrientation_,
+                 sizes_.sizes().size());
         }
         ACameraMetadata_free(metadata);
     }
+    ACameraManager_deleteCameraIdList(cameraIdList);
+    if (cameraId_.empty()) LOGE("No back-facing camera found");
+    return !cameraId_.empty();
+}
 
-    if (!selectedCameraId) {
-        LOGE("No back-facing camera found");
-        return;
-    }
-
-
-    ACameraDevice_StateCallbacks deviceCallbacks = {};
-    camera_status_t status = ACameraManager_openCamera(manager_, selectedCameraId, &deviceCallbacks, &camera_);
+bool NativeCamera::setupCamera() {
+    ACameraDevice_StateCallbacks deviceCallbacks = {
+            .context = this,
+            .onDisconnected = &NativeCamera::onCameraDisconnected,
+            .onError = &NativeCamera::onCameraError,
+    };
+    camera_status_t status = ACameraManager_openCamera(manager_, cameraId_.c_str(), &deviceCallbacks, &camera_);
     if (status != ACAMERA_OK) {
         LOGE("Failed to open camera, status: %d", status);
-        return;
+        return false;
     }
 
     status = ACameraDevice_createCaptureRequest(camera_, TEMPLATE_PREVIEW, &request_);
     if (status != ACAMERA_OK) {
         LOGE("Failed to create capture request, status: %d", status);
-        return;
+        return false;
     }
 
-    ACameraOutputTarget_create(readerWindow_, &outputTarget_);
-    ACaptureRequest_addTarget(request_, outputTarget_);
+    controls_ = resolveControls(requestedControls_, capabilities_);
+    applyControls();
 
+    // Every stream is a target of the one repeating request, so each capture
+    // lands in all readers with the same sensor timestamp.
     ACaptureSessionOutputContainer_create(&container_);
-    ACaptureSessionOutput_create(readerWindow_, &output_);
-    ACaptureSessionOutputContainer_add(container_, output_);
+    for (auto& stream : streams_) {
+        ACameraOutputTarget_create(stream->window, &stream->target);
+        ACaptureRequest_addTarget(request_, stream->target);
+        ACaptureSessionOutput_create(stream->window, &stream->output);
+        ACaptureSessionOutputContainer_add(container_, stream->output);
+    }
 
     ACameraCaptureSession_stateCallbacks sessionCallbacks = {};
     status = ACameraDevice_createCaptureSession(camera_, container_, &sessionCallbacks, &session_);
     if (status != ACAMERA_OK) {
         LOGE("Failed to create capture session, status: %d", status);
-        return;
+        return false;
     }
 
-    status = ACameraCaptureSession_setRepeatingRequest(session_, nullptr, 1, &request_, nullptr);
+    return startRepeating();
+}
+
+bool NativeCamera::startRepeating() {
+    ACameraCaptureSession_captureCallbacks callbacks = {};
+    callbacks.context = this;
+    callbacks.onCaptureStarted = &NativeCamera::onCaptureStarted;
+    callbacks.onCaptureCompleted = &NativeCamera::onCaptureCompleted;
+    camera_status_t status = ACameraCaptureSession_setRepeatingRequest(session_, &callbacks, 1, &request_, nullptr);
     if (status != ACAMERA_OK) {
         LOGE("Failed to set repeating request, status: %d", status);
+        return false;
     }
+    return true;
 }
 
-extern Renderer gRenderer;
+CaptureControls NativeCamera::setControls(const CaptureControls& controls) {
+    requestedControls_ = controls;
+    describeCamera();
+    controls_ = resolveControls(controls, capabilities_);
+    // Replacing the repeating request takes effect within a few frames; the
+    // session, its outputs and the readers are untouched.
+    if (request_ && session_) {
+        applyControls();
+        startRepeating();
+    }
+    return controls_;
+}
+
+CaptureResultInfo NativeCamera::lastCapture() const {
+    CaptureResultInfo info;
+    captureResults_.find(lastResultNs_.load(std::memory_order_acquire), info);
+    return info;
+}
+
+// Writes controls_ into request_. AE and AF are written every time, so
+// switching back from manual exposure or fixed focus really returns to
+// automatic; an fps range of 0 keeps whatever range the request has.
+void NativeCamera::applyControls() {
+    const CaptureControls& c = controls_;
+    if (c.fps.max > 0) {
+        const int32_t range[2] = {c.fps.min, c.fps.max};
+        ACaptureRequest_setEntry_i32(request_, ACAMERA_CONTROL_AE_TARGET_FPS_RANGE, 2, range);
+    }
+    if (c.exposureTimeNs > 0) {
+        const uint8_t aeMode = ACAMERA_CONTROL_AE_MODE_OFF;
+        ACaptureRequest_setEntry_u8(request_, ACAMERA_CONTROL_AE_MODE, 1, &aeMode);
+        ACaptureRequest_setEntry_i64(request_, ACAMERA_SENSOR_EXPOSURE_TIME, 1, &c.exposureTimeNs);
+        if (c.sensitivity > 0) ACaptureRequest_setEntry_i32(request_, ACAMERA_SENSOR_SENSITIVITY, 1, &c.sensitivity);
+        // With AE off the target fps range no longer applies; the sensor
+        // needs the frame duration itself.
+        if (c.fps.max > 0) {
+            const int64_t frameDurationNs = 1000000000LL / c.fps.max;
+            ACaptureRequest_setEntry_i64(request_, ACAMERA_SENSOR_FRAME_DURATION, 1, &frameDurationNs);
+        }
+    } else {
+        const uint8_t aeMode = ACAMERA_CONTROL_AE_MODE_ON;
+        const uint8_t aeLock = c.aeLock ? ACAMERA_CONTROL_AE_LOCK_ON : ACAMERA_CONTROL_AE_LOCK_OFF;
+        ACaptureRequest_setEntry_u8(request_, ACAMERA_CONTROL_AE_MODE, 1, &aeMode);
+        ACaptureRequest_setEntry_u8(request_, ACAMERA_CONTROL_AE_LOCK, 1, &aeLock);
+        ACaptureRequest_setEntry_i32(request_, ACAMERA_CONTROL_AE_EXPOSURE_COMPENSATION, 1, &c.exposureCompensation);
+    }
+    uint8_t afMode = ACAMERA_CONTROL_AF_MODE_CONTINUOUS_VIDEO;
+    if (c.focus == FocusMode::Auto) afMode = ACAMERA_CONTROL_AF_MODE_AUTO;
+    if (c.focus == FocusMode::Fixed) afMode = ACAMERA_CONTROL_AF_MODE_OFF;
+    ACaptureRequest_setEntry_u8(request_, ACAMERA_CONTROL_AF_MODE, 1, &afMode);
+    if (c.focus == FocusMode::Fixed) {
+        ACaptureRequest_setEntry_float(request_, ACAMERA_LENS_FOCUS_DISTANCE, 1, &c.focusDistance);
+    }
+    LOGI("Capture controls: fps %d-%d, exposure %s, AF %d", c.fps.min, c.fps.max,
+         c.exposureTimeNs > 0 ? "manual" : "auto", afMode);
+}
+
+// The device is gone for this session either way; the owner finds out
+// through lost() and reopens.
+void NativeCamera::onCameraDisconnected(void* ctx, ACameraDevice*) {
+    LOGW("Camera disconnected");
+    static_cast<NativeCamera*>(ctx)->setLost(true);
+}
+
+void NativeCamera::onCameraError(void* ctx, ACameraDevice*, int error) {
+    LOGE("Camera error %d", error);
+    static_cast<NativeCamera*>(ctx)->setLost(true);
+}
+
+// The NDK's callbacks carry no frame number (ACAMERA_SYNC_FRAME_NUMBER is
+// the last synchronized frame, often -1 or -2), so captures are numbered as
+// they start: every capture starts, in order, even one that later fails.
+void NativeCamera::onCaptureStarted(void* ctx, ACameraCaptureSession*, const ACaptureRequest*, int64_t timestampNs) {
+    auto* self = static_cast<NativeCamera*>(ctx);
+    CaptureResultInfo info;
+    info.timestampNs = timestampNs;
+    info.frameNumber = self->capturesStarted_++;
+    self->captureResults_.record(info);
+}
+
+void NativeCamera::onCaptureCompleted(void* ctx, ACameraCaptureSession*, ACaptureRequest*,
+                                      const ACameraMetadata* result) {
+    auto* self = static_cast<NativeCamera*>(ctx);
+    CaptureResultInfo info;
+    ACameraMetadata_const_entry entry;
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_SENSOR_TIMESTAMP, &entry) != ACAMERA_OK) return;
+    info.timestampNs = entry.data.i64[0];
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_SENSOR_FRAME_DURATION, &entry) == ACAMERA_OK) {
+        info.frameDurationNs = entry.data.i64[0];
+    }
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_SENSOR_EXPOSURE_TIME, &entry) == ACAMERA_OK) {
+        info.exposureTimeNs = entry.data.i64[0];
+    }
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_SENSOR_SENSITIVITY, &entry) == ACAMERA_OK) {
+        info.sensitivity = entry.data.i32[0];
+    }
+    self->captureResults_.record(info);
+    self->lastResultNs_.store(info.timestampNs, std::memory_order_release);
+}
+
+void NativeCamera::releaseImage(void* image) {
+    AImage_delete(static_cast<AImage*>(image));
+}
 
 void NativeCamera::onImage(void* ctx, AImageReader* reader) {
-    AImage* img = nullptr;
-    if (AImageReader_acquireLatestImage(reader, &img) != AMEDIA_OK || !img)
+    auto* stream = static_cast<Stream*>(ctx);
+    AImage* image = nullptr;
+    if (AImageReader_acquireLatestImage(reader, &image) != AMEDIA_OK || !image)
         return;
 
-    gRenderer.submitFrame(img); // ✅ CORRECT
+    FrameHandle frame = stream->pool->acquire(image, &NativeCamera::releaseImage);
+    if (!frame) {
+        LOGD("Stream %d: no free frame slot, dropping an image", stream->index);
+        AImage_delete(image);
+        return;
+    }
+    frame->acquiredNs = monotonicNowNs();
+    frame->stream = stream->index;
+    // Back camera: the sensor is mounted sensorOrientation clockwise from the
+    // device's natural orientation, and the display has turned the other way.
+    frame->rotation = (stream->camera->sensorOrientation_ -
+                       stream->camera->displayRotation_.load(std::memory_order_relaxed) + 360) % 360;
+    AImage_getWidth(image, &frame->width);
+    AImage_getHeight(image, &frame->height);
+    AImage_getFormat(image, &frame->format);
+    AImage_getTimestamp(image, &frame->timestampNs);
+    // Whatever of the result is already in; Frame::captureResult() picks up
+    // the rest once it arrives.
+    frame->captureResults = &stream->camera->captureResults_;
+    stream->camera->captureResults_.find(frame->timestampNs, frame->capture);
+    int32_t planeCount = 0;
+    AImage_getNumberOfPlanes(image, &planeCount);
+    frame->planeCount = std::min<int>(planeCount, Frame::kMaxPlanes);
+    for (int i = 0; i < frame->planeCount; ++i) {
+        FramePlane& plane = frame->planes[i];
+        uint8_t* data = nullptr;
+        AImage_getPlaneData(image, i, &data, &plane.length);
+        AImage_getPlaneRowStride(image, i, &plane.rowStride);
+        AImage_getPlanePixelStride(image, i, &plane.pixelStride);
+        plane.data = data;
+    }
+    if (stream->hardwareBuffers) {
+        AHardwareBuffer* buffer = nullptr;
+        if (hardwareBufferApi().getHardwareBuffer(image, &buffer) == AMEDIA_OK) frame->hardwareBuffer = buffer;
+    }
+    // Frames are traced by timestamp, which every stream shares; the first
+    // stream (the preview) stands for the capture.
+    if (stream->index == 0) {
+        FrameTrace::record(TraceStage::Acquire, frame->timestampNs,
+                           stream->camera->sensorTimeIsBootTime_ ? bootTimeToMonotonicNs(frame->timestampNs)
+                                                                 : frame->acquiredNs);
+    }
+
+    if (stream->onFrame) stream->onFrame(std::move(frame));
 }
 
 
@@ -503,21 +427,21 @@ void NativeCamera::close() {
         ACaptureRequest_free(request_);
         request_ = nullptr;
     }
-    if (outputTarget_) {
-        ACameraOutputTarget_free(outputTarget_);
-        outputTarget_ = nullptr;
-    }
-    if (output_) {
-        ACaptureSessionOutput_free(output_);
-        output_ = nullptr;
+    for (auto& stream : streams_) {
+        if (stream->target) ACameraOutputTarget_free(stream->target);
+        if (stream->output) ACaptureSessionOutput_free(stream->output);
+        stream->target = nullptr;
+        stream->output = nullptr;
     }
     if (container_) {
         ACaptureSessionOutputContainer_free(container_);
         container_ = nullptr;
     }
-    if (reader_) {
-        AImageReader_delete(reader_);
-        reader_ = nullptr;
+    // The pools stay until the next open() so their stats can still be read.
+    for (auto& stream : streams_) {
+        if (stream->reader) AImageReader_delete(stream->reader);
+        stream->reader = nullptr;
+        stream->window = nullptr;
     }
     if (camera_) {
         ACameraDevice_close(camera_);
@@ -1,7 +1,92 @@
 #pragma once
 #include <camera/NdkCameraManager.h>
 #include <media/NdkImageReader.h>
-#include <functional>
-#include "Renderer.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FrameSource.h"
+#include "StreamSelector.h"
 
+// Camera2 NDK frame source: opens the first back-facing camera and streams
+// YUV_420_888 images from one AImageReader per requested stream, all targets
+// of the same repeating request. Each image is handed to its stream's
+// callback as a FrameHandle and deleted once the last handle lets go.
+// Streams with gpuSampled get GPU-sampleable buffers (API 26+; plain
+// readers below that) and their frames carry the AHardwareBuffer.
+class NativeCamera : public FrameSource {
+public:
+    ~NativeCamera() override { close(); }
 
+    using FrameSource::open;
+    bool open(const std::vector<StreamRequest>& streams) override;
+    void close() override;
+    // Rewrites the repeating request in place when the session is running.
+    // Same thread as open()/close().
+    CaptureControls setControls(const CaptureControls& controls) override;
+    CaptureResultInfo lastCapture() const override;
+
+    // YUV output sizes of the back camera and their frame rate limits, for
+    // choosing StreamConfig sizes before open(). Empty if there is no back
+    // camera. Read once and kept across open()/close().
+    const StreamSelector& streamSizes();
+
+    // How far the display is rotated from the device's natural orientation
+    // (0, 90, 180 or 270); frames are tagged with the rotation that makes
+    // them upright on it. Any thread.
+    void setDisplayRotation(int degrees) { displayRotation_.store(degrees, std::memory_order_relaxed); }
+
+    int streamCount() const { return int(streams_.size()); }
+    const FramePool* framePool(int stream = 0) const {
+        return stream < streamCount() ? streams_[stream]->pool.get() : nullptr;
+    }
+
+private:
+    // One session output: reader, its window and the objects that attach it
+    // to the session and the request.
+    struct Stream {
+        NativeCamera* camera = nullptr;
+        int index = 0;
+        StreamConfig config;
+        FrameCallback onFrame;
+        std::unique_ptr<FramePool> pool;
+        AImageReader* reader = nullptr;
+        ANativeWindow* window = nullptr;
+        ACaptureSessionOutput* output = nullptr;
+        ACameraOutputTarget* target = nullptr;
+        bool hardwareBuffers = false;  // reader created with GPU usage
+    };
+
+    static void onImage(void* ctx, AImageReader* reader);
+    static void releaseImage(void* image);
+    static void onCameraDisconnected(void* ctx, ACameraDevice*);
+    static void onCameraError(void* ctx, ACameraDevice*, int error);
+    static void onCaptureStarted(void* ctx, ACameraCaptureSession*, const ACaptureRequest*, int64_t timestampNs);
+    static void onCaptureCompleted(void* ctx, ACameraCaptureSession*, ACaptureRequest*, const ACameraMetadata* result);
+
+    // Finds the back camera and reads its static characteristics.
+    bool describeCamera();
+    bool openReader(Stream& stream);
+    void applyControls();
+    bool startRepeating();
+    bool setupCamera();
+
+    std::vector<std::unique_ptr<Stream>> streams_;
+    ACameraManager* manager_ = nullptr;
+    ACameraDevice* camera_ = nullptr;
+    ACameraCaptureSession* session_ = nullptr;
+    ACaptureRequest* request_ = nullptr;
+    ACaptureSessionOutputContainer* container_ = nullptr;
+    std::string cameraId_;
+    StreamSelector sizes_;
+    bool sensorTimeIsBootTime_ = false;
+    int sensorOrientation_ = 0;  // ACAMERA_SENSOR_ORIENTATION
+    CaptureCapabilities capabilities_;
+    CaptureControls requestedControls_;
+    CaptureControls controls_;  // as resolved for this camera
+    // Results of recent captures, for frames to join by timestamp.
+    CaptureResultTable captureResults_;
+    std::atomic<int64_t> lastResultNs_{0};
+    int64_t capturesStarted_ = 0;  // camera callback thread; numbers the captures
+    std::atomic<int> displayRotation_{0};
+};
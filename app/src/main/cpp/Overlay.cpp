@@ -0,0 +1,117 @@
+#include "Overlay.h"
+#include "InferenceStage.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The part of the frame the model saw, as fractions of the frame; the whole
+// frame for a result without a crop.
+struct CropFraction {
+    float x = 0, y = 0, width = 1, height = 1;
+};
+
+CropFraction cropOf(const InferenceResult& result) {
+    CropFraction crop;
+    if (result.frameWidth > 0 && result.frameHeight > 0 && result.crop.width > 0 && result.crop.height > 0) {
+        crop.x = float(result.crop.x) / result.frameWidth;
+        crop.y = float(result.crop.y) / result.frameHeight;
+        crop.width = float(result.crop.width) / result.frameWidth;
+        crop.height = float(result.crop.height) / result.frameHeight;
+    }
+    return crop;
+}
+
+uint8_t coverage(const float* scores, const MaskLayout& layout) {
+    if (layout.classes == 1) return uint8_t(std::clamp(scores[0], 0.0f, 1.0f) * 255.0f + 0.5f);
+    int best = 0;
+    for (int c = 1; c < layout.classes; ++c) {
+        if (scores[c] > scores[best]) best = c;
+    }
+    return best == layout.background ? 0 : 255;
+}
+
+}  // namespace
+
+uint32_t overlayClassColor(int classIndex) {
+    static const uint32_t kPalette[] = {
+            0xFFE6194B, 0xFF3CB44B, 0xFFFFE119, 0xFF4363D8, 0xFFF58231, 0xFF911EB4,
+            0xFF46F0F0, 0xFFF032E6, 0xFFBCF60C, 0xFFFABEBE, 0xFF008080, 0xFFE6BEFF,
+    };
+    constexpr int kColors = int(sizeof(kPalette) / sizeof(kPalette[0]));
+    return kPalette[((classIndex % kColors) + kColors) % kColors];
+}
+
+bool decodeSsdDetections(const InferenceResult& result, float minScore, Overlay& overlay) {
+    overlay.clear();
+    overlay.frameTimestampNs = result.frameTimestampNs;
+    // 4 box values, a class and a score per detection, and the count.
+    if (result.count < 7 || (result.count - 1) % 6 != 0) return false;
+    const int capacity = (result.count - 1) / 6;
+    const float* boxes = result.values.data();
+    const float* classes = boxes + 4 * capacity;
+    const float* scores = classes + capacity;
+    const int valid = std::min(capacity, std::max(0, int(scores[capacity])));
+    // Boxes are normalized to the crop the model saw; map them onto the frame.
+    const CropFraction crop = cropOf(result);
+    for (int i = 0; i < valid; ++i) {
+        if (scores[i] < minScore) continue;
+        const float* box = boxes + 4 * i;
+        OverlayBox out;
+        out.top = crop.y + std::clamp(box[0], 0.0f, 1.0f) * crop.height;
+        out.left = crop.x + std::clamp(box[1], 0.0f, 1.0f) * crop.width;
+        out.bottom = crop.y + std::clamp(box[2], 0.0f, 1.0f) * crop.height;
+        out.right = crop.x + std::clamp(box[3], 0.0f, 1.0f) * crop.width;
+        if (out.right <= out.left || out.bottom <= out.top) continue;
+        out.color = overlayClassColor(int(classes[i]));
+        overlay.boxes.push_back(out);
+    }
+    return true;
+}
+
+bool decodeSegmentationMask(const InferenceResult& result, const MaskLayout& layout, Overlay& overlay) {
+    overlay.clear();
+    overlay.frameTimestampNs = result.frameTimestampNs;
+    if (layout.width <= 0 || layout.height <= 0 || layout.classes <= 0 ||
+        result.count < layout.width * layout.height * layout.classes) {
+        return false;
+    }
+    // Cells at the output's pitch over the whole frame, so the crop gets one
+    // per output cell and the blend samples no coarser than the model saw.
+    const CropFraction crop = cropOf(result);
+    overlay.maskWidth = std::max(1, int(std::lround(layout.width / crop.width)));
+    overlay.maskHeight = std::max(1, int(std::lround(layout.height / crop.height)));
+    overlay.mask.resize(size_t(overlay.maskWidth) * overlay.maskHeight);
+    for (int y = 0; y < overlay.maskHeight; ++y) {
+        // Cell centres in crop coordinates, [0, 1) inside it.
+        const float v = ((y + 0.5f) / overlay.maskHeight - crop.y) / crop.height;
+        if (v < 0 || v >= 1) continue;
+        const int row = std::min(layout.height - 1, int(v * layout.height));
+        const float* scores = result.values.data() + size_t(row) * layout.width * layout.classes;
+        uint8_t* out = overlay.mask.data() + size_t(y) * overlay.maskWidth;
+        for (int x = 0; x < overlay.maskWidth; ++x) {
+            const float u = ((x + 0.5f) / overlay.maskWidth - crop.x) / crop.width;
+            if (u < 0 || u >= 1) continue;
+            const int column = std::min(layout.width - 1, int(u * layout.width));
+            out[x] = coverage(scores + size_t(column) * layout.classes, layout);
+        }
+    }
+    return true;
+}
+
+bool decodePoseKeypoints(const InferenceResult& result, float minScore, Overlay& overlay) {
+    overlay.clear();
+    overlay.frameTimestampNs = result.frameTimestampNs;
+    if (result.count < 3 || result.count % 3 != 0) return false;
+    const CropFraction crop = cropOf(result);
+    for (int i = 0; i < result.count / 3; ++i) {
+        const float* keypoint = result.values.data() + 3 * i;
+        if (keypoint[2] < minScore) continue;
+        OverlayPoint out;
+        out.y = crop.y + std::clamp(keypoint[0], 0.0f, 1.0f) * crop.height;
+        out.x = crop.x + std::clamp(keypoint[1], 0.0f, 1.0f) * crop.width;
+        out.color = overlayClassColor(i);
+        overlay.points.push_back(out);
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct InferenceResult;
+
+// What is drawn over one preview frame. Coordinates are normalized to the
+// camera frame as delivered, before rotation: x from 0 at the first column
+// to 1 past the last, y from 0 at the first row to 1 past the last. The
+// renderer applies the same rotation and scaling it gives the frame, so
+// overlays stay registered to the image in any orientation.
+//
+// Colors are 0xAARRGGBB; alpha is the overlay's opacity.
+
+struct OverlayBox {
+    float left, top, right, bottom;
+    uint32_t color;
+};
+
+struct OverlayPoint {
+    float x, y;
+    uint32_t color;
+};
+
+struct Overlay {
+    int64_t frameTimestampNs = 0;  // of the frame the results came from
+    std::vector<OverlayBox> boxes;
+    std::vector<OverlayPoint> points;
+    // Coverage mask, one byte per cell (0 clear, 255 fully maskColor),
+    // stretched over the whole frame. Empty for none.
+    int maskWidth = 0;
+    int maskHeight = 0;
+    std::vector<uint8_t> mask;
+    uint32_t maskColor = 0x8000C0FF;
+
+    // Keeps the capacity, so refilling every frame does not allocate.
+    void clear() {
+        boxes.clear();
+        points.clear();
+        maskWidth = maskHeight = 0;
+        mask.clear();
+    }
+};
+
+// Turns a model's output into an overlay; false if the output is not in the
+// form it expects. Runs on the render thread, once per new result.
+using OverlayDecoder = bool (*)(const InferenceResult& result, Overlay& overlay);
+
+// The TFLite detection postprocess outputs, flattened in tensor order as
+// InferenceModel::readOutputs() does: boxes[N][4] as ymin, xmin, ymax, xmax,
+// classes[N], scores[N], then the number of valid detections. Boxes are
+// normalized to the model input and are mapped through the result's crop
+// onto the frame; a result without one is taken to cover the whole frame.
+// Detections scoring below minScore are left out; each class gets its own
+// color.
+bool decodeSsdDetections(const InferenceResult& result, float minScore, Overlay& overlay);
+
+// A segmentation model's output, [height][width][classes] scores per cell.
+// One class is a foreground probability in [0, 1], drawn as partial
+// coverage; with several, a cell is covered when its best class is not
+// `background`.
+struct MaskLayout {
+    int width = 0;
+    int height = 0;
+    int classes = 1;
+    int background = 0;
+};
+
+// Fills overlay.mask from a segmentation output laid out as `layout`, with
+// one mask cell per output cell across the result's crop; the frame outside
+// the crop stays clear.
+bool decodeSegmentationMask(const InferenceResult& result, const MaskLayout& layout, Overlay& overlay);
+
+// Single-person pose keypoints as MoveNet emits them: [K][3] as y, x, score,
+// normalized to the model input and mapped through the result's crop.
+// Keypoints scoring below minScore are left out; each keypoint gets its own
+// color.
+bool decodePoseKeypoints(const InferenceResult& result, float minScore, Overlay& overlay);
+
+// A distinct, opaque color per class index.
+uint32_t overlayClassColor(int classIndex);
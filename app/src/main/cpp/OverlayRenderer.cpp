@@ -0,0 +1,201 @@
+#include "OverlayRenderer.h"
+#include <cstddef>
+#include <cstring>
+
+// Frame coordinates go through the same mapping as the preview quad: x to
+// -1..1, the first row to the top, then u_Transform. Points are grown to
+// their radius in pixels after the mapping, so they stay round.
+static const char* overlayVertexSrc = "#version 300 es\n"
+                                      "layout(location = 0) in vec2 a_Corner;\n"
+                                      "layout(location = 1) in vec4 a_Rect;\n"
+                                      "layout(location = 2) in vec4 a_Color;\n"
+                                      "layout(location = 3) in vec2 a_Shape;\n"
+                                      "uniform mat2 u_Transform;\n"
+                                      "uniform vec2 u_Viewport;\n"
+                                      "out vec2 v_Local;\n"
+                                      "out vec2 v_SizePx;\n"
+                                      "out vec4 v_Color;\n"
+                                      "flat out int v_Kind;\n"
+                                      "out float v_Width;\n"
+                                      "vec2 toClip(vec2 uv) {\n"
+                                      "    return u_Transform * vec2(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0);\n"
+                                      "}\n"
+                                      "void main() {\n"
+                                      "    v_Local = a_Corner;\n"
+                                      "    v_Color = a_Color;\n"
+                                      "    v_Kind = int(a_Shape.x);\n"
+                                      "    v_Width = a_Shape.y;\n"
+                                      "    if (v_Kind == 1) {\n"
+                                      "        vec2 offset = (a_Corner * 2.0 - 1.0) * a_Shape.y * 2.0 / u_Viewport;\n"
+                                      "        gl_Position = vec4(toClip(a_Rect.xy) + offset, 0.0, 1.0);\n"
+                                      "        v_SizePx = vec2(a_Shape.y * 2.0);\n"
+                                      "    } else {\n"
+                                      "        gl_Position = vec4(toClip(mix(a_Rect.xy, a_Rect.zw, a_Corner)), 0.0, 1.0);\n"
+                                      "        vec2 halfView = u_Viewport * 0.5;\n"
+                                      "        v_SizePx = vec2(length(u_Transform * vec2(2.0 * (a_Rect.z - a_Rect.x), 0.0) * halfView),\n"
+                                      "                        length(u_Transform * vec2(0.0, 2.0 * (a_Rect.w - a_Rect.y)) * halfView));\n"
+                                      "    }\n"
+                                      "}\n";
+
+// Kind 0 is a box outline of v_Width pixels inside the box edge, 1 a disc.
+static const char* overlayFragmentSrc = "#version 300 es\n"
+                                        "precision highp float;\n"
+                                        "in vec2 v_Local;\n"
+                                        "in vec2 v_SizePx;\n"
+                                        "in vec4 v_Color;\n"
+                                        "flat in int v_Kind;\n"
+                                        "in float v_Width;\n"
+                                        "out vec4 fragColor;\n"
+                                        "void main() {\n"
+                                        "    float coverage;\n"
+                                        "    if (v_Kind == 0) {\n"
+                                        "        vec2 edge = min(v_Local, 1.0 - v_Local) * v_SizePx;\n"
+                                        "        coverage = min(edge.x, edge.y) < v_Width ? 1.0 : 0.0;\n"
+                                        "    } else {\n"
+                                        "        coverage = length(v_Local * 2.0 - 1.0) <= 1.0 ? 1.0 : 0.0;\n"
+                                        "    }\n"
+                                        "    if (coverage <= 0.0) discard;\n"
+                                        "    fragColor = vec4(v_Color.rgb, v_Color.a * coverage);\n"
+                                        "}\n";
+
+bool OverlayRenderer::init(ShaderCache& shaders) {
+    program_ = shaders.program("overlay", overlayVertexSrc, overlayFragmentSrc);
+    if (!program_) return false;
+    glUseProgram(program_);
+    transformLocation_ = glGetUniformLocation(program_, "u_Transform");
+    viewportLocation_ = glGetUniformLocation(program_, "u_Viewport");
+
+    const GLfloat corners[] = {0, 0, 1, 0, 0, 1, 1, 1};
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+    glGenBuffers(1, &quadVbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glGenBuffers(1, &instanceVbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    const GLsizei stride = sizeof(Instance);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Instance, rect));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(Instance, color));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Instance, kind));
+    for (GLuint attribute = 1; attribute <= 3; ++attribute) glVertexAttribDivisor(attribute, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTextures(1, &maskTexture_);
+    glBindTexture(GL_TEXTURE_2D, maskTexture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    bufferBytes_ = 0;
+    instanceCount_ = 0;
+    maskWidth_ = maskHeight_ = 0;
+    hasMask_ = false;
+    return true;
+}
+
+void OverlayRenderer::release() {
+    if (maskTexture_) glDeleteTextures(1, &maskTexture_);
+    if (instanceVbo_) glDeleteBuffers(1, &instanceVbo_);
+    if (quadVbo_) glDeleteBuffers(1, &quadVbo_);
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    maskTexture_ = instanceVbo_ = quadVbo_ = vao_ = program_ = 0;
+    bufferBytes_ = 0;
+    instanceCount_ = 0;
+    maskWidth_ = maskHeight_ = 0;
+    hasMask_ = false;
+}
+
+void OverlayRenderer::setStyle(float lineWidthPx, float pointRadiusPx) {
+    lineWidthPx_ = lineWidthPx;
+    pointRadiusPx_ = pointRadiusPx;
+}
+
+OverlayRenderer::Instance OverlayRenderer::instance(float left, float top, float right, float bottom, uint32_t color,
+                                                    float kind, float size) {
+    Instance out;
+    out.rect[0] = left;
+    out.rect[1] = top;
+    out.rect[2] = right;
+    out.rect[3] = bottom;
+    out.color[0] = uint8_t(color >> 16);
+    out.color[1] = uint8_t(color >> 8);
+    out.color[2] = uint8_t(color);
+    out.color[3] = uint8_t(color >> 24);
+    out.kind = kind;
+    out.size = size;
+    return out;
+}
+
+void OverlayRenderer::uploadMask(const Overlay& overlay) {
+    glBindTexture(GL_TEXTURE_2D, maskTexture_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (overlay.maskWidth != maskWidth_ || overlay.maskHeight != maskHeight_) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, overlay.maskWidth, overlay.maskHeight, 0, GL_RED, GL_UNSIGNED_BYTE,
+                     overlay.mask.data());
+        maskWidth_ = overlay.maskWidth;
+        maskHeight_ = overlay.maskHeight;
+        ++maskAllocations_;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, maskWidth_, maskHeight_, GL_RED, GL_UNSIGNED_BYTE,
+                        overlay.mask.data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void OverlayRenderer::update(const Overlay& overlay) {
+    staging_.clear();
+    hasMask_ = overlay.maskWidth > 0 && overlay.maskHeight > 0 &&
+               overlay.mask.size() >= size_t(overlay.maskWidth) * overlay.maskHeight;
+    maskColor_ = overlay.maskColor;
+    if (hasMask_) uploadMask(overlay);
+    for (const OverlayBox& box : overlay.boxes) {
+        staging_.push_back(instance(box.left, box.top, box.right, box.bottom, box.color, kBox, lineWidthPx_));
+    }
+    for (const OverlayPoint& point : overlay.points) {
+        staging_.push_back(instance(point.x, point.y, point.x, point.y, point.color, kPoint, pointRadiusPx_));
+    }
+    instanceCount_ = int(staging_.size());
+    if (staging_.empty()) return;
+
+    const size_t bytes = staging_.size() * sizeof(Instance);
+    if (bytes > bufferBytes_) {
+        size_t grown = bufferBytes_ ? bufferBytes_ : 64 * sizeof(Instance);
+        while (grown < bytes) grown *= 2;
+        bufferBytes_ = grown;
+        ++bufferGrowths_;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    // Fresh storage for the same buffer object: the driver keeps the old
+    // contents alive for draws still in flight instead of stalling on them.
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bufferBytes_), nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, GLsizeiptr(bytes),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        std::memcpy(mapped, staging_.data(), bytes);
+        if (!glUnmapBuffer(GL_ARRAY_BUFFER)) instanceCount_ = 0;  // contents lost; skip until the next update
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(bytes), staging_.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OverlayRenderer::draw(const PreviewTransform& transform, int viewWidth, int viewHeight) {
+    if (instanceCount_ == 0 || viewWidth <= 0 || viewHeight <= 0) return;
+    glUseProgram(program_);
+    glUniformMatrix2fv(transformLocation_, 1, GL_FALSE, transform.matrix);
+    glUniform2f(viewportLocation_, float(viewWidth), float(viewHeight));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(vao_);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount_);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+}
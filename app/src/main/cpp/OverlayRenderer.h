@@ -0,0 +1,82 @@
+#pragma once
+#include <GLES3/gl3.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Overlay.h"
+#include "PreviewTransform.h"
+#include "ShaderCache.h"
+
+// Draws an Overlay over the preview in a single instanced draw call,
+// however many boxes and points it has. Every shape is an instance of one
+// unit quad: box outlines and round keypoints are cut out in the fragment
+// shader, boxes first, then points. The segmentation mask is only uploaded
+// here, into an R8 coverage texture: YuvConverter blends it while drawing
+// the frame (setMask()), so it needs no full-frame pass of its own and the
+// shapes land on top of it.
+//
+// The per-instance data lives in one vertex buffer that is kept for the
+// context's lifetime and orphaned on every update(), so a new overlay never
+// waits for the GPU to finish drawing the previous one. update() runs once
+// per inference result; draw() once per drawn frame, with the transform the
+// frame itself was drawn with.
+//
+// Every method needs the same GLES 3 context current.
+class OverlayRenderer {
+public:
+    bool init(ShaderCache& shaders);
+    void release();
+
+    // Box outline width and keypoint radius, in viewport pixels.
+    void setStyle(float lineWidthPx, float pointRadiusPx);
+
+    void update(const Overlay& overlay);
+    void clear() {
+        instanceCount_ = 0;
+        hasMask_ = false;
+    }
+    // Blends the overlay over whatever is in the framebuffer.
+    void draw(const PreviewTransform& transform, int viewWidth, int viewHeight);
+
+    // The last update()'s mask, 0 if it had none, and its color.
+    GLuint maskTexture() const { return hasMask_ ? maskTexture_ : 0; }
+    uint32_t maskColor() const { return maskColor_; }
+
+    int instances() const { return instanceCount_; }
+    // Times the instance buffer was reallocated, and the mask texture.
+    uint64_t bufferGrowths() const { return bufferGrowths_; }
+    uint64_t maskAllocations() const { return maskAllocations_; }
+
+private:
+    // Matches the attribute layout set up in init().
+    struct Instance {
+        float rect[4];     // left, top, right, bottom; a point's centre is left, top
+        uint8_t color[4];  // RGBA
+        float kind;        // kBox or kPoint
+        float size;        // line width or radius in pixels
+    };
+    static constexpr float kBox = 0, kPoint = 1;
+
+    static Instance instance(float left, float top, float right, float bottom, uint32_t color, float kind, float size);
+    void uploadMask(const Overlay& overlay);
+
+    GLuint program_ = 0;
+    GLuint vao_ = 0;
+    GLuint quadVbo_ = 0;
+    GLuint instanceVbo_ = 0;
+    GLuint maskTexture_ = 0;
+    GLint transformLocation_ = -1;
+    GLint viewportLocation_ = -1;
+
+    std::vector<Instance> staging_;
+    size_t bufferBytes_ = 0;
+    int instanceCount_ = 0;
+    int maskWidth_ = 0;
+    int maskHeight_ = 0;
+    bool hasMask_ = false;
+    uint32_t maskColor_ = 0;
+    float lineWidthPx_ = 4;
+    float pointRadiusPx_ = 6;
+    uint64_t bufferGrowths_ = 0;
+    uint64_t maskAllocations_ = 0;
+};
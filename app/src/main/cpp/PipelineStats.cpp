@@ -0,0 +1,102 @@
+#define LOG_TAG "PipelineStats"
+
+#include "PipelineStats.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+void StageStats::add(int64_t ns) {
+    samples_[count_ % kWindow] = ns;
+    ++count_;
+    sumNs_ += ns;
+    sumSquaresNs_ += double(ns) * ns;
+    maxNs_ = std::max(maxNs_, ns);
+}
+
+void StageStats::reset() {
+    count_ = 0;
+    sumNs_ = 0;
+    sumSquaresNs_ = 0.0;
+    maxNs_ = 0;
+}
+
+double StageStats::stddevNs() const {
+    if (count_ < 2) return 0.0;
+    const double mean = meanNs();
+    return std::sqrt(std::max(0.0, sumSquaresNs_ / count_ - mean * mean));
+}
+
+int64_t StageStats::percentileNs(double p) const {
+    size_t n = std::min<uint64_t>(count_, kWindow);
+    if (n == 0) return 0;
+    std::vector<int64_t> sorted(samples_, samples_ + n);
+    // Nearest-rank percentile.
+    size_t rank = size_t(std::clamp(std::ceil(p / 100.0 * n) - 1, 0.0, double(n - 1)));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+const char* pipelineStageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::Queue: return "queue";
+        case PipelineStage::Upload: return "upload";
+        case PipelineStage::Draw: return "draw";
+        case PipelineStage::Present: return "present";
+        case PipelineStage::Total: return "total";
+        default: return "?";
+    }
+}
+
+void PipelineStats::reset() {
+    for (StageStats& stage : stages) stage.reset();
+    resultStaleness.reset();
+    uploadWait.reset();
+    frameDuration.reset();
+    captureGaps = 0;
+    frameInterval.reset();
+    vsyncLatency.reset();
+    lateFrames = 0;
+    dropped = 0;
+    presented = 0;
+    firstPresentNs = lastPresentNs = 0;
+}
+
+double PipelineStats::fps() const {
+    if (presented < 2 || lastPresentNs <= firstPresentNs) return 0.0;
+    return (presented - 1) * 1e9 / double(lastPresentNs - firstPresentNs);
+}
+
+void PipelineStats::log() const {
+    LOGI("%llu frames presented, %.1f fps, %llu dropped", (unsigned long long)presented, fps(),
+         (unsigned long long)dropped);
+    if (frameInterval.count()) {
+        LOGI("frame time: mean %.3f  stddev %.3f  p99 %.3f  max %.3f ms", frameInterval.meanNs() / 1e6,
+             frameInterval.stddevNs() / 1e6, frameInterval.percentileNs(99) / 1e6, frameInterval.maxNs() / 1e6);
+    }
+    if (vsyncLatency.count()) {
+        LOGI("vsync to present: mean %.3f  p99 %.3f ms; %llu frames missed their refresh",
+             vsyncLatency.meanNs() / 1e6, vsyncLatency.percentileNs(99) / 1e6, (unsigned long long)lateFrames);
+    }
+    for (int i = 0; i < kStageCount; ++i) {
+        const StageStats& s = stages[i];
+        LOGI("%-8s n=%-7llu mean %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms",
+             pipelineStageName(PipelineStage(i)), (unsigned long long)s.count(), s.meanNs() / 1e6,
+             s.percentileNs(50) / 1e6, s.percentileNs(95) / 1e6, s.percentileNs(99) / 1e6,
+             s.maxNs() / 1e6);
+    }
+    if (resultStaleness.count()) {
+        LOGI("result staleness over %llu frames: mean %.3f  p50 %.3f  p95 %.3f  max %.3f ms",
+             (unsigned long long)resultStaleness.count(), resultStaleness.meanNs() / 1e6,
+             resultStaleness.percentileNs(50) / 1e6, resultStaleness.percentileNs(95) / 1e6,
+             resultStaleness.maxNs() / 1e6);
+    }
+    if (uploadWait.maxNs() > 0) {
+        LOGI("upload waited on the GPU: mean %.3f  p95 %.3f  max %.3f ms", uploadWait.meanNs() / 1e6,
+             uploadWait.percentileNs(95) / 1e6, uploadWait.maxNs() / 1e6);
+    }
+    if (frameDuration.count()) {
+        LOGI("sensor frame duration: mean %.3f  max %.3f ms; %llu captures skipped between presented frames",
+             frameDuration.meanNs() / 1e6, frameDuration.maxNs() / 1e6, (unsigned long long)captureGaps);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+// Latency samples for one pipeline stage. Keeps the most recent kWindow
+// samples for percentiles plus running totals; add() never allocates.
+// Not thread-safe: one writer, and readers only after the writer stopped.
+class StageStats {
+public:
+    static constexpr int kWindow = 4096;
+
+    void add(int64_t ns);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    double meanNs() const { return count_ ? double(sumNs_) / count_ : 0.0; }
+    // Over every sample, like meanNs().
+    double stddevNs() const;
+    int64_t maxNs() const { return maxNs_; }
+    // p in [0, 100], over the retained window.
+    int64_t percentileNs(double p) const;
+
+private:
+    int64_t samples_[kWindow] = {};
+    uint64_t count_ = 0;
+    int64_t sumNs_ = 0;
+    double sumSquaresNs_ = 0.0;
+    int64_t maxNs_ = 0;
+};
+
+enum class PipelineStage { Queue, Upload, Draw, Present, Total, Count };
+
+const char* pipelineStageName(PipelineStage stage);
+
+struct PipelineStats {
+    static constexpr int kStageCount = int(PipelineStage::Count);
+
+    StageStats stages[kStageCount];
+    // How far the inference result drawn with each frame lags that frame:
+    // the frame's sensor timestamp minus the result's source frame timestamp.
+    // Only frames drawn with a result count.
+    StageStats resultStaleness;
+    // Part of Upload spent blocked on a staging buffer the GPU was still
+    // reading (see RenderBackend::lastUploadWaitNs()).
+    StageStats uploadWait;
+    // Sensor frame duration of the presented frames whose capture result
+    // was in by the time they were drawn.
+    StageStats frameDuration;
+    // Captures between consecutive presented frames that were never
+    // presented, wherever they were lost: dropped by the sensor, the reader
+    // or the frame ring. Counted from result frame numbers.
+    uint64_t captureGaps = 0;
+    // Time between consecutive presents. Its spread is the jitter a viewer
+    // sees; a steady stream has a stddev near zero.
+    StageStats frameInterval;
+    // Paced only: from the vsync the frame was drawn on to its present.
+    StageStats vsyncLatency;
+    // Paced only: frames that presented more than a vsync period after the
+    // vsync they were drawn on, i.e. missed their refresh.
+    uint64_t lateFrames = 0;
+    // Frames that reached the ring but were never drawn: evicted by a newer
+    // one, or overtaken while the render thread was busy or waiting for vsync.
+    uint64_t dropped = 0;
+    uint64_t presented = 0;
+    int64_t firstPresentNs = 0;
+    int64_t lastPresentNs = 0;
+
+    StageStats& operator[](PipelineStage stage) { return stages[int(stage)]; }
+    const StageStats& operator[](PipelineStage stage) const { return stages[int(stage)]; }
+
+    void reset();
+    double fps() const;
+    // One line per stage: count, mean, p50/p95/p99, max (all in ms).
+    void log() const;
+};
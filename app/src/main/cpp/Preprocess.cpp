@@ -0,0 +1,442 @@
+#include "Preprocess.h"
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PREPROCESS_NEON 1
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#define PREPROCESS_X86 1
+#include <immintrin.h>
+#endif
+
+// Full-range BT.601 in 16.16 fixed point. Every kernel uses exactly these
+// products and floors them the same way, so all paths match the reference
+// bit for bit. (The products stay below 2^24, so float lanes hold them exactly.)
+static constexpr int kRV = 91881;
+static constexpr int kGU = 22554;
+static constexpr int kGV = 46802;
+static constexpr int kBU = 116130;
+
+static inline uint8_t clampByte(int v) {
+    return uint8_t(std::min(255, std::max(0, v)));
+}
+
+static inline void yuvToRgb(int y, int u, int v, uint8_t rgb[3]) {
+    u -= 128;
+    v -= 128;
+    rgb[0] = clampByte(y + ((kRV * v) >> 16));
+    rgb[1] = clampByte(y - ((kGU * u + kGV * v) >> 16));
+    rgb[2] = clampByte(y + ((kBU * u) >> 16));
+}
+
+// Source sample for output coordinate o: the centre of its footprint.
+static inline int sampleAt(int o, int out, int origin, int extent) {
+    return origin + int(((2 * int64_t(o) + 1) * extent) / (2 * int64_t(out)));
+}
+
+CropRect centerCrop(int frameWidth, int frameHeight, const TensorShape& shape) {
+    CropRect crop{0, 0, frameWidth, frameHeight};
+    if (shape.width <= 0 || shape.height <= 0) return crop;
+    if (int64_t(frameWidth) * shape.height > int64_t(frameHeight) * shape.width) {
+        crop.width = int(int64_t(frameHeight) * shape.width / shape.height);
+        crop.x = ((frameWidth - crop.width) / 2) & ~1;
+    } else {
+        crop.height = int(int64_t(frameWidth) * shape.height / shape.width);
+        crop.y = ((frameHeight - crop.height) / 2) & ~1;
+    }
+    return crop;
+}
+
+void preprocessReference(const Frame& frame, const CropRect& requested, const TensorShape& shape, void* dst) {
+    const CropRect crop = requested.width > 0 && requested.height > 0
+                          ? requested : centerCrop(frame.width, frame.height, shape);
+    const FramePlane& yp = frame.planes[0];
+    const FramePlane& up = frame.planes[1];
+    const FramePlane& vp = frame.planes[2];
+    const bool gray = shape.channels == 1 || frame.planeCount < 3;
+    auto* f32 = static_cast<float*>(dst);
+    auto* u8 = static_cast<uint8_t*>(dst);
+
+    for (int oy = 0; oy < shape.height; ++oy) {
+        const int sy = sampleAt(oy, shape.height, crop.y, crop.height);
+        for (int ox = 0; ox < shape.width; ++ox) {
+            const int sx = sampleAt(ox, shape.width, crop.x, crop.width);
+            const int y = yp.data[sy * yp.rowStride + sx * yp.pixelStride];
+            uint8_t rgb[3] = {uint8_t(y), uint8_t(y), uint8_t(y)};
+            if (!gray) {
+                const int u = up.data[(sy / 2) * up.rowStride + (sx / 2) * up.pixelStride];
+                const int v = vp.data[(sy / 2) * vp.rowStride + (sx / 2) * vp.pixelStride];
+                yuvToRgb(y, u, v, rgb);
+            }
+            const int out = (oy * shape.width + ox) * shape.channels;
+            for (int c = 0; c < shape.channels; ++c) {
+                const uint8_t value = rgb[std::min(c, 2)];
+                if (shape.type == TensorType::Float32)
+                    f32[out + c] = (value - shape.mean) * shape.scale;
+                else
+                    u8[out + c] = value;
+            }
+        }
+    }
+}
+
+namespace {
+
+// One output row's worth of source pointers and sampling tables.
+struct Row {
+    const uint8_t* y;
+    const uint8_t* u;
+    const uint8_t* v;
+    const int32_t* yCol;
+    const int32_t* cCol;
+    int width;
+    float mean;
+    float scale;
+};
+
+void rgbFloatScalar(const Row& r, int from, float* out) {
+    for (int x = from; x < r.width; ++x) {
+        uint8_t rgb[3];
+        yuvToRgb(r.y[r.yCol[x]], r.u[r.cCol[x]], r.v[r.cCol[x]], rgb);
+        for (int c = 0; c < 3; ++c) out[x * 3 + c] = (rgb[c] - r.mean) * r.scale;
+    }
+}
+
+void rgbU8Scalar(const Row& r, int from, uint8_t* out) {
+    for (int x = from; x < r.width; ++x) yuvToRgb(r.y[r.yCol[x]], r.u[r.cCol[x]], r.v[r.cCol[x]], out + x * 3);
+}
+
+void grayFloat(const Row& r, float* out) {
+    for (int x = 0; x < r.width; ++x) out[x] = (r.y[r.yCol[x]] - r.mean) * r.scale;
+}
+
+void grayU8(const Row& r, uint8_t* out) {
+    for (int x = 0; x < r.width; ++x) out[x] = r.y[r.yCol[x]];
+}
+
+#if PREPROCESS_X86
+
+inline __m128 floorPs(__m128 x) {
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+// Four pixels: gathers, converts, and leaves clamped 0..255 values in r/g/b.
+inline void convert4Sse2(const Row& row, int x, __m128& r, __m128& g, __m128& b) {
+    const int32_t* yc = row.yCol + x;
+    const int32_t* cc = row.cCol + x;
+    __m128 y = _mm_cvtepi32_ps(_mm_setr_epi32(row.y[yc[0]], row.y[yc[1]], row.y[yc[2]], row.y[yc[3]]));
+    __m128 u = _mm_cvtepi32_ps(_mm_setr_epi32(row.u[cc[0]] - 128, row.u[cc[1]] - 128,
+                                              row.u[cc[2]] - 128, row.u[cc[3]] - 128));
+    __m128 v = _mm_cvtepi32_ps(_mm_setr_epi32(row.v[cc[0]] - 128, row.v[cc[1]] - 128,
+                                              row.v[cc[2]] - 128, row.v[cc[3]] - 128));
+    const __m128 k = _mm_set1_ps(1.0f / 65536.0f);
+    const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(255.0f);
+    __m128 dr = floorPs(_mm_mul_ps(_mm_mul_ps(v, _mm_set1_ps(kRV)), k));
+    __m128 dg = floorPs(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(u, _mm_set1_ps(kGU)), _mm_mul_ps(v, _mm_set1_ps(kGV))), k));
+    __m128 db = floorPs(_mm_mul_ps(_mm_mul_ps(u, _mm_set1_ps(kBU)), k));
+    r = _mm_min_ps(_mm_max_ps(_mm_add_ps(y, dr), lo), hi);
+    g = _mm_min_ps(_mm_max_ps(_mm_sub_ps(y, dg), lo), hi);
+    b = _mm_min_ps(_mm_max_ps(_mm_add_ps(y, db), lo), hi);
+}
+
+// Interleaves four RGB pixels into 12 floats. Writes one float past the
+// end, so callers keep at least one pixel for the scalar tail.
+inline void storeRgb4(float* out, __m128 r, __m128 g, __m128 b) {
+    __m128 a = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    _mm_storeu_ps(out, r);
+    _mm_storeu_ps(out + 3, g);
+    _mm_storeu_ps(out + 6, b);
+    _mm_storeu_ps(out + 9, a);
+}
+
+inline void storeRgb4(uint8_t* out, __m128 r, __m128 g, __m128 b) {
+    alignas(16) int32_t ri[4], gi[4], bi[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(ri), _mm_cvttps_epi32(r));
+    _mm_store_si128(reinterpret_cast<__m128i*>(gi), _mm_cvttps_epi32(g));
+    _mm_store_si128(reinterpret_cast<__m128i*>(bi), _mm_cvttps_epi32(b));
+    for (int i = 0; i < 4; ++i) {
+        out[i * 3] = uint8_t(ri[i]);
+        out[i * 3 + 1] = uint8_t(gi[i]);
+        out[i * 3 + 2] = uint8_t(bi[i]);
+    }
+}
+
+void rgbFloatSse2(const Row& row, float* out) {
+    const __m128 mean = _mm_set1_ps(row.mean), scale = _mm_set1_ps(row.scale);
+    int x = 0;
+    for (; x + 4 < row.width; x += 4) {
+        __m128 r, g, b;
+        convert4Sse2(row, x, r, g, b);
+        storeRgb4(out + x * 3, _mm_mul_ps(_mm_sub_ps(r, mean), scale),
+                  _mm_mul_ps(_mm_sub_ps(g, mean), scale), _mm_mul_ps(_mm_sub_ps(b, mean), scale));
+    }
+    rgbFloatScalar(row, x, out);
+}
+
+void rgbU8Sse2(const Row& row, uint8_t* out) {
+    int x = 0;
+    for (; x + 4 <= row.width; x += 4) {
+        __m128 r, g, b;
+        convert4Sse2(row, x, r, g, b);
+        storeRgb4(out + x * 3, r, g, b);
+    }
+    rgbU8Scalar(row, x, out);
+}
+
+// AVX2 does the arithmetic eight lanes at a time; interleaving reuses the
+// SSE transpose on each half.
+__attribute__((target("avx2"))) inline void convert8Avx2(const Row& row, int x, __m256& r, __m256& g, __m256& b) {
+    alignas(16) uint8_t ys[16], us[16], vs[16];
+    for (int i = 0; i < 8; ++i) {
+        ys[i] = row.y[row.yCol[x + i]];
+        us[i] = row.u[row.cCol[x + i]];
+        vs[i] = row.v[row.cCol[x + i]];
+    }
+    const __m256i bias = _mm256_set1_epi32(128);
+    __m256 y = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ys))));
+    __m256 u = _mm256_cvtepi32_ps(_mm256_sub_epi32(
+            _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(us))), bias));
+    __m256 v = _mm256_cvtepi32_ps(_mm256_sub_epi32(
+            _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(vs))), bias));
+    const __m256 k = _mm256_set1_ps(1.0f / 65536.0f);
+    const __m256 lo = _mm256_setzero_ps(), hi = _mm256_set1_ps(255.0f);
+    __m256 dr = _mm256_floor_ps(_mm256_mul_ps(_mm256_mul_ps(v, _mm256_set1_ps(kRV)), k));
+    __m256 dg = _mm256_floor_ps(_mm256_mul_ps(
+            _mm256_add_ps(_mm256_mul_ps(u, _mm256_set1_ps(kGU)), _mm256_mul_ps(v, _mm256_set1_ps(kGV))), k));
+    __m256 db = _mm256_floor_ps(_mm256_mul_ps(_mm256_mul_ps(u, _mm256_set1_ps(kBU)), k));
+    r = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(y, dr), lo), hi);
+    g = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(y, dg), lo), hi);
+    b = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(y, db), lo), hi);
+}
+
+__attribute__((target("avx2"))) void rgbFloatAvx2(const Row& row, float* out) {
+    const __m256 mean = _mm256_set1_ps(row.mean), scale = _mm256_set1_ps(row.scale);
+    int x = 0;
+    for (; x + 8 < row.width; x += 8) {
+        __m256 r, g, b;
+        convert8Avx2(row, x, r, g, b);
+        r = _mm256_mul_ps(_mm256_sub_ps(r, mean), scale);
+        g = _mm256_mul_ps(_mm256_sub_ps(g, mean), scale);
+        b = _mm256_mul_ps(_mm256_sub_ps(b, mean), scale);
+        storeRgb4(out + x * 3, _mm256_castps256_ps128(r), _mm256_castps256_ps128(g), _mm256_castps256_ps128(b));
+        storeRgb4(out + x * 3 + 12, _mm256_extractf128_ps(r, 1), _mm256_extractf128_ps(g, 1),
+                  _mm256_extractf128_ps(b, 1));
+    }
+    rgbFloatScalar(row, x, out);
+}
+
+__attribute__((target("avx2"))) void rgbU8Avx2(const Row& row, uint8_t* out) {
+    int x = 0;
+    for (; x + 8 <= row.width; x += 8) {
+        __m256 r, g, b;
+        convert8Avx2(row, x, r, g, b);
+        alignas(32) int32_t ri[8], gi[8], bi[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(ri), _mm256_cvttps_epi32(r));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(gi), _mm256_cvttps_epi32(g));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(bi), _mm256_cvttps_epi32(b));
+        uint8_t* o = out + x * 3;
+        for (int i = 0; i < 8; ++i) {
+            o[i * 3] = uint8_t(ri[i]);
+            o[i * 3 + 1] = uint8_t(gi[i]);
+            o[i * 3 + 2] = uint8_t(bi[i]);
+        }
+    }
+    rgbU8Scalar(row, x, out);
+}
+
+#endif  // PREPROCESS_X86
+
+#if PREPROCESS_NEON
+
+// Eight pixels in exact 32-bit integer arithmetic, narrowed with saturation.
+inline uint8x8x3_t convert8Neon(const Row& row, int x) {
+    uint8_t ys[8], us[8], vs[8];
+    for (int i = 0; i < 8; ++i) {
+        ys[i] = row.y[row.yCol[x + i]];
+        us[i] = row.u[row.cCol[x + i]];
+        vs[i] = row.v[row.cCol[x + i]];
+    }
+    const int16x8_t bias = vdupq_n_s16(128);
+    int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ys)));
+    int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(us))), bias);
+    int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(vs))), bias);
+
+    int16x4_t halves[3][2];
+    for (int h = 0; h < 2; ++h) {
+        int32x4_t yh = vmovl_s16(h ? vget_high_s16(y) : vget_low_s16(y));
+        int32x4_t uh = vmovl_s16(h ? vget_high_s16(u) : vget_low_s16(u));
+        int32x4_t vh = vmovl_s16(h ? vget_high_s16(v) : vget_low_s16(v));
+        int32x4_t r = vaddq_s32(yh, vshrq_n_s32(vmulq_n_s32(vh, kRV), 16));
+        int32x4_t g = vsubq_s32(yh, vshrq_n_s32(vaddq_s32(vmulq_n_s32(uh, kGU), vmulq_n_s32(vh, kGV)), 16));
+        int32x4_t b = vaddq_s32(yh, vshrq_n_s32(vmulq_n_s32(uh, kBU), 16));
+        halves[0][h] = vmovn_s32(r);
+        halves[1][h] = vmovn_s32(g);
+        halves[2][h] = vmovn_s32(b);
+    }
+    uint8x8x3_t rgb;
+    rgb.val[0] = vqmovun_s16(vcombine_s16(halves[0][0], halves[0][1]));
+    rgb.val[1] = vqmovun_s16(vcombine_s16(halves[1][0], halves[1][1]));
+    rgb.val[2] = vqmovun_s16(vcombine_s16(halves[2][0], halves[2][1]));
+    return rgb;
+}
+
+void rgbU8Neon(const Row& row, uint8_t* out) {
+    int x = 0;
+    for (; x + 8 <= row.width; x += 8) vst3_u8(out + x * 3, convert8Neon(row, x));
+    rgbU8Scalar(row, x, out);
+}
+
+void rgbFloatNeon(const Row& row, float* out) {
+    const float32x4_t mean = vdupq_n_f32(row.mean);
+    int x = 0;
+    for (; x + 8 <= row.width; x += 8) {
+        uint8x8x3_t rgb = convert8Neon(row, x);
+        float32x4x3_t lo, hi;
+        for (int c = 0; c < 3; ++c) {
+            uint16x8_t wide = vmovl_u8(rgb.val[c]);
+            float32x4_t l = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)));
+            float32x4_t h = vcvtq_f32_u32(vmovl_u16(vget_high_u16(wide)));
+            lo.val[c] = vmulq_n_f32(vsubq_f32(l, mean), row.scale);
+            hi.val[c] = vmulq_n_f32(vsubq_f32(h, mean), row.scale);
+        }
+        vst3q_f32(out + x * 3, lo);
+        vst3q_f32(out + x * 3 + 12, hi);
+    }
+    rgbFloatScalar(row, x, out);
+}
+
+#endif  // PREPROCESS_NEON
+
+}  // namespace
+
+Preprocessor::Isa Preprocessor::bestIsa() {
+#if PREPROCESS_NEON
+    return Isa::Neon;
+#elif PREPROCESS_X86
+    return __builtin_cpu_supports("avx2") ? Isa::Avx2 : Isa::Sse2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+bool Preprocessor::supported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return true;
+#if PREPROCESS_NEON
+        case Isa::Neon: return true;
+#elif PREPROCESS_X86
+        case Isa::Sse2: return true;
+        case Isa::Avx2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+const char* Preprocessor::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse2: return "sse2";
+        case Isa::Avx2: return "avx2";
+        case Isa::Neon: return "neon";
+    }
+    return "?";
+}
+
+void Preprocessor::prepare(const Frame& frame, const TensorShape& shape) {
+    const CropRect crop = crop_.width > 0 && crop_.height > 0
+                          ? crop_ : centerCrop(frame.width, frame.height, shape);
+    const FramePlane& yp = frame.planes[0];
+    const FramePlane& cp = frame.planes[1];
+    if (frame.width == frameWidth_ && frame.height == frameHeight_ &&
+        yp.rowStride == yRowStride_ && yp.pixelStride == yPixelStride_ &&
+        cp.rowStride == cRowStride_ && cp.pixelStride == cPixelStride_ &&
+        shape.width == outWidth_ && shape.height == outHeight_ &&
+        crop.x == builtCrop_.x && crop.y == builtCrop_.y &&
+        crop.width == builtCrop_.width && crop.height == builtCrop_.height) {
+        return;
+    }
+    frameWidth_ = frame.width;
+    frameHeight_ = frame.height;
+    yRowStride_ = yp.rowStride;
+    yPixelStride_ = yp.pixelStride;
+    cRowStride_ = cp.rowStride;
+    cPixelStride_ = cp.pixelStride;
+    outWidth_ = shape.width;
+    outHeight_ = shape.height;
+    builtCrop_ = crop;
+
+    yCol_.resize(shape.width);
+    cCol_.resize(shape.width);
+    for (int x = 0; x < shape.width; ++x) {
+        const int sx = sampleAt(x, shape.width, crop.x, crop.width);
+        yCol_[x] = sx * yPixelStride_;
+        cCol_[x] = (sx / 2) * cPixelStride_;
+    }
+    yRow_.resize(shape.height);
+    cRow_.resize(shape.height);
+    for (int y = 0; y < shape.height; ++y) {
+        const int sy = sampleAt(y, shape.height, crop.y, crop.height);
+        yRow_[y] = sy * yRowStride_;
+        cRow_[y] = (sy / 2) * cRowStride_;
+    }
+}
+
+void Preprocessor::run(const Frame& frame, const TensorShape& shape, void* dst) {
+    if (shape.channels != 1 && shape.channels != 3) {
+        preprocessReference(frame, crop_, shape, dst);
+        return;
+    }
+    prepare(frame, shape);
+    const bool gray = shape.channels == 1 || frame.planeCount < 3;
+    const bool f32 = shape.type == TensorType::Float32;
+    const size_t rowElements = size_t(shape.width) * shape.channels;
+
+    Row row{};
+    row.yCol = yCol_.data();
+    row.cCol = cCol_.data();
+    row.width = shape.width;
+    row.mean = shape.mean;
+    row.scale = shape.scale;
+    for (int y = 0; y < shape.height; ++y) {
+        row.y = frame.planes[0].data + yRow_[y];
+        float* outF = static_cast<float*>(dst) + y * rowElements;
+        uint8_t* outU = static_cast<uint8_t*>(dst) + y * rowElements;
+        if (gray) {
+            if (shape.channels == 1) {
+                if (f32) grayFloat(row, outF); else grayU8(row, outU);
+            } else {
+                // Luma-only frame into an RGB model: replicate Y.
+                for (int x = 0; x < shape.width; ++x) {
+                    const uint8_t value = row.y[row.yCol[x]];
+                    for (int c = 0; c < 3; ++c) {
+                        if (f32) outF[x * 3 + c] = (value - row.mean) * row.scale;
+                        else outU[x * 3 + c] = value;
+                    }
+                }
+            }
+            continue;
+        }
+        row.u = frame.planes[1].data + cRow_[y];
+        row.v = frame.planes[2].data + cRow_[y];
+        switch (isa_) {
+#if PREPROCESS_X86
+            case Isa::Avx2:
+                if (f32) rgbFloatAvx2(row, outF); else rgbU8Avx2(row, outU);
+                break;
+            case Isa::Sse2:
+                if (f32) rgbFloatSse2(row, outF); else rgbU8Sse2(row, outU);
+                break;
+#endif
+#if PREPROCESS_NEON
+            case Isa::Neon:
+                if (f32) rgbFloatNeon(row, outF); else rgbU8Neon(row, outU);
+                break;
+#endif
+            default:
+                if (f32) rgbFloatScalar(row, 0, outF); else rgbU8Scalar(row, 0, outU);
+                break;
+        }
+    }
+}
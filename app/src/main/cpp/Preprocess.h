@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "FrameHandle.h"
+#include "InferenceModel.h"
+
+// Region of the source frame that is scaled into the model input.
+struct CropRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;   // 0 = whole frame
+    int height = 0;
+};
+
+// Largest centred crop of a frameWidth x frameHeight frame with the model's
+// aspect ratio, so the image is not stretched. Offsets are kept even so the
+// crop starts on a chroma sample.
+CropRect centerCrop(int frameWidth, int frameHeight, const TensorShape& shape);
+
+// Fused YUV_420_888 -> model input conversion: crop, nearest-neighbour
+// resize, full-range BT.601 to RGB (or luma only for 1-channel models) and
+// float normalization or uint8 output, in one pass written straight into the
+// input tensor. Reads the planes in place with any row/pixel stride; U and V
+// must share strides, as AImage guarantees.
+//
+// Sampling tables are rebuilt only when the frame geometry, strides or crop
+// change, so run() does not allocate on steady-state frames.
+class Preprocessor {
+public:
+    enum class Isa { Scalar, Sse2, Avx2, Neon };
+
+    Preprocessor() : isa_(bestIsa()) {}
+
+    // Fastest kernel this CPU supports.
+    static Isa bestIsa();
+    static bool supported(Isa isa);
+    static const char* isaName(Isa isa);
+
+    // For tests and benchmarks; ignored if the CPU lacks the ISA.
+    void setIsa(Isa isa) { isa_ = supported(isa) ? isa : Isa::Scalar; }
+    Isa isa() const { return isa_; }
+
+    // An empty crop means centerCrop() of each frame.
+    void setCrop(const CropRect& crop) { crop_ = crop; }
+
+    void run(const Frame& frame, const TensorShape& shape, void* dst);
+    // The part of the frame the last run() scaled into the model input.
+    const CropRect& lastCrop() const { return builtCrop_; }
+
+private:
+    void prepare(const Frame& frame, const TensorShape& shape);
+
+    Isa isa_;
+    CropRect crop_;
+
+    // What the tables were built for.
+    int frameWidth_ = 0, frameHeight_ = 0;
+    int yRowStride_ = 0, yPixelStride_ = 0, cRowStride_ = 0, cPixelStride_ = 0;
+    int outWidth_ = 0, outHeight_ = 0;
+    CropRect builtCrop_;
+
+    // Byte offsets of every output column/row's source sample in each plane.
+    std::vector<int32_t> yCol_, cCol_, yRow_, cRow_;
+};
+
+// Straightforward per-pixel implementation the kernels are checked against.
+void preprocessReference(const Frame& frame, const CropRect& crop, const TensorShape& shape, void* dst);
@@ -0,0 +1,28 @@
+#include "PreviewTransform.h"
+#include <algorithm>
+
+PreviewTransform previewTransform(int frameWidth, int frameHeight, int rotation, int viewWidth, int viewHeight,
+                                  ScaleMode mode) {
+    PreviewTransform t;
+    if (frameWidth <= 0 || frameHeight <= 0 || viewWidth <= 0 || viewHeight <= 0) return t;
+
+    const int quarterTurns = ((rotation / 90) % 4 + 4) % 4;
+    const bool swapped = quarterTurns % 2 == 1;
+    const double uprightWidth = swapped ? frameHeight : frameWidth;
+    const double uprightHeight = swapped ? frameWidth : frameHeight;
+    const double sx = viewWidth / uprightWidth, sy = viewHeight / uprightHeight;
+    const double scale = mode == ScaleMode::Fit ? std::min(sx, sy) : std::max(sx, sy);
+    // Half extents of the upright frame in normalized device coordinates.
+    const float ex = float(uprightWidth * scale / viewWidth);
+    const float ey = float(uprightHeight * scale / viewHeight);
+
+    // Clockwise rotation with y up: (x, y) -> (x cos + y sin, -x sin + y cos).
+    static const int kCos[4] = {1, 0, -1, 0};
+    static const int kSin[4] = {0, 1, 0, -1};
+    const int c = kCos[quarterTurns], s = kSin[quarterTurns];
+    t.matrix[0] = ex * c;
+    t.matrix[1] = -ey * s;
+    t.matrix[2] = ex * s;
+    t.matrix[3] = ey * c;
+    return t;
+}
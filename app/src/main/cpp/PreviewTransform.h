@@ -0,0 +1,18 @@
+#pragma once
+
+enum class ScaleMode {
+    Fit,   // whole frame visible, letterboxed
+    Fill,  // viewport covered, frame cropped
+};
+
+// Maps the unit quad (-1..1, first image row at the top) onto the viewport:
+// rotates the frame clockwise by `rotation` degrees (a multiple of 90) so it
+// is upright, then scales it to keep its aspect ratio. Applied in the vertex
+// shader as gl_Position.xy = matrix * position.
+struct PreviewTransform {
+    float matrix[4] = {1, 0, 0, 1};  // column-major mat2
+};
+
+// Identity (stretch to the viewport) while either size is still unknown.
+PreviewTransform previewTransform(int frameWidth, int frameHeight, int rotation, int viewWidth, int viewHeight,
+                                  ScaleMode mode = ScaleMode::Fit);
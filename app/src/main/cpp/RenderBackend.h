@@ -0,0 +1,29 @@
+#pragma once
+#include "FrameHandle.h"
+
+struct InferenceResult;
+
+// The GPU side of the pipeline. FramePipeline calls every method on its own
+// render thread: attach() once before the first frame, detach() after the last.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual bool attach() = 0;
+    virtual void detach() = 0;
+
+    // A backend that copies the pixels must be done with them by the time
+    // it returns. One that samples the buffer in place keeps a copy of the
+    // handle for as long as the GPU may still read it.
+    virtual void upload(const FrameHandle& frame) = 0;
+    // How long the last upload() blocked waiting for the GPU to release a
+    // staging buffer; 0 for backends that never wait.
+    virtual int64_t lastUploadWaitNs() const { return 0; }
+    virtual void draw() = 0;
+    virtual bool present() = 0;
+
+    // A newer inference result is available; called before draw(). Its
+    // frameTimestampNs against the uploaded frame's timestampNs is how stale
+    // it is.
+    virtual void onInferenceResult(const InferenceResult&) {}
+};
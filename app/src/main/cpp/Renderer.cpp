@@ -1,16 +1,17 @@
 // Updated Renderer.cpp to ensure EGL context and surface are current and safe before drawing
 
-#include "Renderer.h"
-#include <android/log.h>
-#include <EGL/egl.h>
-#include <GLES2/gl2.h>
-
 #define LOG_TAG "Renderer"
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
 
+#include "Renderer.h"
+#include "InferenceStage.h"
+#include "Log.h"
+#include "VideoEncoder.h"
 
-bool Renderer::init(ANativeWindow* window) {
+#ifndef EGL_OPENGL_ES3_BIT_KHR
+#define EGL_OPENGL_ES3_BIT_KHR 0x00000040
+#endif
+
+bool Renderer::init() {
     // 1. Get EGL display
     display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     if (display_ == EGL_NO_DISPLAY) {
@@ -24,24 +25,33 @@ bool Renderer::init(ANativeWindow* window) {
         return false;
     }
 
-    // 3. Choose EGL config
-    const EGLint configAttribs[] = {
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+    // 3. Choose EGL config; recordable if there is one, so the same context
+    // can also draw into a video encoder's input surface
+    EGLint configAttribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
             EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
             EGL_RED_SIZE, 8,
             EGL_GREEN_SIZE, 8,
             EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_RECORDABLE_ANDROID, EGL_TRUE,
             EGL_NONE
     };
-    EGLint numConfigs;
-    if (!eglChooseConfig(display_, configAttribs, &config_, 1, &numConfigs) || numConfigs == 0) {
-        LOGE("❌ Failed to choose EGL config");
-        return false;
+    EGLint numConfigs = 0;
+    recordable_ = eglChooseConfig(display_, configAttribs, &config_, 1, &numConfigs) && numConfigs > 0;
+    if (!recordable_) {
+        configAttribs[12] = EGL_NONE;  // drop EGL_RECORDABLE_ANDROID
+        if (!eglChooseConfig(display_, configAttribs, &config_, 1, &numConfigs) || numConfigs == 0) {
+            LOGE("❌ Failed to choose EGL config");
+            return false;
+        }
     }
+    presentationTime_ = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+            eglGetProcAddress("eglPresentationTimeANDROID"));
 
     // 4. Create EGL context
     const EGLint contextAttribs[] = {
-            EGL_CONTEXT_CLIENT_VERSION, 2,
+            EGL_CONTEXT_CLIENT_VERSION, 3,
             EGL_NONE
     };
     context_ = eglCreateContext(display_, config_, EGL_NO_CONTEXT, contextAttribs);
@@ -50,27 +60,9 @@ bool Renderer::init(ANativeWindow* window) {
         return false;
     }
 
-    // 5. Create EGL window surface
-    surface_ = eglCreateWindowSurface(display_, config_, window, nullptr);
-    if (surface_ == EGL_NO_SURFACE) {
-        LOGE("❌ Failed to create EGL surface");
-        return false;
-    }
-
-    // 6. Make EGL context current
-    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-        EGLint err = eglGetError();
-        LOGE("❌ eglMakeCurrent failed with error: 0x%x", err);
-        return false;
-    }
-
-    // 7. (Optional) Query width/height or set viewport
-    EGLint width, height;
-    eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
-    eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
-    glViewport(0, 0, width, height);
-
-    LOGI("✅ Renderer initialized: %dx%d", width, height);
+    // The window surface comes with setWindow(); the context is made current
+    // on the render thread in attach()
+    LOGI("✅ Renderer initialized");
     return true;
 }
 
@@ -85,24 +77,28 @@ bool Renderer::ensureCurrent() {
     return true;
 }
 
-void Renderer::setWindow(ANativeWindow* window) {
-    if (window == nullptr) return;
-
+bool Renderer::setWindow(ANativeWindow* window) {
     if (surface_ != EGL_NO_SURFACE) {
         eglDestroySurface(display_, surface_);
+        surface_ = EGL_NO_SURFACE;
     }
+    surfaceWidth_ = 0;
+    surfaceHeight_ = 0;
+    if (window == nullptr) return true;
 
     surface_ = eglCreateWindowSurface(display_, config_, window, nullptr);
     if (surface_ == EGL_NO_SURFACE) {
         EGLint err = eglGetError();
         LOGE("setWindow: Failed to create new surface: 0x%x", err);
-        return;
-    }
-
-    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-        EGLint err = eglGetError();
-        LOGE("setWindow: Failed to make new EGL surface current: 0x%x", err);
+        return false;
     }
+    EGLint width = 0, height = 0;
+    eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
+    eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
+    surfaceWidth_ = width;
+    surfaceHeight_ = height;
+    LOGI("Window surface: %dx%d", width, height);
+    return true;
 }
 
 /*
@@ -134,86 +130,198 @@ void Renderer::draw() {
     eglSwapBuffers(display_, surface_);
 }
 */
-void Renderer::submitFrame(AImage* image) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (latestImage_) {
-        AImage_delete(latestImage_);  // Drop old image if present
+bool Renderer::attach() {
+    if (surface_ == EGL_NO_SURFACE) {
+        LOGE("attach: no window surface");
+        return false;
     }
-    latestImage_ = image;
-    cv_.notify_one();
+    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+        LOGE("eglMakeCurrent failed in attach: 0x%x", eglGetError());
+        return false;
+    }
+    glViewport(0, 0, surfaceWidth_, surfaceHeight_);
+    if (!yuv_.init(shaders_)) return false;
+    yuv_.setViewport(surfaceWidth_, surfaceHeight_);
+    importEnabled_ = importer_.init(display_) && yuv_.initExternal(shaders_);
+    overlayReady_ = overlayDecoder_ && overlay_.init(shaders_);
+    if (overlayDecoder_ && !overlayReady_) LOGW("Overlay shaders failed; drawing results disabled");
+    createEncoderSurface();
+    shaders_.logStats();
+    return true;
 }
 
+void Renderer::createEncoderSurface() {
+    if (!encoder_ || !encoder_->window()) return;
+    if (!recordable_ || !presentationTime_) {
+        LOGW("No recordable EGL config or eglPresentationTimeANDROID; not encoding");
+        return;
+    }
+    encoderSurface_ = eglCreateWindowSurface(display_, config_, encoder_->window(), nullptr);
+    if (encoderSurface_ == EGL_NO_SURFACE) {
+        LOGE("Encoder surface: eglCreateWindowSurface failed: 0x%x", eglGetError());
+        return;
+    }
+    eglQuerySurface(display_, encoderSurface_, EGL_WIDTH, &encoderWidth_);
+    eglQuerySurface(display_, encoderSurface_, EGL_HEIGHT, &encoderHeight_);
+    // The swap interval belongs to the surface that is current when it is set.
+    if (eglMakeCurrent(display_, encoderSurface_, encoderSurface_, context_)) eglSwapInterval(display_, 0);
+    eglMakeCurrent(display_, surface_, surface_, context_);
+}
 
-void Renderer::startRenderLoop() {
-    running_ = true;
-    renderThread_ = std::thread([this]() {
-        while (running_) {
-            AImage* image = nullptr;
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                cv_.wait(lock, [this]() { return !running_ || latestImage_ != nullptr; });
-
-                if (!running_) break;
+void Renderer::destroyEncoderSurface() {
+    if (encoderSurface_ == EGL_NO_SURFACE) return;
+    eglDestroySurface(display_, encoderSurface_);
+    encoderSurface_ = EGL_NO_SURFACE;
+}
 
-                image = latestImage_;
-                latestImage_ = nullptr;  // Clear it once taken
-            }
+void Renderer::detach() {
+    retireSampled(true);
+    current_.reset();
+    LOGI("Imported %llu buffers, %llu frames sampled in place, %llu imports failed",
+         (unsigned long long)imports_.imports(), (unsigned long long)imports_.hits(),
+         (unsigned long long)imports_.failures());
+    imports_.clear();
+    yuv_.release();
+    overlay_.release();
+    overlayReady_ = false;
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    destroyEncoderSurface();
+}
 
-            if (image) {
-                draw();  // You can change this to uploadYUV(image); draw(); etc.
-                AImage_delete(image);
+void Renderer::retireSampled(bool all) {
+    int retired = 0;
+    while (retired < sampledCount_) {
+        Sampled& oldest = sampled_[retired];
+        const bool mustWait = all || sampledCount_ - retired >= kMaxSampled;
+        GLenum status = glClientWaitSync(oldest.fence, mustWait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                         mustWait ? 100000000 : 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            if (!mustWait) break;
+            // The image cannot go back to the reader, which would refill its
+            // buffer, while the GPU may still be reading it: keep waiting,
+            // and stop holding on to more of them.
+            if (importEnabled_) {
+                LOGW("GPU still sampling a camera buffer after 100 ms; uploading frames instead");
+                importEnabled_ = false;
             }
+            continue;
+        }
+        if (status == GL_WAIT_FAILED) {
+            LOGE("Waiting for a sampled frame failed: 0x%x; finishing the GPU's work instead", glGetError());
+            glFinish();
+            importEnabled_ = false;
         }
-    });
+        glDeleteSync(oldest.fence);
+        oldest.fence = nullptr;
+        oldest.frame.reset();
+        ++retired;
+    }
+    for (int i = retired; i < sampledCount_; ++i) sampled_[i - retired] = std::move(sampled_[i]);
+    sampledCount_ -= retired;
 }
 
-void Renderer::stopRenderLoop() {
-    running_ = false;
-    cv_.notify_all();
-    if (renderThread_.joinable())
-        renderThread_.join();
+void Renderer::upload(const FrameHandle& frame) {
+    retireSampled(false);
+    frameTimestampNs_ = frame->timestampNs;
+    if (importEnabled_ && frame->hardwareBuffer) {
+        if (GLuint texture = imports_.texture(frame->hardwareBuffer)) {
+            externalTexture_ = texture;
+            current_ = frame;
+            yuv_.setFrameGeometry(frame->width, frame->height, frame->rotation);
+            return;
+        }
+    }
+    externalTexture_ = 0;
+    yuv_.upload(*frame);
 }
 
-
 void Renderer::draw() {
     if (display_ == EGL_NO_DISPLAY || surface_ == EGL_NO_SURFACE || context_ == EGL_NO_CONTEXT) {
         LOGE("draw: Missing EGL display, surface, or context");
         return;
     }
 
-    // Make sure this thread is bound to the EGL context
-    if (eglGetCurrentContext() != context_ || eglGetCurrentSurface(EGL_DRAW) != surface_) {
-        if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-            EGLint err = eglGetError();
-            LOGE("draw: eglMakeCurrent failed with error: 0x%x", err);
-            return;
-        }
-    }
-
-    // Get actual surface dimensions
+    // The window can be resized (rotation, split screen) under a live surface.
     EGLint width = 0, height = 0;
     eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
     eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
-    LOGI("draw: surface dimensions = %d x %d", width, height);
+    if (width != surfaceWidth_ || height != surfaceHeight_) {
+        LOGI("draw: surface resized to %d x %d", width, height);
+        surfaceWidth_ = width;
+        surfaceHeight_ = height;
+        glViewport(0, 0, width, height);
+        yuv_.setViewport(width, height);
+    }
 
-    // Set viewport and clear color
-    glViewport(0, 0, width, height);
-    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);  // Red background
+    drawFrame(surfaceWidth_, surfaceHeight_);
+}
+
+void Renderer::drawFrame(int width, int height) {
+    glClearColor(0.0, 0.0, 1.0, 1.0);
     glClear(GL_COLOR_BUFFER_BIT);
+    if (externalTexture_) {
+        yuv_.drawExternal(externalTexture_);
+    } else {
+        yuv_.draw();
+    }
+    overlay_.draw(yuv_.transform(), width, height);
+}
 
-    // Present frame
-    if (!eglSwapBuffers(display_, surface_)) {
-        EGLint err = eglGetError();
-        LOGI("draw: eglSwapBuffers failed with error: 0x%x", err);
+bool Renderer::present() {
+    const bool swapped = eglSwapBuffers(display_, surface_);
+    if (!swapped) LOGE("present: eglSwapBuffers failed with error: 0x%x", eglGetError());
+    encode();
+    // The fence goes in after the encoder's draw too: both read the frame.
+    if (externalTexture_ && current_) {
+        Sampled& sampled = sampled_[sampledCount_++];
+        sampled.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        sampled.frame = std::move(current_);
+    }
+    return swapped;
+}
+
+void Renderer::encode() {
+    if (encoderSurface_ == EGL_NO_SURFACE || !encoder_->throttle().admit(frameTimestampNs_)) return;
+    if (!eglMakeCurrent(display_, encoderSurface_, encoderSurface_, context_)) {
+        LOGE("encode: eglMakeCurrent failed: 0x%x", eglGetError());
+        encoder_->throttle().cancel();
+        ensureCurrent();
+        return;
+    }
+    glViewport(0, 0, encoderWidth_, encoderHeight_);
+    yuv_.setViewport(encoderWidth_, encoderHeight_);
+    drawFrame(encoderWidth_, encoderHeight_);
+    // Sensor time, so the video keeps the camera's pacing and lines up with
+    // anything else stamped from the same clock.
+    presentationTime_(display_, encoderSurface_, frameTimestampNs_);
+    if (!eglSwapBuffers(display_, encoderSurface_)) {
+        LOGE("encode: eglSwapBuffers failed: 0x%x", eglGetError());
+        encoder_->throttle().cancel();
+    }
+    ensureCurrent();
+    glViewport(0, 0, surfaceWidth_, surfaceHeight_);
+    yuv_.setViewport(surfaceWidth_, surfaceHeight_);
+}
+
+void Renderer::onInferenceResult(const InferenceResult& result) {
+    resultSequence_ = result.sequence;
+    resultTimestampNs_ = result.frameTimestampNs;
+    if (!overlayReady_) return;
+    if (overlayDecoder_(result, overlayData_)) {
+        overlay_.update(overlayData_);
     } else {
-        LOGI("draw: frame swapped successfully");
+        overlay_.clear();
     }
+    // The mask is blended in as the frame is drawn, not in the overlay pass.
+    yuv_.setMask(overlay_.maskTexture(), overlay_.maskColor());
 }
 
 
 void Renderer::shutdown() {
     if (display_ != EGL_NO_DISPLAY) {
         eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        // Destroying the context deletes its programs.
+        shaders_.abandon();
         if (context_ != EGL_NO_CONTEXT) eglDestroyContext(display_, context_);
         if (surface_ != EGL_NO_SURFACE) eglDestroySurface(display_, surface_);
         eglTerminate(display_);
@@ -1,10 +1,126 @@
 #pragma once
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
-#include <media/NdkImage.h>
 #include <EGL/egl.h>
-#include <GLES2/gl2.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
 #include <android/native_window.h>
+#include "BufferImportCache.h"
+#include "EglImageImporter.h"
+#include "Overlay.h"
+#include "OverlayRenderer.h"
+#include "RenderBackend.h"
+#include "ShaderCache.h"
+#include "YuvConverter.h"
 
+class VideoEncoder;
+
+// EGL/GLES 3 preview renderer. init()/shutdown() run on the UI thread and own
+// the EGL objects; the RenderBackend calls run on the pipeline's render thread,
+// which is the only thread the context is ever current on.
+//
+// The context does not depend on a window: setWindow() swaps the window
+// surface while the pipeline is stopped, so a new window keeps the context
+// and the programs linked in it.
+//
+// Frames backed by an AHardwareBuffer are sampled in place through a cached
+// EGLImage; the renderer then holds the frame until a fence says the GPU has
+// finished reading it. Anything else is uploaded through YuvConverter.
+//
+// With an encoder set, each presented frame the encoder's throttle admits is
+// drawn a second time into the encoder's input surface, stamped with the
+// frame's sensor timestamp. That happens after the preview swap, so encoding
+// can only ever skip video frames, not delay the preview.
+//
+// With an overlay decoder set, each new inference result is decoded into an
+// Overlay and drawn over every frame until the next one arrives, in the
+// video as well as the preview.
+class Renderer : public RenderBackend {
+public:
+    // Display, config and context; no window yet.
+    bool init();
+    void shutdown();
+
+    bool ensureCurrent();
+    // The window to draw into from the next attach(), replacing the last
+    // one; nullptr only lets go of it. UI thread, with the pipeline stopped.
+    bool setWindow(ANativeWindow* window);
+
+    bool attach() override;
+    void detach() override;
+    void upload(const FrameHandle& frame) override;
+    int64_t lastUploadWaitNs() const override { return externalTexture_ ? 0 : yuv_.lastUploadWaitNs(); }
+    void draw() override;
+    bool present() override;
+    void onInferenceResult(const InferenceResult& result) override;
+
+    // Camera2 YUV is full-range BT.601 unless the stream says otherwise.
+    // Render thread only, or before the pipeline starts.
+    void setColorSpace(YuvMatrix matrix, YuvRange range) { yuv_.setColorSpace(matrix, range); }
+    // Staging PBOs for frames that are uploaded, 0 for direct
+    // glTexSubImage2D. Before the pipeline starts.
+    void setUploadBuffers(int count) { yuv_.setUploadBuffers(count); }
+    void setScaleMode(ScaleMode mode) { yuv_.setScaleMode(mode); }
+    // Started (or nullptr); its input surface is picked up by attach(), so
+    // set it before the pipeline starts and stop it after the pipeline has.
+    void setEncoder(VideoEncoder* encoder) { encoder_ = encoder; }
+    // Where linked shader programs are saved between runs (an existing
+    // directory); none are saved without one. Before init().
+    void setShaderCacheDirectory(std::string directory) { shaders_.setDirectory(std::move(directory)); }
+    // nullptr draws no overlay. Before the pipeline starts.
+    void setOverlayDecoder(OverlayDecoder decoder) { overlayDecoder_ = decoder; }
+
+private:
+    // In-place frames the GPU may still be reading: the one being drawn and
+    // the one before it.
+    static constexpr int kMaxSampled = 2;
+
+    // Hands back frames whose fence has signalled; waits for the oldest if
+    // the limit is reached, for as long as it takes, since the camera would
+    // refill a buffer the GPU is still reading.
+    void retireSampled(bool all);
+    // Clears the bound surface and draws the current frame and the overlay
+    // into it.
+    void drawFrame(int width, int height);
+    void createEncoderSurface();
+    void destroyEncoderSurface();
+    // Draws the current frame into the encoder's surface if the throttle
+    // lets it through, then makes the preview surface current again.
+    void encode();
+
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    EGLConfig  config_ = nullptr;
+    bool recordable_ = false;  // config_ can draw into a video encoder's surface
+
+    // Programs live as long as context_, across attach()/detach().
+    ShaderCache shaders_;
+    YuvConverter yuv_;
+    EglImageImporter importer_;
+    BufferImportCache imports_{importer_};
+    bool importEnabled_ = false;
+    OverlayRenderer overlay_;
+    Overlay overlayData_;
+    OverlayDecoder overlayDecoder_ = nullptr;
+    bool overlayReady_ = false;
+    GLuint externalTexture_ = 0;  // 0 when the current frame was uploaded
+    FrameHandle current_;
+    struct Sampled {
+        GLsync fence = nullptr;
+        FrameHandle frame;
+    };
+    Sampled sampled_[kMaxSampled];
+    int sampledCount_ = 0;
+
+    int surfaceWidth_ = 0;
+    int surfaceHeight_ = 0;
+    int64_t frameTimestampNs_ = 0;
+
+    VideoEncoder* encoder_ = nullptr;
+    EGLSurface encoderSurface_ = EGL_NO_SURFACE;
+    int encoderWidth_ = 0;
+    int encoderHeight_ = 0;
+    PFNEGLPRESENTATIONTIMEANDROIDPROC presentationTime_ = nullptr;
+
+    uint64_t resultSequence_ = 0;
+    int64_t resultTimestampNs_ = 0;
+};
@@ -0,0 +1,218 @@
+#define LOG_TAG "ShaderCache"
+
+#include "ShaderCache.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Precedes the driver's bytes in a saved binary.
+struct BinaryHeader {
+    static constexpr uint32_t kMagic = 0x4e494250;  // "PBIN"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;     // driver and sources
+    uint32_t format;  // as glGetProgramBinary reported it
+    uint32_t length;
+};
+
+// FNV-1a; collisions only cost a rejected binary and a recompile.
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+uint64_t hashString(const char* text, uint64_t hash) {
+    // The terminator too, so "ab" + "c" and "a" + "bc" differ.
+    return text ? hashBytes(text, std::strlen(text) + 1, hash) : hashBytes("", 1, hash);
+}
+
+GLuint compile(GLenum type, const char* src) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, 512, nullptr, log);
+        LOGE("Shader compile failed: %s", log);
+    }
+    return shader;
+}
+
+GLuint link(const char* vertexSrc, const char* fragmentSrc, bool retrievable) {
+    GLuint vs = compile(GL_VERTEX_SHADER, vertexSrc);
+    GLuint fs = compile(GL_FRAGMENT_SHADER, fragmentSrc);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    if (retrievable) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint linkOK = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkOK);
+    if (!linkOK) {
+        char log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        LOGE("Program link failed: %s", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool readAll(int fd, void* data, size_t size) {
+    auto* out = static_cast<uint8_t*>(data);
+    while (size) {
+        const ssize_t n = read(fd, out, size);
+        if (n <= 0) return false;
+        out += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const auto* in = static_cast<const uint8_t*>(data);
+    while (size) {
+        const ssize_t n = write(fd, in, size);
+        if (n <= 0) return false;
+        in += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+uint64_t ShaderCache::driverHash() {
+    if (!driverHash_) {
+        uint64_t hash = hashBytes(&BinaryHeader::kVersion, sizeof(BinaryHeader::kVersion));
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            hash = hashString(reinterpret_cast<const char*>(glGetString(name)), hash);
+        }
+        driverHash_ = hash;
+    }
+    return driverHash_;
+}
+
+GLuint ShaderCache::program(const char* name, const char* vertexSrc, const char* fragmentSrc) {
+    ++stats_.requests;
+    auto it = programs_.find(name);
+    if (it != programs_.end()) return it->second;
+
+    GLint formats = 0;
+    if (!directory_.empty()) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    const bool persist = formats > 0;
+    const std::string path = directory_ + "/" + name + ".glbin";
+    const uint64_t key = hashString(fragmentSrc, hashString(vertexSrc, driverHash()));
+
+    if (persist) {
+        const int64_t startNs = monotonicNowNs();
+        if (GLuint program = load(path, key)) {
+            const int64_t elapsedNs = monotonicNowNs() - startNs;
+            stats_.loadNs += elapsedNs;
+            ++stats_.loaded;
+            LOGI("%s: loaded binary in %.2f ms", name, elapsedNs / 1e6);
+            programs_.emplace(name, program);
+            return program;
+        }
+    }
+
+    const int64_t startNs = monotonicNowNs();
+    GLuint program = link(vertexSrc, fragmentSrc, persist);
+    if (!program) return 0;
+    // Linking can finish lazily; the first query of its status waits for it,
+    // so the time includes the whole build.
+    const int64_t elapsedNs = monotonicNowNs() - startNs;
+    stats_.compileNs += elapsedNs;
+    ++stats_.compiled;
+    LOGI("%s: compiled from source in %.2f ms", name, elapsedNs / 1e6);
+    if (persist) save(path, key, program);
+    programs_.emplace(name, program);
+    return program;
+}
+
+GLuint ShaderCache::load(const std::string& path, uint64_t key) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;  // not saved yet
+    BinaryHeader header;
+    std::vector<uint8_t> binary;
+    bool ok = readAll(fd, &header, sizeof(header)) && header.magic == BinaryHeader::kMagic &&
+              header.version == BinaryHeader::kVersion && header.key == key && header.length > 0;
+    if (ok) {
+        binary.resize(header.length);
+        ok = readAll(fd, binary.data(), binary.size());
+    }
+    ::close(fd);
+
+    GLuint program = 0;
+    if (ok) {
+        program = glCreateProgram();
+        glProgramBinary(program, GLenum(header.format), binary.data(), GLsizei(binary.size()));
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (!program) {
+        ++stats_.rejected;
+        LOGI("%s is stale or was refused by the driver; rebuilding it", path.c_str());
+    }
+    return program;
+}
+
+void ShaderCache::save(const std::string& path, uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<uint8_t> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    BinaryHeader header;
+    header.magic = BinaryHeader::kMagic;
+    header.version = BinaryHeader::kVersion;
+    header.key = key;
+    header.format = format;
+    header.length = uint32_t(written);
+    // Written aside and renamed over, so a reader never sees half a file.
+    const std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGW("open %s: %s", temp.c_str(), strerror(errno));
+        return;
+    }
+    const bool ok = writeAll(fd, &header, sizeof(header)) && writeAll(fd, binary.data(), size_t(written));
+    ::close(fd);
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        LOGW("Saving %s: %s", path.c_str(), strerror(errno));
+        unlink(temp.c_str());
+    }
+}
+
+void ShaderCache::release() {
+    for (auto& entry : programs_) glDeleteProgram(entry.second);
+    programs_.clear();
+}
+
+void ShaderCache::logStats() const {
+    LOGI("Programs: %d requested, %d compiled in %.1f ms, %d loaded from binaries in %.1f ms, %d binaries rejected",
+         stats_.requests, stats_.compiled, stats_.compileNs / 1e6, stats_.loaded, stats_.loadNs / 1e6,
+         stats_.rejected);
+}
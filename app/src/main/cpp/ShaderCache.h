@@ -0,0 +1,57 @@
+#pragma once
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Linked GLSL programs for one GL context. Each program is built once per
+// context however many times it is asked for, and its linked binary is
+// saved (glGetProgramBinary) to a directory so the next process can load it
+// with glProgramBinary instead of compiling. A saved binary is keyed by a
+// hash of the driver (GL_VENDOR, GL_RENDERER, GL_VERSION) and the sources:
+// after a driver update or a shader edit, or when the driver rejects it, the
+// program is compiled from source and the file rewritten.
+//
+// The cache owns the programs. Every method needs its context current.
+class ShaderCache {
+public:
+    struct Stats {
+        int requests = 0;
+        int compiled = 0;        // built from source
+        int loaded = 0;          // from a saved binary
+        int rejected = 0;        // saved binaries that were stale or refused
+        int64_t compileNs = 0;   // spent compiling and linking
+        int64_t loadNs = 0;      // spent loading binaries
+    };
+
+    // Where binaries are kept; empty (the default) keeps nothing on disk.
+    // The directory must exist.
+    void setDirectory(std::string directory) { directory_ = std::move(directory); }
+
+    // The program linked from the two sources, 0 (logged) if they do not
+    // compile or link. `name` identifies the program across runs: one file
+    // per name, so it must be unique within the app.
+    GLuint program(const char* name, const char* vertexSrc, const char* fragmentSrc);
+
+    // Deletes every program.
+    void release();
+    // Forgets every program without a GL call, for when the context has
+    // been or is about to be destroyed (which deletes them).
+    void abandon() {
+        programs_.clear();
+        driverHash_ = 0;
+    }
+
+    const Stats& stats() const { return stats_; }
+    void logStats() const;
+
+private:
+    GLuint load(const std::string& path, uint64_t key);
+    void save(const std::string& path, uint64_t key, GLuint program);
+    uint64_t driverHash();
+
+    std::string directory_;
+    std::unordered_map<std::string, GLuint> programs_;
+    uint64_t driverHash_ = 0;
+    Stats stats_;
+};
@@ -0,0 +1,81 @@
+#include "StreamSelector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int32_t kOutput = 0;  // ACAMERA_SCALER_AVAILABLE_STREAM_CONFIGURATIONS_OUTPUT
+
+int64_t area(const StreamSize& size) { return int64_t(size.width) * size.height; }
+
+}  // namespace
+
+StreamSelector::StreamSelector(const int32_t* configurations, size_t configurationCount, const int64_t* durations,
+                               size_t durationCount, int format) {
+    for (size_t i = 0; i + 3 < configurationCount; i += 4) {
+        if (configurations[i] != format || configurations[i + 3] != kOutput) continue;
+        StreamSize size;
+        size.width = configurations[i + 1];
+        size.height = configurations[i + 2];
+        if (find(size.width, size.height)) continue;
+        sizes_.push_back(size);
+    }
+    for (size_t i = 0; i + 3 < durationCount; i += 4) {
+        if (durations[i] != format) continue;
+        for (StreamSize& size : sizes_) {
+            if (size.width == durations[i + 1] && size.height == durations[i + 2]) {
+                size.minFrameDurationNs = durations[i + 3];
+            }
+        }
+    }
+    std::sort(sizes_.begin(), sizes_.end(), [](const StreamSize& a, const StreamSize& b) {
+        return area(a) != area(b) ? area(a) > area(b) : a.width > b.width;
+    });
+}
+
+StreamSize StreamSelector::find(int width, int height) const {
+    for (const StreamSize& size : sizes_) {
+        if (size.width == width && size.height == height) return size;
+    }
+    return {};
+}
+
+StreamSize StreamSelector::select(const SizeTarget& target) const {
+    std::vector<StreamSize> candidates;
+    for (const StreamSize& size : sizes_) {
+        // A size without a listed duration is not known to be too slow.
+        if (target.minFps > 0 && size.minFrameDurationNs > 0 && size.maxFps() < target.minFps * 0.99) continue;
+        candidates.push_back(size);
+    }
+    if (candidates.empty()) return {};
+
+    // Narrow to the best group on the primary criterion, with some slack so
+    // 1920x1080 and 1280x720 count as the same shape.
+    auto keepBest = [&candidates](auto cost, double slack) {
+        double best = cost(candidates.front());
+        for (const StreamSize& size : candidates) best = std::min(best, cost(size));
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                        [&](const StreamSize& size) { return cost(size) > best + slack; }),
+                         candidates.end());
+    };
+    if (target.fastest) {
+        // Unknown durations lose to any listed one.
+        keepBest([](const StreamSize& size) {
+            return size.minFrameDurationNs > 0 ? double(size.minFrameDurationNs)
+                                               : std::numeric_limits<double>::max();
+        }, 0.0);
+    }
+    if (target.aspect > 0) {
+        keepBest([&target](const StreamSize& size) {
+            return std::abs(std::log(double(size.width) / size.height / target.aspect));
+        }, 0.01);
+    }
+
+    // Candidates are largest first: the last covering one is the smallest.
+    const StreamSize* covering = nullptr;
+    for (const StreamSize& size : candidates) {
+        if (size.width >= target.width && size.height >= target.height) covering = &size;
+    }
+    return covering ? *covering : candidates.front();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FrameSource.h"
+
+// An output size the camera can stream, with the shortest frame duration it
+// supports at that size.
+struct StreamSize {
+    int width = 0;
+    int height = 0;
+    int64_t minFrameDurationNs = 0;  // 0 if the camera lists none
+
+    explicit operator bool() const { return width > 0 && height > 0; }
+    // Frame rate ceiling at this size; 0 if unknown.
+    double maxFps() const { return minFrameDurationNs > 0 ? 1e9 / minFrameDurationNs : 0.0; }
+};
+
+// What a stream needs from its size.
+struct SizeTarget {
+    int width = 0;  // smallest useful size, e.g. the model input or the preview
+    int height = 0;
+    // Preferred width / height, e.g. the preview's so the model sees the same
+    // field of view. 0 takes any.
+    double aspect = 0.0;
+    // Sizes that cannot stream this fast are never picked. 0 takes any.
+    double minFps = 0.0;
+    // Prefer the highest frame rate over the best-fitting size.
+    bool fastest = false;
+};
+
+// Picks stream sizes from what the sensor actually offers, so the ISP scales
+// from its native modes instead of an arbitrary size it may reject.
+class StreamSelector {
+public:
+    StreamSelector() = default;
+    // Raw ACameraMetadata entries: ACAMERA_SCALER_AVAILABLE_STREAM_CONFIGURATIONS
+    // as (format, width, height, isInput) quadruples and
+    // ACAMERA_SCALER_AVAILABLE_MIN_FRAME_DURATIONS as (format, width, height,
+    // durationNs). `count`s are in values, not quadruples. Only output sizes
+    // in `format` are kept.
+    StreamSelector(const int32_t* configurations, size_t configurationCount, const int64_t* durations,
+                   size_t durationCount, int format = kFormatYuv420);
+
+    // Largest first.
+    const std::vector<StreamSize>& sizes() const { return sizes_; }
+    bool empty() const { return sizes_.empty(); }
+    // The listed size, or an empty one if the camera does not offer it.
+    StreamSize find(int width, int height) const;
+
+    // Among sizes fast enough for target.minFps, those closest to
+    // target.aspect (or, with target.fastest, those with the shortest frame
+    // duration); then the smallest one covering width x height, else the
+    // largest one below it. Empty if no size is fast enough.
+    StreamSize select(const SizeTarget& target) const;
+
+private:
+    std::vector<StreamSize> sizes_;
+};
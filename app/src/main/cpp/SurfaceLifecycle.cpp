@@ -0,0 +1,59 @@
+#define LOG_TAG "SurfaceLifecycle"
+
+#include "SurfaceLifecycle.h"
+#include "Log.h"
+
+bool SurfaceLifecycle::onWindowCreated(ANativeWindow* window) {
+    if (state_ == State::Running) {
+        // A new window without the old one's destroy: let go of the old one.
+        host_.detachWindow();
+        state_ = State::Suspended;
+    }
+    if (state_ == State::Suspended) {
+        deadlineNs_ = -1;
+        if (host_.attachWindow(window)) {
+            state_ = State::Running;
+            ++warmResumes_;
+            return true;
+        }
+        LOGW("Running session could not take the new window; restarting it");
+        stop();
+    }
+
+    if (!host_.startSession(window) || !host_.attachWindow(window)) {
+        host_.stopSession();
+        return false;
+    }
+    state_ = State::Running;
+    ++coldStarts_;
+    return true;
+}
+
+void SurfaceLifecycle::onWindowDestroyed(int64_t nowNs) {
+    if (state_ != State::Running) return;
+    host_.detachWindow();
+    state_ = State::Suspended;
+    if (graceNs_ <= 0) {
+        stop();
+        return;
+    }
+    deadlineNs_ = nowNs + graceNs_;
+}
+
+void SurfaceLifecycle::poll(int64_t nowNs) {
+    if (state_ != State::Suspended || nowNs < deadlineNs_) return;
+    LOGI("No window for %.1f s; stopping the session", graceNs_ / 1e9);
+    ++expired_;
+    stop();
+}
+
+void SurfaceLifecycle::onDestroy() {
+    if (state_ == State::Running) host_.detachWindow();
+    if (state_ != State::Stopped) stop();
+}
+
+void SurfaceLifecycle::stop() {
+    host_.stopSession();
+    state_ = State::Stopped;
+    deadlineNs_ = -1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+
+struct ANativeWindow;
+
+// The app side of a SurfaceLifecycle. A session is everything that can
+// outlive a window (GL context, camera, inference); attaching a window starts
+// drawing into it.
+class LifecycleHost {
+public:
+    virtual ~LifecycleHost() = default;
+
+    // Brings the session up; `window` is the one about to be attached, for
+    // anything sized after it. False if any of it failed.
+    virtual bool startSession(ANativeWindow* window) = 0;
+    // Also follows a failed startSession(), so it must cope with a session
+    // that is only partly up.
+    virtual void stopSession() = 0;
+    // Starts drawing into `window`; false if it cannot be drawn into, or if
+    // the session has nothing left to draw (its camera was lost).
+    virtual bool attachWindow(ANativeWindow* window) = 0;
+    // Stops drawing and lets go of the window before returning.
+    virtual void detachWindow() = 0;
+};
+
+// Keeps a session alive while its window comes and goes. When the window is
+// destroyed only the drawing stops; a new window within the grace period is
+// attached to the running session, which costs a surface, not a camera
+// open and a context. Once the grace period runs out the session is stopped
+// and the next window starts it from scratch.
+//
+// Every call comes from one thread, the one delivering window events; the
+// caller owns the clock and calls poll() at deadlineNs().
+class SurfaceLifecycle {
+public:
+    enum class State { Stopped, Running, Suspended };
+
+    static constexpr int64_t kDefaultGraceNs = 3000000000;
+
+    explicit SurfaceLifecycle(LifecycleHost& host, int64_t graceNs = kDefaultGraceNs)
+        : host_(host), graceNs_(graceNs) {}
+
+    // True if the window is being drawn into. A window the running session
+    // cannot take costs it a restart.
+    bool onWindowCreated(ANativeWindow* window);
+    void onWindowDestroyed(int64_t nowNs);
+    // Stops a suspended session whose grace period has run out by `nowNs`.
+    void poll(int64_t nowNs);
+    // The app is going away: stops everything, suspended or not.
+    void onDestroy();
+
+    State state() const { return state_; }
+    // When poll() next has something to do; -1 for never.
+    int64_t deadlineNs() const { return deadlineNs_; }
+
+    uint64_t coldStarts() const { return coldStarts_; }
+    uint64_t warmResumes() const { return warmResumes_; }
+    uint64_t expired() const { return expired_; }
+
+private:
+    void stop();
+
+    LifecycleHost& host_;
+    int64_t graceNs_;
+    State state_ = State::Stopped;
+    int64_t deadlineNs_ = -1;
+    uint64_t coldStarts_ = 0;
+    uint64_t warmResumes_ = 0;
+    uint64_t expired_ = 0;  // sessions stopped by the grace period running out
+};
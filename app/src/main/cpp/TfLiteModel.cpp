@@ -0,0 +1,169 @@
+#define LOG_TAG "TfLiteModel"
+
+#include "TfLiteModel.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <algorithm>
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+
+std::unique_ptr<TfLiteModel> TfLiteModel::load(const char* path, int numThreads,
+                                               const InputNormalization& normalization) {
+    int64_t startNs = monotonicNowNs();
+    std::unique_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file) {
+        LOGE("Failed to load model %s", path);
+        return nullptr;
+    }
+    return fromMapping(std::move(file), path, numThreads, normalization, monotonicNowNs() - startNs);
+}
+
+std::unique_ptr<TfLiteModel> TfLiteModel::load(int fd, off_t offset, size_t length, const char* name,
+                                               int numThreads, const InputNormalization& normalization) {
+    int64_t startNs = monotonicNowNs();
+    std::unique_ptr<MappedFile> file = MappedFile::map(fd, offset, length);
+    if (!file) {
+        LOGE("Failed to load model %s", name);
+        return nullptr;
+    }
+    return fromMapping(std::move(file), name, numThreads, normalization, monotonicNowNs() - startNs);
+}
+
+std::unique_ptr<TfLiteModel> TfLiteModel::fromMapping(std::unique_ptr<MappedFile> file, const char* name,
+                                                      int numThreads, const InputNormalization& normalization,
+                                                      int64_t mapNs) {
+    ModelLoadTimes times;
+    times.mapNs = mapNs;
+    int64_t startNs = monotonicNowNs();
+    // Points into the mapping; nothing is copied.
+    std::shared_ptr<tflite::FlatBufferModel> model =
+            tflite::FlatBufferModel::BuildFromBuffer(file->data(), file->size());
+    if (!model) {
+        LOGE("%s is not a TFLite flatbuffer", name);
+        return nullptr;
+    }
+    times.buildNs = monotonicNowNs() - startNs;
+    return build(std::move(file), std::move(model), name, numThreads, normalization, times);
+}
+
+std::unique_ptr<TfLiteModel> TfLiteModel::clone(int numThreads) const {
+    InputNormalization normalization;
+    normalization.mean = input_.mean;
+    normalization.scale = input_.scale;
+    return build(file_, model_, name_.c_str(), numThreads, normalization, ModelLoadTimes());
+}
+
+std::unique_ptr<TfLiteModel> TfLiteModel::build(std::shared_ptr<MappedFile> file,
+                                                std::shared_ptr<tflite::FlatBufferModel> model,
+                                                const char* name, int numThreads,
+                                                const InputNormalization& normalization, ModelLoadTimes times) {
+    std::unique_ptr<TfLiteModel> self(new TfLiteModel());
+    self->file_ = std::move(file);
+    self->model_ = std::move(model);
+    self->name_ = name;
+
+    int64_t startNs = monotonicNowNs();
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    if (tflite::InterpreterBuilder(*self->model_, resolver)(&self->interpreter_) != kTfLiteOk ||
+        !self->interpreter_) {
+        LOGE("Failed to build interpreter for %s", name);
+        return nullptr;
+    }
+    self->interpreter_->SetNumThreads(numThreads);
+    int64_t builtNs = monotonicNowNs();
+    if (self->interpreter_->AllocateTensors() != kTfLiteOk) {
+        LOGE("AllocateTensors failed for %s", name);
+        return nullptr;
+    }
+    times.buildNs += builtNs - startNs;
+    times.allocateNs = monotonicNowNs() - builtNs;
+    self->times_ = times;
+
+    const TfLiteTensor* input = self->interpreter_->input_tensor(0);
+    if (!input || input->dims->size != 4 || input->dims->data[0] != 1 ||
+        (input->type != kTfLiteFloat32 && input->type != kTfLiteUInt8)) {
+        LOGE("Unsupported input tensor in %s", name);
+        return nullptr;
+    }
+    for (size_t i = 0; i < self->interpreter_->outputs().size(); ++i) {
+        const TfLiteTensor* output = self->interpreter_->output_tensor(i);
+        if (output->type != kTfLiteFloat32 && output->type != kTfLiteUInt8 && output->type != kTfLiteInt8) {
+            LOGE("Output %zu of %s has unsupported type %d", i, name, int(output->type));
+            return nullptr;
+        }
+        int elements = 1;
+        for (int d = 0; d < output->dims->size; ++d) elements *= output->dims->data[d];
+        self->outputValues_ += elements;
+    }
+    TensorShape& shape = self->input_;
+    shape.height = input->dims->data[1];
+    shape.width = input->dims->data[2];
+    shape.channels = input->dims->data[3];
+    shape.type = input->type == kTfLiteFloat32 ? TensorType::Float32 : TensorType::UInt8;
+    shape.mean = normalization.mean;
+    shape.scale = normalization.scale;
+    self->inputData_ = input->data.raw;
+
+    if (shape.type == TensorType::Float32) {
+        LOGI("Loaded %s: input %dx%dx%d float32 as (pixel - %.2f) * %.6f, %zu outputs (%d values), %d threads",
+             name, shape.width, shape.height, shape.channels, shape.mean, shape.scale,
+             self->interpreter_->outputs().size(), self->outputValues_, numThreads);
+    } else {
+        LOGI("Loaded %s: input %dx%dx%d uint8, %zu outputs (%d values), %d threads", name, shape.width,
+             shape.height, shape.channels, self->interpreter_->outputs().size(), self->outputValues_, numThreads);
+    }
+    return self;
+}
+
+TfLiteModel::~TfLiteModel() = default;
+
+bool TfLiteModel::invoke() {
+    int64_t startNs = invoked_ ? 0 : monotonicNowNs();
+    if (interpreter_->Invoke() != kTfLiteOk) {
+        LOGE("Invoke failed");
+        return false;
+    }
+    if (!invoked_) {
+        invoked_ = true;
+        times_.firstInvokeNs = monotonicNowNs() - startNs;
+    }
+    return true;
+}
+
+void TfLiteModel::logLoadTimes() const {
+    LOGI("%s: map %.2f  build %.2f  allocate %.2f  first invoke %.2f ms", name_.c_str(), times_.mapNs / 1e6,
+         times_.buildNs / 1e6, times_.allocateNs / 1e6, times_.firstInvokeNs / 1e6);
+}
+
+int TfLiteModel::outputCount() const { return int(interpreter_->outputs().size()); }
+
+std::vector<int> TfLiteModel::outputDims(int index) const {
+    const TfLiteTensor* tensor = interpreter_->output_tensor(size_t(index));
+    return std::vector<int>(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+}
+
+int TfLiteModel::readOutputs(float* dst, int capacity) const {
+    int written = 0;
+    for (size_t i = 0; i < interpreter_->outputs().size() && written < capacity; ++i) {
+        const TfLiteTensor* tensor = interpreter_->output_tensor(i);
+        int elements = 1;
+        for (int d = 0; d < tensor->dims->size; ++d) elements *= tensor->dims->data[d];
+        const int n = std::min(elements, capacity - written);
+        if (tensor->type == kTfLiteFloat32) {
+            std::copy(tensor->data.f, tensor->data.f + n, dst + written);
+        } else {
+            // build() let nothing else through: a skipped tensor would shift
+            // every later one in dst.
+            const float scale = tensor->params.scale;
+            const int zeroPoint = tensor->params.zero_point;
+            if (tensor->type == kTfLiteUInt8) {
+                for (int k = 0; k < n; ++k) dst[written + k] = (tensor->data.uint8[k] - zeroPoint) * scale;
+            } else {
+                for (int k = 0; k < n; ++k) dst[written + k] = (tensor->data.int8[k] - zeroPoint) * scale;
+            }
+        }
+        written += n;
+    }
+    return written;
+}
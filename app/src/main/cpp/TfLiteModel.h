@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "InferenceModel.h"
+#include "MappedFile.h"
+
+namespace tflite {
+class FlatBufferModel;
+class Interpreter;
+}
+
+// Where the time to a first result goes, per interpreter.
+struct ModelLoadTimes {
+    int64_t mapNs = 0;         // mmap of the flatbuffer (0 for clones)
+    int64_t buildNs = 0;       // FlatBufferModel + InterpreterBuilder
+    int64_t allocateNs = 0;    // AllocateTensors
+    int64_t firstInvokeNs = 0; // first Invoke, which also prepares kernels
+};
+
+// InferenceModel backed by one tflite::Interpreter. The flatbuffer is mmapped,
+// never copied to the heap. Tensors are allocated once in load(); invoke()
+// reuses them for every frame. Several interpreters can share one mapped
+// model (see clone()), so a worker pool pays for the weights once.
+class TfLiteModel : public InferenceModel {
+public:
+    // Returns nullptr (and logs why) if the model cannot be loaded or its first
+    // input is not a 1xHxWxC float32/uint8 image, or an output is not
+    // float32, uint8 or int8. `normalization` is what a
+    // float input is fed; it is the model's to know, the file does not say.
+    static std::unique_ptr<TfLiteModel> load(const char* path, int numThreads,
+                                             const InputNormalization& normalization = {});
+    // A model stored at [offset, offset + length) of fd, such as an
+    // uncompressed APK asset from AAsset_openFileDescriptor(). `name` is for logs.
+    static std::unique_ptr<TfLiteModel> load(int fd, off_t offset, size_t length, const char* name,
+                                             int numThreads, const InputNormalization& normalization = {});
+    // Another interpreter over the same FlatBufferModel, with its own tensors
+    // and thread count and the same normalization, for running on a
+    // different thread.
+    std::unique_ptr<TfLiteModel> clone(int numThreads) const;
+    ~TfLiteModel() override;
+
+    const TensorShape& inputShape() const override { return input_; }
+    void* inputData() override { return inputData_; }
+    bool invoke() override;
+    int outputValues() const override { return outputValues_; }
+    int readOutputs(float* dst, int capacity) const override;
+
+    int outputCount() const;
+    // Dimensions of output `index`, outermost first, for telling what kind of
+    // model this is from what it produces.
+    std::vector<int> outputDims(int index) const;
+
+    const ModelLoadTimes& loadTimes() const { return times_; }
+    void logLoadTimes() const;
+
+private:
+    TfLiteModel() = default;
+    static std::unique_ptr<TfLiteModel> fromMapping(std::unique_ptr<MappedFile> file, const char* name,
+                                                    int numThreads, const InputNormalization& normalization,
+                                                    int64_t mapNs);
+    static std::unique_ptr<TfLiteModel> build(std::shared_ptr<MappedFile> file,
+                                              std::shared_ptr<tflite::FlatBufferModel> model,
+                                              const char* name, int numThreads,
+                                              const InputNormalization& normalization, ModelLoadTimes times);
+
+    // Destroyed bottom-up: the interpreter before the model, the model before
+    // the mapping it points into.
+    std::shared_ptr<MappedFile> file_;
+    std::shared_ptr<tflite::FlatBufferModel> model_;
+    std::string name_;
+    std::unique_ptr<tflite::Interpreter> interpreter_;
+    TensorShape input_;
+    void* inputData_ = nullptr;
+    int outputValues_ = 0;
+    ModelLoadTimes times_;
+    bool invoked_ = false;
+};
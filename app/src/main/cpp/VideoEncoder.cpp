@@ -0,0 +1,200 @@
+#define LOG_TAG "VideoEncoder"
+
+#include "VideoEncoder.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <cerrno>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kMime = "video/avc";
+// MediaCodecInfo.CodecCapabilities.COLOR_FormatSurface
+constexpr int32_t kColorFormatSurface = 0x7F000789;
+constexpr int64_t kDequeueTimeoutUs = 10000;
+// How long stop() waits for the codec to flush its last frames.
+constexpr int64_t kEndOfStreamTimeoutNs = 2000000000;
+// Frame intervals without output, with frames inside the codec, before the
+// throttle gives up on them.
+constexpr int64_t kStallFrames = 15;
+constexpr int64_t kStallNsWithoutFps = 500000000;
+
+// The input surface calls are API 26, past minSdk.
+struct InputSurfaceApi {
+    media_status_t (*createInputSurface)(AMediaCodec*, ANativeWindow**) = nullptr;
+    media_status_t (*signalEndOfInputStream)(AMediaCodec*) = nullptr;
+
+    InputSurfaceApi() {
+        if (void* mediandk = dlopen("libmediandk.so", RTLD_NOW)) {
+            createInputSurface = reinterpret_cast<decltype(createInputSurface)>(
+                    dlsym(mediandk, "AMediaCodec_createInputSurface"));
+            signalEndOfInputStream = reinterpret_cast<decltype(signalEndOfInputStream)>(
+                    dlsym(mediandk, "AMediaCodec_signalEndOfInputStream"));
+        }
+    }
+    bool available() const { return createInputSurface && signalEndOfInputStream; }
+};
+
+const InputSurfaceApi& inputSurfaceApi() {
+    static const InputSurfaceApi api;
+    return api;
+}
+
+}  // namespace
+
+bool VideoEncoder::start(const char* path, const VideoEncoderConfig& config) {
+    stop();
+    const InputSurfaceApi& api = inputSurfaceApi();
+    if (!api.available()) {
+        LOGW("Video encoding needs API 26; not recording");
+        return false;
+    }
+
+    fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOGE("open %s: %s", path, strerror(errno));
+        return false;
+    }
+    path_ = path;
+    muxer_ = AMediaMuxer_new(fd_, AMEDIAMUXER_OUTPUT_FORMAT_MPEG_4);
+    codec_ = AMediaCodec_createEncoderByType(kMime);
+    if (!muxer_ || !codec_) {
+        LOGE("No %s", muxer_ ? "H.264 encoder" : "MP4 muxer");
+        release();
+        return false;
+    }
+
+    AMediaFormat* format = AMediaFormat_new();
+    AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, kMime);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, config.width);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, config.height);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, config.bitrate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, config.fps);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, config.iFrameIntervalS);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, kColorFormatSurface);
+    // No reordering: each frame comes out before the next has to go in, so
+    // the throttle's in-flight count is a true measure of how far behind
+    // the codec is. Ignored where unsupported.
+    AMediaFormat_setInt32(format, "max-bframes", 0);
+    media_status_t status = AMediaCodec_configure(codec_, format, nullptr, nullptr, AMEDIACODEC_CONFIGURE_FLAG_ENCODE);
+    AMediaFormat_delete(format);
+    if (status != AMEDIA_OK) {
+        LOGE("Configuring a %dx%d %s encoder failed: %d", config.width, config.height, kMime, status);
+        release();
+        return false;
+    }
+    if ((status = api.createInputSurface(codec_, &window_)) != AMEDIA_OK || !window_) {
+        LOGE("AMediaCodec_createInputSurface failed: %d", status);
+        window_ = nullptr;
+        release();
+        return false;
+    }
+    if ((status = AMediaCodec_start(codec_)) != AMEDIA_OK) {
+        LOGE("AMediaCodec_start failed: %d", status);
+        release();
+        return false;
+    }
+
+    throttle_ = std::make_unique<EncoderThrottle>(config.maxInFlight, config.fps > 0 ? 1000000000 / config.fps : 0);
+    stallNs_ = config.fps > 0 ? kStallFrames * 1000000000 / config.fps : kStallNsWithoutFps;
+    ending_ = false;
+    track_ = -1;
+    muxing_ = false;
+    bytes_ = 0;
+    thread_ = std::thread(&VideoEncoder::drain, this);
+    LOGI("Encoding %dx%d at %d fps, %.1f Mbit/s to %s", config.width, config.height, config.fps,
+         config.bitrate / 1e6, path);
+    return true;
+}
+
+void VideoEncoder::stop() {
+    if (!codec_) return;
+    if (thread_.joinable()) {
+        ending_.store(true, std::memory_order_release);
+        if (inputSurfaceApi().signalEndOfInputStream(codec_) != AMEDIA_OK) LOGW("Could not signal end of stream");
+        thread_.join();
+        AMediaCodec_stop(codec_);
+        if (muxing_ && AMediaMuxer_stop(muxer_) != AMEDIA_OK) LOGE("Finishing %s failed", path_.c_str());
+        const EncoderThrottle& throttle = *throttle_;
+        LOGI("Encoded %llu of %llu frames submitted, %.1f MB, %llu lost in the codec; skipped %llu behind the codec, "
+             "%llu over the rate cap, %llu stale",
+             (unsigned long long)throttle.encoded(), (unsigned long long)throttle.submitted(), bytes_ / 1e6,
+             (unsigned long long)throttle.lost(),
+             (unsigned long long)throttle.skippedBehind(), (unsigned long long)throttle.skippedRate(),
+             (unsigned long long)throttle.skippedStale());
+    }
+    release();
+}
+
+void VideoEncoder::release() {
+    if (codec_) AMediaCodec_delete(codec_);
+    if (muxer_) AMediaMuxer_delete(muxer_);
+    if (window_) ANativeWindow_release(window_);
+    if (fd_ >= 0) ::close(fd_);
+    codec_ = nullptr;
+    muxer_ = nullptr;
+    window_ = nullptr;
+    fd_ = -1;
+}
+
+void VideoEncoder::drain() {
+    int64_t endDeadlineNs = 0;
+    int64_t progressNs = monotonicNowNs();  // last output, or when the codec last had nothing to emit
+    for (;;) {
+        AMediaCodecBufferInfo info;
+        const ssize_t index = AMediaCodec_dequeueOutputBuffer(codec_, &info, kDequeueTimeoutUs);
+        if (index >= 0) {
+            if (!writeOutput(index, info)) return;
+            progressNs = monotonicNowNs();
+            continue;
+        }
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            // Arrives once, before the first frame, with the SPS/PPS the
+            // muxer needs for the track.
+            AMediaFormat* format = AMediaCodec_getOutputFormat(codec_);
+            track_ = AMediaMuxer_addTrack(muxer_, format);
+            AMediaFormat_delete(format);
+            muxing_ = track_ >= 0 && AMediaMuxer_start(muxer_) == AMEDIA_OK;
+            if (!muxing_) LOGE("Could not start muxing %s", path_.c_str());
+            continue;
+        }
+        // Timed out, or the output buffers changed (nothing to do with
+        // getOutputBuffer). Bail out if the end of stream never comes.
+        const int64_t now = monotonicNowNs();
+        if (ending_.load(std::memory_order_acquire)) {
+            if (!endDeadlineNs) {
+                endDeadlineNs = now + kEndOfStreamTimeoutNs;
+            } else if (now > endDeadlineNs) {
+                LOGW("No end of stream from the encoder; %s may be missing its last frames", path_.c_str());
+                return;
+            }
+            continue;
+        }
+        // Frames the codec has kept this long without a word are not coming
+        // out; stop counting them against the renderer.
+        if (throttle_->inFlight() <= 0) {
+            progressNs = now;
+        } else if (now - progressNs > stallNs_) {
+            LOGW("Encoder emitted nothing for %.0f ms; giving up on %d frames", (now - progressNs) / 1e6,
+                 throttle_->resync());
+            progressNs = now;
+        }
+    }
+}
+
+bool VideoEncoder::writeOutput(ssize_t index, const AMediaCodecBufferInfo& info) {
+    size_t capacity = 0;
+    const uint8_t* data = AMediaCodec_getOutputBuffer(codec_, size_t(index), &capacity);
+    // Codec config (SPS/PPS) already went to the muxer with the format.
+    if (data && info.size > 0 && !(info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG)) {
+        if (muxing_ && AMediaMuxer_writeSampleData(muxer_, size_t(track_), data, &info) == AMEDIA_OK) {
+            bytes_.fetch_add(uint64_t(info.size), std::memory_order_relaxed);
+        }
+        throttle_->onEncoded();
+    }
+    AMediaCodec_releaseOutputBuffer(codec_, size_t(index), false);
+    return !(info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaMuxer.h>
+#include <android/native_window.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include "EncoderThrottle.h"
+
+struct VideoEncoderConfig {
+    int width = 1280;
+    int height = 720;
+    int fps = 30;  // also the cap on frames sent to the codec
+    int bitrate = 6000000;
+    int iFrameIntervalS = 1;
+    // Frames drawn into the input surface and not yet out of the codec
+    // before the renderer starts skipping them.
+    int maxInFlight = 4;
+};
+
+// H.264 hardware encoder fed through an input surface and written to an MP4
+// by AMediaMuxer. The renderer draws frames into window() and sets their
+// presentation time with eglPresentationTimeANDROID, asking throttle() first
+// so a busy codec never blocks it. A thread of our own drains the codec and
+// feeds the muxer.
+//
+// AMediaCodec_createInputSurface is API 26 and is looked up at runtime;
+// below that start() fails and the app previews without recording.
+class VideoEncoder {
+public:
+    ~VideoEncoder() { stop(); }
+
+    bool start(const char* path, const VideoEncoderConfig& config);
+    // Ends the stream and finishes the file. The renderer must have destroyed
+    // its surface for window() first.
+    void stop();
+
+    bool running() const { return window_ != nullptr; }
+    ANativeWindow* window() const { return window_; }
+    EncoderThrottle& throttle() { return *throttle_; }
+    uint64_t bytesWritten() const { return bytes_.load(std::memory_order_relaxed); }
+
+private:
+    void drain();
+    bool writeOutput(ssize_t index, const AMediaCodecBufferInfo& info);
+    void release();
+
+    AMediaCodec* codec_ = nullptr;
+    AMediaMuxer* muxer_ = nullptr;
+    ANativeWindow* window_ = nullptr;
+    int fd_ = -1;
+    std::string path_;
+    std::unique_ptr<EncoderThrottle> throttle_ = std::make_unique<EncoderThrottle>();
+    std::thread thread_;
+    std::atomic<bool> ending_{false};
+    int64_t stallNs_ = 0;
+    ssize_t track_ = -1;  // drain thread only
+    bool muxing_ = false;
+    std::atomic<uint64_t> bytes_{0};
+};
@@ -0,0 +1,54 @@
+#include "VsyncSource.h"
+
+int64_t VsyncSource::waitNext() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ticked_.wait(lock, [this] { return closed_ || failed_ || latestNs_ > returnedNs_; });
+    if (closed_) return -1;
+    if (failed_) return 0;
+    returnedNs_ = latestNs_;
+    return returnedNs_;
+}
+
+int64_t VsyncSource::periodNs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return periodNs_;
+}
+
+void VsyncSource::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latestNs_ = returnedNs_ = -1;
+    periodNs_ = 0;
+    closed_ = false;
+    failed_ = false;
+}
+
+void VsyncSource::tick(int64_t vsyncNs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (latestNs_ >= 0 && vsyncNs > latestNs_) {
+            const int64_t interval = vsyncNs - latestNs_;
+            // Smoothed, and blind to gaps of a skipped tick or more, which
+            // would otherwise read as a slower display.
+            if (periodNs_ == 0) periodNs_ = interval;
+            else if (interval < periodNs_ * 3 / 2) periodNs_ += (interval - periodNs_) / 8;
+        }
+        latestNs_ = vsyncNs;
+    }
+    ticked_.notify_one();
+}
+
+void VsyncSource::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    ticked_.notify_all();
+}
+
+void VsyncSource::fail() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failed_ = true;
+    }
+    ticked_.notify_all();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Display vsync ticks for a render loop that paces itself to the display
+// instead of presenting as soon as a frame arrives. A subclass runs its own
+// thread that calls tick() once per vsync; the render thread blocks in
+// waitNext().
+//
+// On device this is ChoreographerVsync; on a Linux host, SimulatedVsync.
+class VsyncSource {
+public:
+    virtual ~VsyncSource() = default;
+
+    // Starts and stops the ticks. stop() wakes a waitNext() in progress; both
+    // are called by FramePipeline::start() and stop().
+    virtual void start() = 0;
+    virtual void stop() = 0;
+
+    // Blocks until a vsync later than the last one returned and returns its
+    // CLOCK_MONOTONIC time. Ticks missed while the caller was busy collapse
+    // into the latest one. -1 once stopped; 0 if the source could not tick
+    // at all, for a caller to present unpaced rather than not at all.
+    int64_t waitNext();
+
+    // Vsync period, measured from the ticks; 0 until two have arrived.
+    int64_t periodNs() const;
+
+protected:
+    // Call from start(), before the first tick.
+    void open();
+    // Call from the tick thread, once per vsync.
+    void tick(int64_t vsyncNs);
+    // Call from stop().
+    void close();
+    // Call instead of ever ticking when there are no vsyncs to be had;
+    // waitNext() stops blocking until the next open().
+    void fail();
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable ticked_;
+    int64_t latestNs_ = -1;
+    int64_t returnedNs_ = -1;
+    int64_t periodNs_ = 0;
+    bool closed_ = true;
+    bool failed_ = false;
+};
@@ -0,0 +1,394 @@
+#define LOG_TAG "YuvConverter"
+
+#include "YuvConverter.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <algorithm>
+#include <cstring>
+
+static const char* vertexShaderSrc = "#version 300 es\n"
+                                     "layout(location = 0) in vec4 a_Position;\n"
+                                     "layout(location = 1) in vec2 a_TexCoord;\n"
+                                     "uniform mat2 u_Transform;\n"
+                                     "out vec2 v_TexCoord;\n"
+                                     "void main() {\n"
+                                     "    gl_Position = vec4(u_Transform * a_Position.xy, 0.0, 1.0);\n"
+                                     "    v_TexCoord = a_TexCoord;\n"
+                                     "}\n";
+
+// chromaLayout: 0 = U and V in texU/texV, 1 = texU.rg holds UV,
+// 2 = texU.rg holds VU, 3 = no chroma (gray). texMask is an overlay's
+// coverage mask over the frame, blended in maskColor; with none bound it
+// samples 0 and maskColor is transparent.
+static const char* fragmentShaderSrc = "#version 300 es\n"
+                                       "precision mediump float;\n"
+                                       "in vec2 v_TexCoord;\n"
+                                       "uniform sampler2D texY;\n"
+                                       "uniform sampler2D texU;\n"
+                                       "uniform sampler2D texV;\n"
+                                       "uniform int chromaLayout;\n"
+                                       "uniform mat3 yuvToRgb;\n"
+                                       "uniform vec3 yuvOffset;\n"
+                                       "uniform sampler2D texMask;\n"
+                                       "uniform vec4 maskColor;\n"
+                                       "out vec4 fragColor;\n"
+                                       "void main() {\n"
+                                       "    float y = texture(texY, v_TexCoord).r;\n"
+                                       "    vec2 c;\n"
+                                       "    if (chromaLayout == 0) {\n"
+                                       "        c = vec2(texture(texU, v_TexCoord).r, texture(texV, v_TexCoord).r);\n"
+                                       "    } else if (chromaLayout == 1) {\n"
+                                       "        c = texture(texU, v_TexCoord).rg;\n"
+                                       "    } else if (chromaLayout == 2) {\n"
+                                       "        c = texture(texU, v_TexCoord).gr;\n"
+                                       "    } else {\n"
+                                       "        c = yuvOffset.yz;\n"
+                                       "    }\n"
+                                       "    vec3 rgb = clamp(yuvToRgb * (vec3(y, c) - yuvOffset), 0.0, 1.0);\n"
+                                       "    float mask = texture(texMask, v_TexCoord).r * maskColor.a;\n"
+                                       "    fragColor = vec4(mix(rgb, maskColor.rgb, mask), 1.0);\n"
+                                       "}\n";
+
+static const char* externalShaderSrc = "#version 300 es\n"
+                                       "#extension GL_OES_EGL_image_external_essl3 : require\n"
+                                       "precision mediump float;\n"
+                                       "in vec2 v_TexCoord;\n"
+                                       "uniform samplerExternalOES texExternal;\n"
+                                       "uniform sampler2D texMask;\n"
+                                       "uniform vec4 maskColor;\n"
+                                       "out vec4 fragColor;\n"
+                                       "void main() {\n"
+                                       "    float mask = texture(texMask, v_TexCoord).r * maskColor.a;\n"
+                                       "    fragColor = vec4(mix(texture(texExternal, v_TexCoord).rgb, maskColor.rgb, mask), 1.0);\n"
+                                       "}\n";
+
+YuvCoefficients yuvCoefficients(YuvMatrix matrix, YuvRange range) {
+    const float kr = matrix == YuvMatrix::Bt709 ? 0.2126f : 0.299f;
+    const float kb = matrix == YuvMatrix::Bt709 ? 0.0722f : 0.114f;
+    const float kg = 1.0f - kr - kb;
+    const bool full = range == YuvRange::Full;
+    const float ys = full ? 1.0f : 255.0f / 219.0f;
+    const float cs = full ? 1.0f : 255.0f / 224.0f;
+
+    YuvCoefficients c;
+    // Column 0: Y.
+    c.matrix[0] = c.matrix[1] = c.matrix[2] = ys;
+    // Column 1: Cb.
+    c.matrix[3] = 0.0f;
+    c.matrix[4] = -cs * 2.0f * kb * (1.0f - kb) / kg;
+    c.matrix[5] = cs * 2.0f * (1.0f - kb);
+    // Column 2: Cr.
+    c.matrix[6] = cs * 2.0f * (1.0f - kr);
+    c.matrix[7] = -cs * 2.0f * kr * (1.0f - kr) / kg;
+    c.matrix[8] = 0.0f;
+    c.offset[0] = full ? 0.0f : 16.0f / 255.0f;
+    c.offset[1] = c.offset[2] = 128.0f / 255.0f;
+    return c;
+}
+
+bool YuvConverter::init(ShaderCache& shaders) {
+    program_ = shaders.program("yuv", vertexShaderSrc, fragmentShaderSrc);
+    if (!program_) return false;
+    glUseProgram(program_);
+    glUniform1i(glGetUniformLocation(program_, "texY"), 0);
+    glUniform1i(glGetUniformLocation(program_, "texU"), 1);
+    glUniform1i(glGetUniformLocation(program_, "texV"), 2);
+    layoutLocation_ = glGetUniformLocation(program_, "chromaLayout");
+    matrixLocation_ = glGetUniformLocation(program_, "yuvToRgb");
+    offsetLocation_ = glGetUniformLocation(program_, "yuvOffset");
+    transformLocation_ = glGetUniformLocation(program_, "u_Transform");
+    glUniform1i(glGetUniformLocation(program_, "texMask"), kMaskUnit);
+    maskColorLocation_ = glGetUniformLocation(program_, "maskColor");
+    coefficientsDirty_ = true;
+    transformDirty_ = true;
+    maskTexture_ = 0;
+    maskColor_ = 0;
+    maskDirty_ = externalMaskDirty_ = true;
+
+    const GLfloat quad[] = {
+            -1, -1,  0, 1,
+            1, -1,  1, 1,
+            -1,  1,  0, 0,
+            1,  1,  1, 0,
+    };
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glBindVertexArray(0);
+
+    glGenTextures(3, textures_);
+    for (GLuint texture : textures_) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    pboCount_ = uploadBufferCount_;
+    if (pboCount_) glGenBuffers(pboCount_, pbos_);
+    nextPbo_ = 0;
+    stagedUploads_ = 0;
+    width_ = height_ = 0;
+    return true;
+}
+
+bool YuvConverter::initExternal(ShaderCache& shaders) {
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (!extensions || !std::strstr(extensions, "GL_OES_EGL_image_external_essl3")) return false;
+    externalProgram_ = shaders.program("yuv-external", vertexShaderSrc, externalShaderSrc);
+    if (!externalProgram_) return false;
+    glUseProgram(externalProgram_);
+    glUniform1i(glGetUniformLocation(externalProgram_, "texExternal"), 0);
+    externalTransformLocation_ = glGetUniformLocation(externalProgram_, "u_Transform");
+    glUniform1i(glGetUniformLocation(externalProgram_, "texMask"), kMaskUnit);
+    externalMaskColorLocation_ = glGetUniformLocation(externalProgram_, "maskColor");
+    externalTransformDirty_ = true;
+    externalMaskDirty_ = true;
+    return true;
+}
+
+void YuvConverter::release() {
+    for (int i = 0; i < pboCount_; ++i) {
+        if (fences_[i]) glDeleteSync(fences_[i]);
+        fences_[i] = nullptr;
+        pboSizes_[i] = 0;
+    }
+    if (pboCount_) glDeleteBuffers(pboCount_, pbos_);
+    pboCount_ = 0;
+    if (textures_[0]) glDeleteTextures(3, textures_);
+    if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    textures_[0] = textures_[1] = textures_[2] = 0;
+    // The programs belong to the ShaderCache.
+    vbo_ = vao_ = program_ = externalProgram_ = 0;
+    width_ = height_ = 0;
+}
+
+void YuvConverter::setColorSpace(YuvMatrix matrix, YuvRange range) {
+    coefficients_ = yuvCoefficients(matrix, range);
+    coefficientsDirty_ = true;
+}
+
+void YuvConverter::allocate(int width, int height, ChromaLayout layout) {
+    const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    glBindTexture(GL_TEXTURE_2D, textures_[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    if (layout == kPlanar) {
+        for (int i = 1; i < 3; ++i) {
+            glBindTexture(GL_TEXTURE_2D, textures_[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, cw, ch, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        }
+    } else if (layout == kUv || layout == kVu) {
+        glBindTexture(GL_TEXTURE_2D, textures_[1]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, cw, ch, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
+    }
+    width_ = width;
+    height_ = height;
+    layout_ = layout;
+    LOGI("Textures allocated for %dx%d, chroma layout %d", width, height, layout);
+}
+
+void YuvConverter::setViewport(int width, int height) {
+    if (width == viewWidth_ && height == viewHeight_) return;
+    viewWidth_ = width;
+    viewHeight_ = height;
+    updateTransform();
+}
+
+void YuvConverter::setScaleMode(ScaleMode mode) {
+    if (mode == scaleMode_) return;
+    scaleMode_ = mode;
+    updateTransform();
+}
+
+void YuvConverter::setFrameGeometry(int width, int height, int rotation) {
+    if (width == frameWidth_ && height == frameHeight_ && rotation == rotation_) return;
+    frameWidth_ = width;
+    frameHeight_ = height;
+    rotation_ = rotation;
+    updateTransform();
+}
+
+void YuvConverter::updateTransform() {
+    transform_ = previewTransform(frameWidth_, frameHeight_, rotation_, viewWidth_, viewHeight_, scaleMode_);
+    transformDirty_ = externalTransformDirty_ = true;
+}
+
+void YuvConverter::setMask(GLuint texture, uint32_t color) {
+    if (!texture) color = 0;
+    if (texture == maskTexture_ && color == maskColor_) return;
+    maskTexture_ = texture;
+    maskColor_ = color;
+    maskDirty_ = externalMaskDirty_ = true;
+}
+
+void YuvConverter::applyMask(GLint colorLocation, bool& dirty) {
+    if (dirty) {
+        glUniform4f(colorLocation, ((maskColor_ >> 16) & 0xFF) / 255.0f, ((maskColor_ >> 8) & 0xFF) / 255.0f,
+                    (maskColor_ & 0xFF) / 255.0f, (maskColor_ >> 24) / 255.0f);
+        dirty = false;
+    }
+    glActiveTexture(GL_TEXTURE0 + kMaskUnit);
+    glBindTexture(GL_TEXTURE_2D, maskTexture_);
+}
+
+void YuvConverter::setUploadBuffers(int count) {
+    uploadBufferCount_ = std::clamp(count, 0, kMaxUploadBuffers);
+}
+
+void YuvConverter::upload(const Frame& frame) {
+    const int w = frame.width, h = frame.height;
+    const int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    const FramePlane& yp = frame.planes[0];
+    const FramePlane& up = frame.planes[1];
+    const FramePlane& vp = frame.planes[2];
+
+    ChromaLayout layout = kNone;
+    bool repack = false;
+    if (frame.planeCount >= 3) {
+        if (up.pixelStride == 1 && vp.pixelStride == 1) {
+            layout = kPlanar;
+        } else if (up.pixelStride == 2 && vp.data == up.data + 1 && up.rowStride % 2 == 0) {
+            layout = kUv;
+        } else if (vp.pixelStride == 2 && up.data == vp.data + 1 && vp.rowStride % 2 == 0) {
+            layout = kVu;
+        } else {
+            // Strides GL cannot describe: gather into planar U and V.
+            layout = kPlanar;
+            repack = true;
+        }
+    }
+    if (w != width_ || h != height_ || layout != layout_) allocate(w, h, layout);
+    setFrameGeometry(w, h, frame.rotation);
+
+    PlaneUpload planes[3];
+    int count = 0;
+    planes[count++] = {textures_[0], GL_RED, 1, w, h, yp.data, yp.rowStride};
+    if (layout == kPlanar && !repack) {
+        planes[count++] = {textures_[1], GL_RED, 1, cw, ch, up.data, up.rowStride};
+        planes[count++] = {textures_[2], GL_RED, 1, cw, ch, vp.data, vp.rowStride};
+    } else if (layout == kPlanar) {
+        scratch_.resize(size_t(cw) * ch * 2);
+        uint8_t* u = scratch_.data();
+        uint8_t* v = u + size_t(cw) * ch;
+        for (int row = 0; row < ch; ++row) {
+            const uint8_t* us = up.data + row * up.rowStride;
+            const uint8_t* vs = vp.data + row * vp.rowStride;
+            for (int col = 0; col < cw; ++col) {
+                u[row * cw + col] = us[col * up.pixelStride];
+                v[row * cw + col] = vs[col * vp.pixelStride];
+            }
+        }
+        planes[count++] = {textures_[1], GL_RED, 1, cw, ch, u, cw};
+        planes[count++] = {textures_[2], GL_RED, 1, cw, ch, v, cw};
+    } else if (layout != kNone) {
+        // The first plane's last row ends one byte short of the pair; that
+        // byte is the other plane's last sample, in the same buffer.
+        const FramePlane& first = layout == kUv ? up : vp;
+        planes[count++] = {textures_[1], GL_RG, 2, cw, ch, first.data, first.rowStride};
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    uploadWaitNs_ = 0;
+    if (pboCount_ == 0 || !uploadStaged(planes, count)) {
+        for (int i = 0; i < count; ++i) uploadPlane(planes[i], planes[i].data);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void YuvConverter::uploadPlane(const PlaneUpload& plane, const void* pixels) {
+    glBindTexture(GL_TEXTURE_2D, plane.texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, plane.rowStride / plane.bytesPerPixel);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, plane.width, plane.height, plane.format, GL_UNSIGNED_BYTE, pixels);
+}
+
+bool YuvConverter::uploadStaged(const PlaneUpload* planes, int count) {
+    const int slot = nextPbo_;
+    nextPbo_ = (nextPbo_ + 1) % pboCount_;
+    if (fences_[slot]) {
+        // The GPU may still be copying the last frame staged here.
+        int64_t startNs = monotonicNowNs();
+        glClientWaitSync(fences_[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        uploadWaitNs_ = monotonicNowNs() - startNs;
+        glDeleteSync(fences_[slot]);
+        fences_[slot] = nullptr;
+    }
+
+    size_t offsets[3];
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        offsets[i] = total;
+        total += (planeBytes(planes[i]) + 63) & ~size_t(63);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos_[slot]);
+    if (pboSizes_[slot] < total) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(total), nullptr, GL_STREAM_DRAW);
+        pboSizes_[slot] = total;
+    }
+    // Nothing in this buffer is still in use (the fence above), so the
+    // driver need not synchronise the mapping.
+    auto* staging = static_cast<uint8_t*>(glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(total),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (!staging) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    // Planes are copied with their row padding so the strides carry over.
+    for (int i = 0; i < count; ++i) std::memcpy(staging + offsets[i], planes[i].data, planeBytes(planes[i]));
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    for (int i = 0; i < count; ++i) uploadPlane(planes[i], reinterpret_cast<const void*>(offsets[i]));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    fences_[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++stagedUploads_;
+    return true;
+}
+
+size_t YuvConverter::planeBytes(const PlaneUpload& plane) {
+    return size_t(plane.height - 1) * plane.rowStride + size_t(plane.width) * plane.bytesPerPixel;
+}
+
+void YuvConverter::draw() {
+    if (width_ == 0) return;
+    glUseProgram(program_);
+    if (coefficientsDirty_) {
+        glUniformMatrix3fv(matrixLocation_, 1, GL_FALSE, coefficients_.matrix);
+        glUniform3fv(offsetLocation_, 1, coefficients_.offset);
+        coefficientsDirty_ = false;
+    }
+    if (transformDirty_) {
+        glUniformMatrix2fv(transformLocation_, 1, GL_FALSE, transform_.matrix);
+        transformDirty_ = false;
+    }
+    glUniform1i(layoutLocation_, layout_);
+    applyMask(maskColorLocation_, maskDirty_);
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures_[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
+
+void YuvConverter::drawExternal(GLuint texture) {
+    glUseProgram(externalProgram_);
+    if (externalTransformDirty_) {
+        glUniformMatrix2fv(externalTransformLocation_, 1, GL_FALSE, transform_.matrix);
+        externalTransformDirty_ = false;
+    }
+    applyMask(externalMaskColorLocation_, externalMaskDirty_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+#include <cstdint>
+#include <vector>
+#include "FrameHandle.h"
+#include "PreviewTransform.h"
+#include "ShaderCache.h"
+
+enum class YuvMatrix { Bt601, Bt709 };
+enum class YuvRange {
+    Full,     // Y and chroma span 0-255 (JFIF; what Camera2 YUV_420_888 delivers)
+    Limited,  // Y in 16-235, chroma in 16-240 (video)
+};
+
+// rgb = matrix * (yuv - offset) on normalized samples. The matrix is
+// column-major, ready for glUniformMatrix3fv.
+struct YuvCoefficients {
+    float matrix[9];
+    float offset[3];
+};
+
+YuvCoefficients yuvCoefficients(YuvMatrix matrix, YuvRange range);
+
+// Draws a YUV_420_888 frame as RGB with the conversion done in the fragment
+// shader. Y goes into an R8 texture; chroma goes into two R8 textures when
+// planar, or one RG8 texture read in place when the planes interleave
+// (pixel stride 2, either order). Uploads honour the row stride through
+// GL_UNPACK_ROW_LENGTH, so the camera buffer is never repacked on the CPU.
+// Textures are reallocated only when the frame size or chroma layout changes.
+// The frame is rotated upright (Frame::rotation) and aspect-scaled to the
+// viewport in the vertex shader; the transform is recomputed only when the
+// frame geometry or viewport changes, so steady-state frames allocate nothing.
+//
+// With setUploadBuffers(n) the planes are first copied into one of n pixel
+// buffer objects, mapped unsynchronized, and the texture update is sourced
+// from there. The driver then copies to the texture asynchronously instead
+// of stalling the render thread, and frame N+1 can be staged while frame N
+// is still being drawn. A fence per buffer keeps a slot from being
+// overwritten before the GPU has read it; lastUploadWaitNs() is how long
+// upload() blocked on that fence.
+//
+// An overlay's coverage mask (OverlayRenderer::maskTexture()) is blended
+// into the frame by the same shader, so a mask costs a texture fetch per
+// pixel rather than a second pass over the frame.
+//
+// Every method needs the same GLES 3 context current.
+class YuvConverter {
+public:
+    static constexpr int kMaxUploadBuffers = 3;
+
+    // 0 uploads straight from the frame's memory. Takes effect at init().
+    void setUploadBuffers(int count);
+    int uploadBuffers() const { return uploadBufferCount_; }
+    int64_t lastUploadWaitNs() const { return uploadWaitNs_; }
+    // Uploads since init() that went through a buffer; the rest went
+    // straight from the frame, by choice or because a buffer would not map.
+    uint64_t stagedUploads() const { return stagedUploads_; }
+
+    // Programs come from `shaders`, which must outlive the converter's use
+    // of the context.
+    bool init(ShaderCache& shaders);
+    void release();
+
+    void setColorSpace(YuvMatrix matrix, YuvRange range);
+
+    // Size of the viewport being drawn into. Until it is known the frame is
+    // stretched over the whole viewport.
+    void setViewport(int width, int height);
+    void setScaleMode(ScaleMode mode);
+    // Frame size and clockwise rotation the next draw maps to the viewport.
+    // upload() takes them from the frame; call it for frames drawn with
+    // drawExternal().
+    void setFrameGeometry(int width, int height, int rotation);
+
+    void upload(const Frame& frame);
+    // Fills the viewport with the last uploaded frame.
+    void draw();
+
+    // For frames imported in place as GL_TEXTURE_EXTERNAL_OES (see
+    // BufferImportCache). The driver converts to RGB when sampling, with the
+    // color space it reads from the buffer, so setColorSpace() does not
+    // apply. False without GL_OES_EGL_image_external_essl3. Call after init().
+    bool initExternal(ShaderCache& shaders);
+    void drawExternal(GLuint texture);
+
+    // R8 coverage texture stretched over the frame, blended in `color`
+    // (0xAARRGGBB) by both draws; 0 for none. The texture must stay alive
+    // while it is set. init() clears it.
+    void setMask(GLuint texture, uint32_t color);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    // Where the frame lands in the viewport, for drawing over it.
+    const PreviewTransform& transform() const { return transform_; }
+
+private:
+    enum ChromaLayout { kPlanar = 0, kUv = 1, kVu = 2, kNone = 3 };
+    // Units 0-2 hold the planes (or the external texture).
+    static constexpr int kMaskUnit = 3;
+
+    struct PlaneUpload {
+        GLuint texture;
+        GLenum format;
+        int bytesPerPixel;
+        int width;
+        int height;
+        const uint8_t* data;
+        int rowStride;  // bytes
+    };
+
+    void allocate(int width, int height, ChromaLayout layout);
+    static void uploadPlane(const PlaneUpload& plane, const void* pixels);
+    // Stages the planes in the next PBO; false if it could not be mapped.
+    bool uploadStaged(const PlaneUpload* planes, int count);
+    void updateTransform();
+    // Sets the bound program's mask color if it is stale, and binds the mask.
+    void applyMask(GLint colorLocation, bool& dirty);
+    static size_t planeBytes(const PlaneUpload& plane);
+
+    GLuint program_ = 0;
+    GLuint externalProgram_ = 0;
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLuint textures_[3] = {};
+    GLint layoutLocation_ = -1;
+    GLint matrixLocation_ = -1;
+    GLint offsetLocation_ = -1;
+    GLint transformLocation_ = -1;
+    GLint externalTransformLocation_ = -1;
+    GLint maskColorLocation_ = -1;
+    GLint externalMaskColorLocation_ = -1;
+
+    int width_ = 0;
+    int height_ = 0;
+    ChromaLayout layout_ = kNone;
+    YuvCoefficients coefficients_ = yuvCoefficients(YuvMatrix::Bt601, YuvRange::Full);
+    bool coefficientsDirty_ = true;
+
+    int frameWidth_ = 0;
+    int frameHeight_ = 0;
+    int rotation_ = 0;
+    int viewWidth_ = 0;
+    int viewHeight_ = 0;
+    ScaleMode scaleMode_ = ScaleMode::Fit;
+    PreviewTransform transform_;
+    bool transformDirty_ = true;
+    bool externalTransformDirty_ = true;
+    GLuint maskTexture_ = 0;
+    uint32_t maskColor_ = 0;
+    bool maskDirty_ = true;
+    bool externalMaskDirty_ = true;
+    // Only for interleaved chroma with a row stride GL cannot express.
+    std::vector<uint8_t> scratch_;
+
+    int uploadBufferCount_ = 0;
+    int pboCount_ = 0;  // as created by init()
+    int nextPbo_ = 0;
+    GLuint pbos_[kMaxUploadBuffers] = {};
+    GLsync fences_[kMaxUploadBuffers] = {};
+    size_t pboSizes_[kMaxUploadBuffers] = {};
+    int64_t uploadWaitNs_ = 0;
+    uint64_t stagedUploads_ = 0;
+};
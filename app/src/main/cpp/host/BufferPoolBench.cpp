@@ -0,0 +1,129 @@
+// Compares BufferPool with malloc/free under the pipeline's access pattern:
+// the camera thread allocates a frame-sized copy and hands it to a consumer
+// thread, which allocates a model-input-sized scratch buffer, holds a few
+// frames, and frees both. Every buffer is freed on a different thread than
+// the one that allocated it, and the sizes are large enough that glibc serves
+// them with mmap, so each malloc pays for fresh pages.
+//
+//   buffer-pool-bench [frames] [width] [height] [held-frames]
+
+#include "BufferPool.h"
+#include "FrameRing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct MallocBuffers {
+    class Buffer {
+    public:
+        Buffer() = default;
+        explicit Buffer(size_t bytes) : data_(static_cast<uint8_t*>(std::malloc(bytes))) {}
+        Buffer(Buffer&& other) noexcept : data_(other.data_) { other.data_ = nullptr; }
+        Buffer& operator=(Buffer&& other) noexcept {
+            std::swap(data_, other.data_);
+            return *this;
+        }
+        ~Buffer() { std::free(data_); }
+        uint8_t* data() const { return data_; }
+
+    private:
+        uint8_t* data_ = nullptr;
+    };
+    Buffer acquire(size_t bytes) { return Buffer(bytes); }
+};
+
+struct PooledBuffers {
+    using Buffer = PooledBuffer;
+    BufferPool pool;
+    Buffer acquire(size_t bytes) { return pool.acquire(bytes); }
+};
+
+struct Result {
+    double framesPerSec = 0;
+    int64_t p50Ns = 0;  // producer: allocate + fill one frame copy
+    int64_t p99Ns = 0;
+    int64_t maxNs = 0;
+};
+
+template <typename Buffers>
+Result run(int frames, size_t frameBytes, size_t scratchBytes, size_t held, Buffers& buffers) {
+    using Buffer = typename Buffers::Buffer;
+    FrameRing<Buffer, 8> ring{OverflowPolicy::Block};
+    std::vector<uint8_t> camera(frameBytes, 0x80);
+    std::vector<int64_t> copyNs;
+    copyNs.reserve(frames);
+
+    auto start = Clock::now();
+    std::thread consumer([&] {
+        std::deque<Buffer> holding;
+        Buffer frame;
+        for (;;) {
+            if (!ring.consume(frame)) {
+                if (!ring.wait()) break;
+                continue;
+            }
+            Buffer scratch = buffers.acquire(scratchBytes);
+            // Touch it the way a preprocessing pass would.
+            std::memset(scratch.data(), frame.data()[0], scratchBytes);
+            holding.push_back(std::move(frame));
+            if (holding.size() > held) holding.pop_front();
+        }
+    });
+
+    for (int i = 0; i < frames; ++i) {
+        int64_t t0 = nowNs();
+        Buffer copy = buffers.acquire(frameBytes);
+        std::memcpy(copy.data(), camera.data(), frameBytes);
+        copyNs.push_back(nowNs() - t0);
+        ring.publish(std::move(copy));
+    }
+    ring.close();
+    consumer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Result result;
+    result.framesPerSec = frames / seconds;
+    std::sort(copyNs.begin(), copyNs.end());
+    result.p50Ns = copyNs[copyNs.size() / 2];
+    result.p99Ns = copyNs[copyNs.size() * 99 / 100];
+    result.maxNs = copyNs.back();
+    return result;
+}
+
+void report(const char* name, const Result& r) {
+    std::printf("  %-8s %9.0f frames/s   copy p50 %8.2f us   p99 %8.2f us   max %8.2f us\n", name,
+                r.framesPerSec, r.p50Ns / 1e3, r.p99Ns / 1e3, r.maxNs / 1e3);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int width = argc > 2 ? std::atoi(argv[2]) : 640;
+    const int height = argc > 3 ? std::atoi(argv[3]) : 480;
+    const size_t held = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 3;
+    const size_t frameBytes = size_t(width) * height * 3 / 2;
+    const size_t scratchBytes = 224 * 224 * 3 * sizeof(float);
+
+    std::printf("%d frames of %zu bytes, %zu byte scratch each, %zu held by the consumer:\n", frames, frameBytes,
+                scratchBytes, held);
+    MallocBuffers heap;
+    report("malloc", run(frames, frameBytes, scratchBytes, held, heap));
+    PooledBuffers pooled;
+    report("pool", run(frames, frameBytes, scratchBytes, held, pooled));
+    pooled.pool.logStats("pool");
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include "FakeModel.h"
+#include "MonotonicClock.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+FakeModel::FakeModel(const TensorShape& shape, int64_t latencyNs, bool spin)
+    : shape_(shape), latencyNs_(latencyNs), spin_(spin), input_(shape.bytes()) {}
+
+bool FakeModel::invoke() {
+    const int64_t deadline = monotonicNowNs() + latencyNs_;
+    if (spin_) {
+        while (monotonicNowNs() < deadline) {}
+    } else if (latencyNs_ > 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(latencyNs_));
+    }
+    // Sample the input so a benchmark can tell frames apart in the results.
+    output_[0] = input_.empty() ? 0.0f : float(input_[input_.size() / 2]);
+    output_[1] = input_.empty() ? 0.0f : float(input_.back());
+    return true;
+}
+
+int FakeModel::readOutputs(float* dst, int capacity) const {
+    const int n = std::min(capacity, 2);
+    std::copy(output_, output_ + n, dst);
+    return n;
+}
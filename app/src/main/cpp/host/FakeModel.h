@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "InferenceModel.h"
+
+// Stand-in for a TFLite model on hosts without the library, or when a
+// benchmark needs a precisely known inference cost. invoke() takes
+// latencyNs, either sleeping (an accelerator doing the work) or spinning
+// (a CPU delegate keeping a core busy).
+class FakeModel : public InferenceModel {
+public:
+    FakeModel(const TensorShape& shape, int64_t latencyNs, bool spin = false);
+
+    const TensorShape& inputShape() const override { return shape_; }
+    void* inputData() override { return input_.data(); }
+    bool invoke() override;
+    int outputValues() const override { return 2; }
+    int readOutputs(float* dst, int capacity) const override;
+
+private:
+    TensorShape shape_;
+    int64_t latencyNs_;
+    bool spin_;
+    std::vector<uint8_t> input_;
+    float output_[2] = {};
+};
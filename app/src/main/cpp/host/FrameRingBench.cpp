@@ -0,0 +1,149 @@
+// Compares FrameRing with the mutex + condition_variable queue that
+// native-lib.cpp used before it, on the two things the render path cares
+// about: how many frames per second can cross threads, and how long a single
+// frame waits between publish and pickup.
+//
+//   frame-ring-bench [items] [paced-interval-us]
+
+#include "FrameRing.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Item {
+    int64_t publishedNs = 0;
+    uint64_t seq = 0;
+};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// The pre-ring design: an unbounded std::queue behind one mutex.
+class MutexQueue {
+public:
+    void publish(Item item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push(item);
+        }
+        cv_.notify_one();
+    }
+
+    bool waitConsume(Item& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !queue_.empty() || closed_; });
+        if (queue_.empty()) return false;
+        out = queue_.front();
+        queue_.pop();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::queue<Item> queue_;
+    bool closed_ = false;
+};
+
+class RingQueue {
+public:
+    void publish(Item item) { ring_.publish(std::move(item)); }
+
+    bool waitConsume(Item& out) {
+        for (;;) {
+            if (ring_.consume(out)) return true;
+            if (!ring_.wait()) return ring_.consume(out);
+        }
+    }
+
+    void close() { ring_.close(); }
+
+private:
+    FrameRing<Item, 8> ring_{OverflowPolicy::Block};
+};
+
+struct Result {
+    double itemsPerSec = 0;
+    int64_t p50Ns = 0;
+    int64_t p99Ns = 0;
+    int64_t maxNs = 0;
+};
+
+// intervalUs == 0 runs flat out (throughput); otherwise the producer paces
+// itself like a camera and we measure publish-to-pickup latency.
+template <typename Queue>
+Result run(uint64_t items, int intervalUs) {
+    Queue queue;
+    std::vector<int64_t> latencies;
+    latencies.reserve(items);
+
+    auto start = Clock::now();
+    std::thread consumer([&] {
+        Item item;
+        while (queue.waitConsume(item)) latencies.push_back(nowNs() - item.publishedNs);
+    });
+
+    auto next = Clock::now();
+    for (uint64_t i = 0; i < items; ++i) {
+        if (intervalUs > 0) {
+            next += std::chrono::microseconds(intervalUs);
+            std::this_thread::sleep_until(next);
+        }
+        queue.publish(Item{nowNs(), i});
+    }
+    queue.close();
+    consumer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Result result;
+    result.itemsPerSec = latencies.size() / seconds;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.p50Ns = latencies[latencies.size() / 2];
+        result.p99Ns = latencies[latencies.size() * 99 / 100];
+        result.maxNs = latencies.back();
+    }
+    return result;
+}
+
+void report(const char* name, const Result& r) {
+    std::printf("  %-18s %12.0f items/s   p50 %8.2f us   p99 %8.2f us   max %8.2f us\n",
+                name, r.itemsPerSec, r.p50Ns / 1e3, r.p99Ns / 1e3, r.maxNs / 1e3);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    uint64_t items = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int intervalUs = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    std::printf("throughput, %llu items, unpaced:\n", (unsigned long long)items);
+    report("mutex+condvar", run<MutexQueue>(items, 0));
+    report("FrameRing<8>", run<RingQueue>(items, 0));
+
+    uint64_t pacedItems = std::min<uint64_t>(items, 2000);
+    std::printf("handoff latency, %llu items, one every %d us:\n",
+                (unsigned long long)pacedItems, intervalUs);
+    report("mutex+condvar", run<MutexQueue>(pacedItems, intervalUs));
+    report("FrameRing<8>", run<RingQueue>(pacedItems, intervalUs));
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+// A GLES 3 context with no window, rendering into an RGBA8 framebuffer
+// object: Mesa's surfaceless platform when available, else the default
+// display with a 1x1 pbuffer. For host tests and benchmarks of the GL code.
+class HeadlessGlContext {
+public:
+    ~HeadlessGlContext() { destroy(); }
+
+    // Makes the context current on the calling thread with a width x height
+    // framebuffer bound and the viewport covering it. False (with error()
+    // saying why) when no GLES 3 driver is available.
+    bool create(int width, int height);
+    void destroy();
+
+    const char* error() const { return error_; }
+
+private:
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    GLuint framebuffer_ = 0;
+    GLuint renderbuffer_ = 0;
+    const char* error_ = "";
+};
@@ -0,0 +1,45 @@
+#include "HeadlessRenderer.h"
+#include "InferenceStage.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+void HeadlessRenderer::detach() {
+    sampled_.reset();
+    imports_.clear();
+}
+
+void HeadlessRenderer::upload(const FrameHandle& handle) {
+    sampled_.reset();
+    if (importBuffers_ && handle->hardwareBuffer && imports_.texture(handle->hardwareBuffer)) {
+        sampled_ = handle;
+        return;
+    }
+    const Frame& frame = *handle;
+    const FramePlane& y = frame.planes[0];
+    if (frame.width != width_ || frame.height != height_) {
+        // Like glTexImage2D, only reallocated when the frame size changes.
+        width_ = frame.width;
+        height_ = frame.height;
+        texture_.assign(size_t(width_) * height_, 0);
+    }
+    for (int row = 0; row < height_; ++row) {
+        std::memcpy(texture_.data() + size_t(row) * width_, y.data + size_t(row) * y.rowStride, width_);
+    }
+    ++framesCopied_;
+}
+
+void HeadlessRenderer::draw() {
+    // Touch the texture so the copy cannot be optimised away.
+    if (sampled_) checksum_ += sampled_->planes[0].data[0];
+    else if (!texture_.empty()) checksum_ += texture_[texture_.size() / 2] + texture_.back();
+}
+
+bool HeadlessRenderer::present() {
+    if (presentDelayNs_ > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(presentDelayNs_));
+    return true;
+}
+
+void HeadlessRenderer::onInferenceResult(const InferenceResult&) {
+    ++resultsSeen_;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "BufferImportCache.h"
+#include "RenderBackend.h"
+
+// RenderBackend with no GPU behind it, for running the consumer path on a
+// Linux host. upload() copies the Y plane row by row into a texture-sized
+// buffer, the same memory traffic glTexSubImage2D with GL_UNPACK_ROW_LENGTH
+// causes; present() can sleep to stand in for a blocking swap.
+//
+// With setImportBuffers(true) it mirrors the device's zero-copy path: frames
+// that carry a hardwareBuffer go through a BufferImportCache backed by a
+// stub importer, skip the copy, and are held until the next frame arrives,
+// as if a fence had signalled by then.
+class HeadlessRenderer : public RenderBackend {
+public:
+    explicit HeadlessRenderer(int64_t presentDelayNs = 0) : presentDelayNs_(presentDelayNs) {}
+
+    // Set before the pipeline starts.
+    void setImportBuffers(bool enabled) { importBuffers_ = enabled; }
+    const BufferImportCache& imports() const { return imports_; }
+
+    bool attach() override { return true; }
+    void detach() override;
+    void upload(const FrameHandle& frame) override;
+    void draw() override;
+    bool present() override;
+    void onInferenceResult(const InferenceResult& result) override;
+
+    uint64_t checksum() const { return checksum_; }
+    uint64_t resultsSeen() const { return resultsSeen_; }
+    uint64_t framesCopied() const { return framesCopied_; }
+
+private:
+    // Hands out fake texture names; imports never fail.
+    class StubImporter : public BufferImporter {
+    public:
+        uint32_t import(void*) override { return ++lastTexture_; }
+        void release(void*, uint32_t) override {}
+
+    private:
+        uint32_t lastTexture_ = 0;
+    };
+
+    int64_t presentDelayNs_;
+    bool importBuffers_ = false;
+    StubImporter importer_;
+    BufferImportCache imports_{importer_};
+    FrameHandle sampled_;
+    std::vector<uint8_t> texture_;
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t checksum_ = 0;
+    uint64_t resultsSeen_ = 0;
+    uint64_t framesCopied_ = 0;
+};
@@ -0,0 +1,137 @@
+// Drives InferenceStage with synthetic frames and FakeModel over a range of
+// model latencies, next to the same model run inline on the render thread,
+// and reports what each costs the preview and how stale the results are.
+//
+//   inference-bench [--fps 30] [--seconds 3] [--latencies-ms 10,33,66,150]
+//                   [--input 224] [--spin 0|1]
+
+#define LOG_TAG "InferenceBench"
+
+#include "FakeModel.h"
+#include "FramePipeline.h"
+#include "HeadlessRenderer.h"
+#include "InferenceStage.h"
+#include "Log.h"
+#include "Preprocess.h"
+#include "SyntheticFrameSource.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The design the scheduler replaces: every presented frame also goes
+// through the model before it is drawn.
+class InlineInferenceRenderer : public HeadlessRenderer {
+public:
+    explicit InlineInferenceRenderer(InferenceModel& model) : model_(model) {}
+
+    void upload(const FrameHandle& frame) override {
+        HeadlessRenderer::upload(frame);
+        preprocessor_.run(*frame, model_.inputShape(), model_.inputData());
+        model_.invoke();
+    }
+
+private:
+    InferenceModel& model_;
+    Preprocessor preprocessor_;
+};
+
+struct Options {
+    double fps = 30.0;
+    double seconds = 3.0;
+    int input = 224;
+    bool spin = false;
+};
+
+void runOnce(const Options& options, double latencyMs, bool inlineModel) {
+    TensorShape shape;
+    shape.width = shape.height = options.input;
+    FakeModel model(shape, int64_t(latencyMs * 1e6), options.spin);
+
+    std::unique_ptr<HeadlessRenderer> renderer;
+    std::unique_ptr<InferenceStage> inference;
+    if (inlineModel) {
+        renderer = std::make_unique<InlineInferenceRenderer>(model);
+    } else {
+        renderer = std::make_unique<HeadlessRenderer>();
+        inference = std::make_unique<InferenceStage>(model);
+    }
+    FramePipeline pipeline(*renderer);
+    SyntheticSourceOptions sourceOptions;
+    sourceOptions.fps = options.fps;
+    sourceOptions.pixelStride = 2;
+    SyntheticFrameSource source(sourceOptions);
+
+    StreamConfig config;
+    config.maxImages = inference ? 7 : 4;
+    if (inference) {
+        pipeline.setInferenceResults(&inference->results());
+        inference->start();
+    }
+    pipeline.start();
+    InferenceStage* stage = inference.get();
+    if (!source.open(config, [&pipeline, stage](FrameHandle frame) {
+            if (stage) stage->submit(frame);
+            pipeline.submit(std::move(frame));
+        })) {
+        std::exit(1);
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    pipeline.stop();
+    if (inference) inference->stop();
+    source.close();
+
+    const PipelineStats& stats = pipeline.stats();
+    if (!inference) {
+        std::printf("%9.1f  inline     %7.1f  %7.1f  %8s  %8s  %8s  %8s  %8s\n", latencyMs, stats.fps(),
+                    stats.fps(), "-", "-", "-", "0", "0");
+        return;
+    }
+    const StageStats& latency = inference->latencyStats();
+    const StageStats& staleness = stats.resultStaleness;
+    double skippedPct = inference->submitted() ? 100.0 * inference->skipped() / inference->submitted() : 0.0;
+    std::printf("%9.1f  scheduled  %7.1f  %7.1f  %7.1f%%  %8.1f  %8.1f  %8.1f  %8.1f\n", latencyMs,
+                stats.fps(), inference->rate(), skippedPct, latency.percentileNs(50) / 1e6,
+                latency.percentileNs(95) / 1e6, staleness.percentileNs(50) / 1e6,
+                staleness.percentileNs(95) / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<double> latencies = {10, 33, 66, 150};
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* flag = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp(flag, "--fps")) options.fps = std::atof(value);
+        else if (!std::strcmp(flag, "--seconds")) options.seconds = std::atof(value);
+        else if (!std::strcmp(flag, "--input")) options.input = std::atoi(value);
+        else if (!std::strcmp(flag, "--spin")) options.spin = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--latencies-ms")) {
+            latencies.clear();
+            for (char* p = const_cast<char*>(value); *p;) {
+                latencies.push_back(std::strtod(p, &p));
+                if (*p == ',') ++p;
+            }
+        } else {
+            LOGE("Unknown flag %s", flag);
+            return 2;
+        }
+    }
+
+    std::printf("%.0f fps source, %.1f s per run, %dx%d model input\n", options.fps, options.seconds,
+                options.input, options.input);
+    std::printf("%9s  %-9s  %7s  %7s  %8s  %8s  %8s  %8s  %8s\n", "model ms", "mode", "preview",
+                "infer/s", "skipped", "lat p50", "lat p95", "stale 50", "stale 95");
+    for (double latencyMs : latencies) {
+        runOnce(options, latencyMs, true);
+        runOnce(options, latencyMs, false);
+    }
+    return 0;
+}
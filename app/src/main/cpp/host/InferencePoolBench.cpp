@@ -0,0 +1,143 @@
+// Sweeps InferenceStage worker count against interpreter threads per worker
+// and reports sustained inference throughput and capture-to-result latency.
+//
+//   inference-pool-bench [--model model.tflite] [--workers 1,2,4] [--threads 1,2,4]
+//                        [--fps 120] [--seconds 3] [--policy round-robin|least-loaded]
+//                        [--fake-model-ms 30] [--fake-input 224]
+//
+// Without --model (or on a host build without TensorFlow Lite) every worker
+// runs a spinning FakeModel, which stands in for a single-threaded CPU
+// interpreter; --threads does not apply then.
+
+#define LOG_TAG "InferencePoolBench"
+
+#include "FakeModel.h"
+#include "InferenceStage.h"
+#include "Log.h"
+#include "SyntheticFrameSource.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#ifdef PIPELINE_HAVE_TFLITE
+#include "TfLiteModel.h"
+#endif
+
+namespace {
+
+std::vector<int> parseList(const char* value) {
+    std::vector<int> list;
+    for (char* p = const_cast<char*>(value); *p;) {
+        list.push_back(int(std::strtol(p, &p, 10)));
+        if (*p == ',') ++p;
+        else if (*p) break;
+    }
+    return list;
+}
+
+struct Options {
+    const char* modelPath = nullptr;
+    double fps = 120.0;
+    double seconds = 3.0;
+    DispatchPolicy policy = DispatchPolicy::LeastLoaded;
+    double fakeModelMs = 30.0;
+    int fakeInput = 224;
+};
+
+std::vector<std::unique_ptr<InferenceModel>> makeModels(const Options& options, int workers,
+                                                       [[maybe_unused]] int threads) {
+    std::vector<std::unique_ptr<InferenceModel>> models;
+#ifdef PIPELINE_HAVE_TFLITE
+    if (options.modelPath) {
+        std::unique_ptr<TfLiteModel> model = TfLiteModel::load(options.modelPath, threads);
+        if (!model) return models;
+        for (int i = 1; i < workers; ++i) {
+            if (std::unique_ptr<TfLiteModel> clone = model->clone(threads)) models.push_back(std::move(clone));
+        }
+        models.push_back(std::move(model));
+        return models;
+    }
+#endif
+    TensorShape shape;
+    shape.width = shape.height = options.fakeInput;
+    for (int i = 0; i < workers; ++i) {
+        models.push_back(std::make_unique<FakeModel>(shape, int64_t(options.fakeModelMs * 1e6), true));
+    }
+    return models;
+}
+
+void runOnce(const Options& options, int workers, int threads) {
+    std::vector<std::unique_ptr<InferenceModel>> models = makeModels(options, workers, threads);
+    if (models.empty()) std::exit(1);
+    std::vector<InferenceModel*> instances;
+    for (auto& model : models) instances.push_back(model.get());
+    InferenceStage stage(instances, options.policy);
+
+    SyntheticSourceOptions sourceOptions;
+    sourceOptions.fps = options.fps;
+    sourceOptions.pixelStride = 2;
+    SyntheticFrameSource source(sourceOptions);
+    StreamConfig config;
+    config.maxImages = 1 + 3 * workers;
+
+    stage.start();
+    if (!source.open(config, [&stage](FrameHandle frame) { stage.submit(std::move(frame)); })) std::exit(1);
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stage.stop();
+    source.close();
+
+    const StageStats& latency = stage.latencyStats();
+    double invokeP50 = 0;
+    for (int i = 0; i < workers; ++i) invokeP50 += stage.invokeStats(i).percentileNs(50) / 1e6 / workers;
+    std::printf("%7d  %7d  %9.1f  %10.1f  %8.1f  %8.1f  %9llu\n", workers, threads, stage.rate(), invokeP50,
+                latency.percentileNs(50) / 1e6, latency.percentileNs(95) / 1e6,
+                (unsigned long long)stage.discarded());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<int> workerCounts = {1, 2, 4};
+    std::vector<int> threadCounts = {1, 2, 4};
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* flag = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp(flag, "--model")) options.modelPath = value;
+        else if (!std::strcmp(flag, "--workers")) workerCounts = parseList(value);
+        else if (!std::strcmp(flag, "--threads")) threadCounts = parseList(value);
+        else if (!std::strcmp(flag, "--fps")) options.fps = std::atof(value);
+        else if (!std::strcmp(flag, "--seconds")) options.seconds = std::atof(value);
+        else if (!std::strcmp(flag, "--fake-model-ms")) options.fakeModelMs = std::atof(value);
+        else if (!std::strcmp(flag, "--fake-input")) options.fakeInput = std::atoi(value);
+        else if (!std::strcmp(flag, "--policy")) {
+            options.policy = !std::strcmp(value, "round-robin") ? DispatchPolicy::RoundRobin
+                                                                : DispatchPolicy::LeastLoaded;
+        } else {
+            LOGE("Unknown flag %s", flag);
+            return 2;
+        }
+    }
+#ifndef PIPELINE_HAVE_TFLITE
+    if (options.modelPath) {
+        LOGE("--model needs a host build with TensorFlow Lite");
+        return 2;
+    }
+#endif
+    if (!options.modelPath) {
+        std::printf("FakeModel, %.1f ms spinning per invoke\n", options.fakeModelMs);
+        threadCounts = {1};
+    }
+    std::printf("%.0f fps source, %.1f s per run, %u hardware threads, %s dispatch\n", options.fps,
+                options.seconds, std::thread::hardware_concurrency(),
+                options.policy == DispatchPolicy::RoundRobin ? "round-robin" : "least-loaded");
+    std::printf("%7s  %7s  %9s  %10s  %8s  %8s  %9s\n", "workers", "threads", "results/s", "invoke p50",
+                "lat p50", "lat p95", "discarded");
+    for (int workers : workerCounts) {
+        for (int threads : threadCounts) runOnce(options, workers, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+// Runs the preview consumer path headless on a Linux host, fed by synthetic
+// or file-backed YUV_420_888 frames, and reports per-stage latency and
+// sustained FPS.
+//
+//   pipeline-harness [--width 640] [--height 480] [--fps 30] [--seconds 5]
+//                    [--max-images 4] [--pixel-stride 1|2] [--row-padding 0]
+//                    [--present-ms 0] [--file frames.i420] [--trace trace.json]
+//                    [--model model.tflite] [--threads 2]
+//                    [--input-mean 127.5] [--input-scale 0.0078125]
+//                    [--fake-model-ms 0] [--fake-input 224] [--fake-spin 0|1]
+//                    [--workers 1] [--policy round-robin|least-loaded]
+//                    [--analysis 320x240] [--zero-copy 0|1] [--copy-frames 0|1]
+//                    [--vsync-hz 0] [--record out.frames]
+//                    [--replay in.frames] [--replay-realtime 1|0]
+//
+// --model runs the real TFLite stage (host builds with TensorFlow Lite only);
+// --fake-model-ms runs the same stage against FakeModel. --workers runs that
+// many model instances in parallel, --threads interpreter threads each.
+// --input-mean and --input-scale are what a float model's pixels are mapped
+// through, (pixel - mean) * scale; the defaults give the [-1, 1] the app's
+// SSD detector expects.
+// --analysis feeds the model from a second, smaller stream, as the app does,
+// instead of sharing the preview frames. --zero-copy tags preview frames
+// with their buffer and has the renderer "import" them through a stub
+// instead of copying, like the device's AHardwareBuffer path.
+// --copy-frames copies every preview frame into pooled memory and returns
+// the source buffer at once, as a stage that holds frames longer would.
+// --vsync-hz paces presentation to a simulated display refreshing at that
+// rate, as the app does with the choreographer.
+// --record writes every preview frame to a FrameRecording; --replay feeds
+// the pipeline from one instead of the synthetic source, in real time or,
+// with --replay-realtime 0, as fast as the pipeline frees buffers.
+
+#define LOG_TAG "PipelineHarness"
+
+#include "BufferPool.h"
+#include "FakeModel.h"
+#include "FrameCopy.h"
+#include "FrameRecorder.h"
+#include "FramePipeline.h"
+#include "FrameTrace.h"
+#include "HeadlessRenderer.h"
+#include "InferenceStage.h"
+#include "Log.h"
+#include "ReplayFrameSource.h"
+#include "SimulatedVsync.h"
+#include "SyntheticFrameSource.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#ifdef PIPELINE_HAVE_TFLITE
+#include "TfLiteModel.h"
+#endif
+
+int main(int argc, char** argv) {
+    StreamConfig config;
+    SyntheticSourceOptions options;
+    double seconds = 5.0;
+    double presentMs = 0.0;
+    const char* tracePath = nullptr;
+    const char* modelPath = nullptr;
+    // Only read with TensorFlow Lite.
+    [[maybe_unused]] int threads = 2;
+    [[maybe_unused]] InputNormalization normalization{127.5f, 1.0f / 127.5f};
+    double fakeModelMs = -1.0;
+    int fakeInput = 224;
+    bool fakeSpin = false;
+    int workers = 1;
+    DispatchPolicy policy = DispatchPolicy::RoundRobin;
+    StreamConfig analysis;
+    analysis.width = analysis.height = 0;
+    bool zeroCopy = false;
+    bool copyFrames = false;
+    double vsyncHz = 0.0;
+    const char* recordPath = nullptr;
+    ReplayOptions replayOptions;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* flag = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp(flag, "--width")) config.width = std::atoi(value);
+        else if (!std::strcmp(flag, "--height")) config.height = std::atoi(value);
+        else if (!std::strcmp(flag, "--max-images")) config.maxImages = std::atoi(value);
+        else if (!std::strcmp(flag, "--fps")) options.fps = std::atof(value);
+        else if (!std::strcmp(flag, "--pixel-stride")) options.pixelStride = std::atoi(value);
+        else if (!std::strcmp(flag, "--row-padding")) options.rowPadding = std::atoi(value);
+        else if (!std::strcmp(flag, "--file")) options.path = value;
+        else if (!std::strcmp(flag, "--seconds")) seconds = std::atof(value);
+        else if (!std::strcmp(flag, "--present-ms")) presentMs = std::atof(value);
+        else if (!std::strcmp(flag, "--trace")) tracePath = value;
+        else if (!std::strcmp(flag, "--model")) modelPath = value;
+        else if (!std::strcmp(flag, "--threads")) threads = std::atoi(value);
+        else if (!std::strcmp(flag, "--input-mean")) normalization.mean = float(std::atof(value));
+        else if (!std::strcmp(flag, "--input-scale")) normalization.scale = float(std::atof(value));
+        else if (!std::strcmp(flag, "--fake-model-ms")) fakeModelMs = std::atof(value);
+        else if (!std::strcmp(flag, "--fake-input")) fakeInput = std::atoi(value);
+        else if (!std::strcmp(flag, "--fake-spin")) fakeSpin = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--workers")) workers = std::max(1, std::atoi(value));
+        else if (!std::strcmp(flag, "--policy")) {
+            policy = !std::strcmp(value, "least-loaded") ? DispatchPolicy::LeastLoaded : DispatchPolicy::RoundRobin;
+        }
+        else if (!std::strcmp(flag, "--zero-copy")) zeroCopy = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--copy-frames")) copyFrames = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--vsync-hz")) vsyncHz = std::atof(value);
+        else if (!std::strcmp(flag, "--record")) recordPath = value;
+        else if (!std::strcmp(flag, "--replay")) replayOptions.path = value;
+        else if (!std::strcmp(flag, "--replay-realtime")) replayOptions.realtime = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--analysis")) {
+            if (std::sscanf(value, "%dx%d", &analysis.width, &analysis.height) != 2) {
+                LOGE("--analysis wants WxH, got %s", value);
+                return 2;
+            }
+        }
+        else {
+            LOGE("Unknown flag %s", flag);
+            return 2;
+        }
+    }
+
+    FrameTrace::setEnabled(tracePath != nullptr);
+    std::vector<std::unique_ptr<InferenceModel>> models;
+    if (modelPath) {
+#ifdef PIPELINE_HAVE_TFLITE
+        std::unique_ptr<TfLiteModel> model = TfLiteModel::load(modelPath, threads, normalization);
+        if (!model) return 1;
+        for (int i = 1; i < workers; ++i) {
+            std::unique_ptr<TfLiteModel> clone = model->clone(threads);
+            if (!clone) return 1;
+            models.push_back(std::move(clone));
+        }
+        models.push_back(std::move(model));
+#else
+        LOGE("--model needs a host build with TensorFlow Lite");
+        return 2;
+#endif
+    } else if (fakeModelMs >= 0) {
+        TensorShape shape;
+        shape.width = shape.height = fakeInput;
+        for (int i = 0; i < workers; ++i) {
+            models.push_back(std::make_unique<FakeModel>(shape, int64_t(fakeModelMs * 1e6), fakeSpin));
+        }
+    }
+
+    // Outlive every stage that may still hold a copied frame.
+    BufferPool buffers;
+    FramePool copies(FramePool::kMaxFrames);
+    HeadlessRenderer renderer(int64_t(presentMs * 1e6));
+    if (zeroCopy) {
+        // The renderer holds the previous frame until its "fence" signals.
+        renderer.setImportBuffers(true);
+        config.gpuSampled = true;
+        config.maxImages += 1;
+    }
+    std::unique_ptr<SimulatedVsync> vsync;
+    if (vsyncHz > 0) vsync = std::make_unique<SimulatedVsync>(int64_t(1e9 / vsyncHz));
+    FramePipeline pipeline(renderer);
+    pipeline.setVsync(vsync.get());
+    SyntheticFrameSource synthetic(options);
+    std::unique_ptr<ReplayFrameSource> replay;
+    if (!replayOptions.path.empty()) replay = std::make_unique<ReplayFrameSource>(replayOptions);
+    FrameSource& source = replay ? static_cast<FrameSource&>(*replay) : synthetic;
+    FrameRecorder recorder;
+    if (recordPath && !recorder.open(recordPath)) return 1;
+
+    std::unique_ptr<InferenceStage> inference;
+    if (!models.empty()) {
+        std::vector<InferenceModel*> instances;
+        for (auto& model : models) instances.push_back(model.get());
+        inference = std::make_unique<InferenceStage>(instances, policy);
+        pipeline.setInferenceResults(&inference->results());
+        inference->start();
+    }
+    const bool separateAnalysis = inference && analysis.width > 0;
+    if (inference && !separateAnalysis) config.maxImages += 3 * inference->workers();
+
+    pipeline.start();
+    std::vector<StreamRequest> streams;
+    streams.push_back({config, [&](FrameHandle frame) {
+        if (recordPath) recorder.record(*frame);
+        if (copyFrames) {
+            FrameHandle copy = copyFrame(*frame, copies, buffers);
+            if (!copy) return;
+            frame = std::move(copy);
+        }
+        if (inference && !separateAnalysis) inference->submit(frame);
+        pipeline.submit(std::move(frame));
+    }});
+    if (separateAnalysis) {
+        analysis.maxImages = 1 + 3 * inference->workers();
+        streams.push_back({analysis, [&](FrameHandle frame) { inference->submit(std::move(frame)); }});
+    }
+    if (!source.open(streams)) {
+        pipeline.stop();
+        return 1;
+    }
+    if (!replay) LOGI("%dx%d @ %.1f fps for %.1f s", config.width, config.height, options.fps, seconds);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    pipeline.stop();
+    if (inference) inference->stop();
+    source.close();
+    recorder.close();
+
+    const FramePipeline::Ring& ring = pipeline.ring();
+    if (replay) {
+        LOGI("replay: %llu delivered, %llu dropped with all buffers in flight", (unsigned long long)replay->delivered(),
+             (unsigned long long)replay->dropped());
+    } else {
+        for (size_t i = 0; i < streams.size(); ++i) {
+            LOGI("stream %zu (%dx%d): %llu delivered, %llu dropped with all buffers in flight", i,
+                 streams[i].config.width, streams[i].config.height,
+                 (unsigned long long)synthetic.delivered(int(i)), (unsigned long long)synthetic.dropped(int(i)));
+        }
+    }
+    LOGI("ring: %llu published, %llu evicted, %llu rejected, %llu skipped",
+         (unsigned long long)ring.published(), (unsigned long long)ring.droppedOldest(),
+         (unsigned long long)ring.droppedNewest(), (unsigned long long)ring.skipped());
+    pipeline.stats().log();
+    if (copyFrames) buffers.logStats("frame copies");
+    if (zeroCopy) {
+        const BufferImportCache& imports = renderer.imports();
+        LOGI("imports: %llu buffers, %llu frames sampled in place, %llu copied",
+             (unsigned long long)imports.imports(), (unsigned long long)imports.hits(),
+             (unsigned long long)renderer.framesCopied());
+    }
+    if (inference) {
+        inference->logStats();
+        LOGI("renderer saw %llu new results", (unsigned long long)renderer.resultsSeen());
+    }
+    if (tracePath) {
+        FrameTrace::logSummary();
+        FrameTrace::writeChromeTrace(tracePath);
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Times Preprocessor on a camera-sized frame for every kernel this CPU
+// supports, against the per-pixel reference.
+//
+//   preprocess-bench [frame-width frame-height] [model-size] [iterations]
+
+#include "Preprocess.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Fn>
+double medianUs(int iterations, Fn&& fn) {
+    std::vector<double> samples(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        fn();
+        samples[i] = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+    std::nth_element(samples.begin(), samples.begin() + iterations / 2, samples.end());
+    return samples[iterations / 2];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int width = argc > 2 ? std::atoi(argv[1]) : 640;
+    int height = argc > 2 ? std::atoi(argv[2]) : 480;
+    int size = argc > 3 ? std::atoi(argv[3]) : 224;
+    int iterations = std::max(1, argc > 4 ? std::atoi(argv[4]) : 200);
+
+    // Interleaved chroma, as most devices deliver YUV_420_888.
+    const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    std::vector<uint8_t> y(size_t(width) * height), uv(size_t(cw) * 2 * ch + 1);
+    for (size_t i = 0; i < y.size(); ++i) y[i] = uint8_t(i * 7);
+    for (size_t i = 0; i < uv.size(); ++i) uv[i] = uint8_t(i * 13);
+    Frame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.planeCount = 3;
+    frame.planes[0] = {y.data(), int(y.size()), width, 1};
+    frame.planes[1] = {uv.data() + 1, int(uv.size()) - 1, cw * 2, 2};
+    frame.planes[2] = {uv.data(), int(uv.size()) - 1, cw * 2, 2};
+
+    std::printf("%dx%d -> %dx%d, median of %d runs\n", width, height, size, size, iterations);
+    for (auto type : {TensorType::Float32, TensorType::UInt8}) {
+        TensorShape shape;
+        shape.width = shape.height = size;
+        shape.type = type;
+        std::vector<uint8_t> out(shape.bytes());
+        const char* typeName = type == TensorType::Float32 ? "float" : "uint8";
+
+        double reference = medianUs(iterations, [&] {
+            preprocessReference(frame, CropRect{}, shape, out.data());
+        });
+        std::printf("  %-6s reference  %8.1f us\n", typeName, reference);
+        for (auto isa : {Preprocessor::Isa::Scalar, Preprocessor::Isa::Sse2,
+                         Preprocessor::Isa::Avx2, Preprocessor::Isa::Neon}) {
+            if (!Preprocessor::supported(isa)) continue;
+            Preprocessor preprocessor;
+            preprocessor.setIsa(isa);
+            double us = medianUs(iterations, [&] { preprocessor.run(frame, shape, out.data()); });
+            std::printf("  %-6s %-10s %8.1f us  (%.1fx)\n", typeName, Preprocessor::isaName(isa), us, reference / us);
+        }
+    }
+    return 0;
+}
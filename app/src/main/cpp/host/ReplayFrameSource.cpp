@@ -0,0 +1,88 @@
+#define LOG_TAG "ReplayFrameSource"
+
+#include "ReplayFrameSource.h"
+#include "FrameTrace.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <chrono>
+
+bool ReplayFrameSource::open(const std::vector<StreamRequest>& streams) {
+    close();
+    setLost(false);
+    if (streams.empty()) return false;
+    if (!recording_) recording_ = FrameRecording::open(options_.path.c_str());
+    if (!recording_) return false;
+    if (recording_->size() == 0) {
+        LOGE("%s holds no frames", options_.path.c_str());
+        return false;
+    }
+    if (streams.size() > 1) LOGE("A recording holds one stream; replaying it on the first of %zu", streams.size());
+    const RecordedFrame& first = recording_->info(0);
+    LOGI("Replaying %zu %dx%d frames from %s %s", recording_->size(), first.width, first.height,
+         options_.path.c_str(), options_.realtime ? "in real time" : "at full speed");
+    stream_ = streams[0];
+    pool_ = std::make_unique<FramePool>(stream_.config.maxImages);
+    delivered_ = 0;
+    dropped_ = 0;
+    finished_ = false;
+    running_ = true;
+    thread_ = std::thread(&ReplayFrameSource::run, this);
+    return true;
+}
+
+void ReplayFrameSource::close() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+CaptureResultInfo ReplayFrameSource::lastCapture() const {
+    CaptureResultInfo info;
+    if (!recording_ || !delivered()) return info;
+    const RecordedFrame& record = recording_->info(lastIndex_.load(std::memory_order_relaxed));
+    info.frameNumber = record.frameNumber;
+    info.frameDurationNs = record.frameDurationNs;
+    info.exposureTimeNs = record.exposureTimeNs;
+    info.sensitivity = record.sensitivity;
+    return info;
+}
+
+void ReplayFrameSource::run() {
+    const size_t count = recording_->size();
+    const int64_t firstNs = recording_->info(0).timestampNs;
+    // One pass lasts from the first timestamp to one frame past the last.
+    const int64_t spanNs = recording_->info(count - 1).timestampNs - firstNs;
+    const int64_t passNs = count > 1 ? spanNs + spanNs / int64_t(count - 1) : 33333333;
+    const int64_t startNs = monotonicNowNs();
+
+    for (uint64_t pass = 0; running_; ++pass) {
+        for (size_t i = 0; i < count && running_; ++i) {
+            const int64_t shiftNs = startNs + int64_t(pass) * passNs - firstNs;
+            if (options_.realtime) {
+                const int64_t dueNs = recording_->info(i).timestampNs + shiftNs;
+                const int64_t waitNs = dueNs - monotonicNowNs();
+                if (waitNs > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+                if (!deliver(i, shiftNs)) dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            while (running_ && !deliver(i, shiftNs)) std::this_thread::yield();
+        }
+        if (!options_.loop) break;
+    }
+    finished_.store(true, std::memory_order_release);
+}
+
+bool ReplayFrameSource::deliver(size_t index, int64_t shiftNs) {
+    // The mapping owns the pixels; the pool slot is the only thing to give back.
+    FrameHandle frame = pool_->acquire(recording_.get(), nullptr);
+    if (!frame) return false;
+    recording_->describe(index, *frame);
+    frame->stream = 0;
+    frame->timestampNs += shiftNs;
+    frame->capture.timestampNs = frame->timestampNs;
+    frame->acquiredNs = monotonicNowNs();
+    FrameTrace::record(TraceStage::Acquire, frame->timestampNs, frame->timestampNs);
+    lastIndex_.store(index, std::memory_order_relaxed);
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+    stream_.onFrame(std::move(frame));
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameRecording.h"
+#include "FrameSource.h"
+
+struct ReplayOptions {
+    std::string path;       // written by FrameRecorder
+    bool realtime = true;   // keep the recorded frame timing; false delivers as fast as buffers free up
+    bool loop = true;       // start over at the end instead of stopping
+};
+
+// Host source that plays back a FrameRecording, so the harness can run the
+// pipeline on footage captured on a device. Frames point straight into the
+// file mapping: replay copies nothing, and the planes keep the recorded
+// strides and chroma layout.
+//
+// A recording holds one stream, so only the first request is served, at the
+// recorded size; its maxImages limits frames in flight like an AImageReader.
+// In real time a frame that finds them all in flight is dropped, as on
+// device; at full speed the source waits for one instead. Timestamps are
+// shifted to start at open() but keep their recorded spacing.
+class ReplayFrameSource : public FrameSource {
+public:
+    explicit ReplayFrameSource(ReplayOptions options) : options_(std::move(options)) {}
+    ~ReplayFrameSource() override { close(); }
+
+    using FrameSource::open;
+    bool open(const std::vector<StreamRequest>& streams) override;
+    void close() override;
+    // Recorded frames cannot be re-exposed: returns `controls` and changes nothing.
+    CaptureControls setControls(const CaptureControls& controls) override { return controls; }
+    // As recorded, for the last frame delivered.
+    CaptureResultInfo lastCapture() const override;
+
+    size_t frames() const { return recording_ ? recording_->size() : 0; }
+    uint64_t delivered() const { return delivered_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    // Set once a non-looping replay has delivered its last frame.
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+
+private:
+    void run();
+    bool deliver(size_t index, int64_t shiftNs);
+
+    ReplayOptions options_;
+    std::unique_ptr<FrameRecording> recording_;
+    StreamRequest stream_;
+    std::unique_ptr<FramePool> pool_;
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<size_t> lastIndex_{0};
+    std::atomic<bool> finished_{false};
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
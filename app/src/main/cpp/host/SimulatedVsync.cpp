@@ -0,0 +1,32 @@
+#include "SimulatedVsync.h"
+#include "MonotonicClock.h"
+#include <chrono>
+
+void SimulatedVsync::start() {
+    if (running_) return;
+    open();
+    running_ = true;
+    thread_ = std::thread(&SimulatedVsync::run, this);
+}
+
+void SimulatedVsync::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    close();
+}
+
+void SimulatedVsync::run() {
+    int64_t next = monotonicNowNs() + periodNs_;
+    while (running_) {
+        const int64_t now = monotonicNowNs();
+        if (now < next) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+            continue;
+        }
+        // Stamped with when the vsync was due, not when we woke up, as a
+        // display's timestamps are.
+        tick(next);
+        next += periodNs_;
+        if (next <= now) next += (now - next) / periodNs_ * periodNs_ + periodNs_;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include "VsyncSource.h"
+
+// Host stand-in for ChoreographerVsync: ticks on a fixed grid of periodNs on
+// CLOCK_MONOTONIC, like a display refreshing at 1e9 / periodNs Hz.
+class SimulatedVsync : public VsyncSource {
+public:
+    explicit SimulatedVsync(int64_t periodNs) : periodNs_(periodNs) {}
+    ~SimulatedVsync() override { stop(); }
+
+    void start() override;
+    void stop() override;
+
+private:
+    void run();
+
+    const int64_t periodNs_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
@@ -0,0 +1,212 @@
+#define LOG_TAG "SyntheticFrameSource"
+
+#include "SyntheticFrameSource.h"
+#include "FrameTrace.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+SyntheticFrameSource::SyntheticFrameSource(SyntheticSourceOptions options)
+    : options_(std::move(options)), fps_(options_.fps) {}
+
+bool SyntheticFrameSource::open(const std::vector<StreamRequest>& requests) {
+    close();
+    setLost(false);
+    streams_.clear();
+    fileFrames_ = 0;
+    for (const StreamRequest& request : requests) {
+        const StreamConfig& config = request.config;
+        if (config.width <= 0 || config.height <= 0 || (config.width | config.height) & 1) {
+            LOGE("Unsupported stream size %dx%d", config.width, config.height);
+            return false;
+        }
+        auto stream = std::make_unique<Stream>();
+        stream->config = config;
+        stream->onFrame = request.onFrame;
+        stream->pool = std::make_unique<FramePool>(config.maxImages);
+        stream->images = std::make_unique<Image[]>(stream->pool->capacity());
+        for (int i = 0; i < stream->pool->capacity(); ++i) {
+            if (!layoutPattern(config, stream->images[i])) return false;
+        }
+        streams_.push_back(std::move(stream));
+    }
+    if (streams_.empty()) return false;
+    if (!options_.path.empty() && !loadFile(streams_[0]->config)) return false;
+
+    running_ = true;
+    thread_ = std::thread(&SyntheticFrameSource::run, this);
+    return true;
+}
+
+void SyntheticFrameSource::close() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+CaptureControls SyntheticFrameSource::setControls(const CaptureControls& requested) {
+    CaptureCapabilities capabilities;
+    capabilities.manualSensor = true;
+    CaptureControls controls = resolveControls(requested, capabilities);
+    fps_.store(controls.fps.max > 0 ? controls.fps.max : options_.fps, std::memory_order_relaxed);
+    exposureTimeNs_.store(controls.exposureTimeNs, std::memory_order_relaxed);
+    sensitivity_.store(controls.sensitivity, std::memory_order_relaxed);
+    return controls;
+}
+
+CaptureResultInfo SyntheticFrameSource::lastCapture() const {
+    CaptureResultInfo info;
+    info.frameDurationNs = lastFrameDurationNs_.load(std::memory_order_relaxed);
+    info.exposureTimeNs = lastExposureTimeNs_.load(std::memory_order_relaxed);
+    info.sensitivity = lastSensitivity_.load(std::memory_order_relaxed);
+    return info;
+}
+
+void SyntheticFrameSource::releaseImage(void* image) {
+    static_cast<Image*>(image)->busy.store(false, std::memory_order_release);
+}
+
+// Fills one buffer with a gradient in the configured plane layout. Frames only
+// get their counter stamped in, so generating one costs next to nothing.
+bool SyntheticFrameSource::layoutPattern(const StreamConfig& config, Image& image) {
+    const int w = config.width, h = config.height;
+    const int pixelStride = options_.pixelStride;
+    if (pixelStride != 1 && pixelStride != 2) {
+        LOGE("Unsupported chroma pixel stride %d", pixelStride);
+        return false;
+    }
+    const int yStride = w + options_.rowPadding;
+    const int cStride = (w / 2) * pixelStride + options_.rowPadding;
+    const size_t ySize = size_t(yStride) * h;
+    const size_t cSize = size_t(cStride) * (h / 2);
+
+    image.pixels.assign(ySize + cSize * (pixelStride == 1 ? 2 : 1), 0);
+    uint8_t* y = image.pixels.data();
+    uint8_t* c = y + ySize;
+    for (int row = 0; row < h; ++row)
+        for (int col = 0; col < w; ++col) y[row * yStride + col] = uint8_t(row + col);
+
+    image.planes[0] = {y, int(ySize), yStride, 1};
+    if (pixelStride == 1) {
+        for (int row = 0; row < h / 2; ++row) {
+            std::memset(c + row * cStride, 96, w / 2);
+            std::memset(c + cSize + row * cStride, 160, w / 2);
+        }
+        image.planes[1] = {c, int(cSize), cStride, 1};
+        image.planes[2] = {c + cSize, int(cSize), cStride, 1};
+    } else {
+        for (int row = 0; row < h / 2; ++row) {
+            for (int col = 0; col < w / 2; ++col) {
+                c[row * cStride + col * 2] = 96;
+                c[row * cStride + col * 2 + 1] = 160;
+            }
+        }
+        // Interleaved chroma: both planes alias one buffer, one byte apart.
+        image.planes[1] = {c, int(cSize - 1), cStride, 2};
+        image.planes[2] = {c + 1, int(cSize - 1), cStride, 2};
+    }
+    return true;
+}
+
+bool SyntheticFrameSource::loadFile(const StreamConfig& config) {
+    std::ifstream in(options_.path, std::ios::binary);
+    if (!in) {
+        LOGE("Cannot open %s", options_.path.c_str());
+        return false;
+    }
+    file_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    const size_t frameSize = size_t(config.width) * config.height * 3 / 2;
+    fileFrames_ = file_.size() / frameSize;
+    if (fileFrames_ == 0) {
+        LOGE("%s holds no complete %dx%d I420 frame", options_.path.c_str(), config.width, config.height);
+        return false;
+    }
+    LOGI("Replaying %zu frames from %s", fileFrames_, options_.path.c_str());
+    return true;
+}
+
+void SyntheticFrameSource::run() {
+    using Clock = std::chrono::steady_clock;
+    auto next = Clock::now();
+    uint64_t frameIndex = 0;
+
+    while (running_) {
+        const double fps = fps_.load(std::memory_order_relaxed);
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0));
+        if (fps > 0) {
+            next += period;
+            auto now = Clock::now();
+            if (next < now - period) next = now;  // fell behind: don't burst to catch up
+            std::this_thread::sleep_until(next);
+        }
+        CaptureResultInfo capture;
+        capture.frameNumber = int64_t(frameIndex);
+        capture.frameDurationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+        const int64_t exposureTimeNs = exposureTimeNs_.load(std::memory_order_relaxed);
+        capture.exposureTimeNs = exposureTimeNs > 0 ? exposureTimeNs : capture.frameDurationNs;
+        capture.sensitivity = sensitivity_.load(std::memory_order_relaxed);
+        lastFrameDurationNs_.store(capture.frameDurationNs, std::memory_order_relaxed);
+        lastExposureTimeNs_.store(capture.exposureTimeNs, std::memory_order_relaxed);
+        lastSensitivity_.store(capture.sensitivity, std::memory_order_relaxed);
+
+        capture.timestampNs = monotonicNowNs();
+        uint64_t before = streams_[0]->delivered.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < streams_.size(); ++i) deliver(*streams_[i], int(i), capture);
+        if (streams_[0]->delivered.load(std::memory_order_relaxed) == before && fps <= 0) {
+            std::this_thread::yield();
+        }
+        ++frameIndex;
+    }
+}
+
+void SyntheticFrameSource::deliver(Stream& stream, int index, const CaptureResultInfo& capture) {
+    Image* image = nullptr;
+    for (int i = 0; i < stream.pool->capacity(); ++i) {
+        bool expected = false;
+        if (stream.images[i].busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            image = &stream.images[i];
+            break;
+        }
+    }
+    if (!image) {
+        stream.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    FrameHandle frame = stream.pool->acquire(image, &SyntheticFrameSource::releaseImage);
+    if (!frame) {
+        image->busy.store(false, std::memory_order_release);
+        stream.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const StreamConfig& config = stream.config;
+    frame->width = config.width;
+    frame->height = config.height;
+    frame->format = kFormatYuv420;
+    frame->stream = index;
+    frame->timestampNs = capture.timestampNs;
+    frame->capture = capture;
+    frame->acquiredNs = monotonicNowNs();
+    frame->planeCount = 3;
+    // Each emulated reader buffer stands in for its own AHardwareBuffer.
+    if (config.gpuSampled) frame->hardwareBuffer = image;
+    const uint64_t frameIndex = uint64_t(capture.frameNumber);
+    if (index == 0 && fileFrames_ > 0) {
+        const int w = config.width, h = config.height;
+        const uint8_t* y = file_.data() + (frameIndex % fileFrames_) * (size_t(w) * h * 3 / 2);
+        const uint8_t* u = y + size_t(w) * h;
+        const uint8_t* v = u + size_t(w) * h / 4;
+        frame->planes[0] = {y, w * h, w, 1};
+        frame->planes[1] = {u, w * h / 4, w / 2, 1};
+        frame->planes[2] = {v, w * h / 4, w / 2, 1};
+    } else {
+        std::memcpy(image->pixels.data(), &frameIndex, sizeof(frameIndex));
+        for (int i = 0; i < 3; ++i) frame->planes[i] = image->planes[i];
+    }
+    // Frames are traced by timestamp, which every stream shares.
+    if (index == 0) FrameTrace::record(TraceStage::Acquire, frame->timestampNs, frame->timestampNs);
+    stream.delivered.fetch_add(1, std::memory_order_relaxed);
+    stream.onFrame(std::move(frame));
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameSource.h"
+
+struct SyntheticSourceOptions {
+    double fps = 30.0;     // <= 0 delivers frames as fast as the consumer frees buffers
+    int pixelStride = 1;   // chroma pixel stride: 1 = planar I420, 2 = interleaved like most devices
+    int rowPadding = 0;    // extra bytes at the end of every row, as ISPs often add
+    std::string path;      // raw I420 file to cycle through on the first stream instead of a test pattern
+};
+
+// Host stand-in for NativeCamera. Emulates one AImageReader per stream with
+// that stream's maxImages buffers: a frame that arrives while all of them are
+// held by the pipeline is dropped, just like acquireLatestImage failing on
+// device. Every tick produces one frame per stream with a shared timestamp,
+// as one capture request with several targets does.
+class SyntheticFrameSource : public FrameSource {
+public:
+    explicit SyntheticFrameSource(SyntheticSourceOptions options = {});
+    ~SyntheticFrameSource() override { close(); }
+
+    using FrameSource::open;
+    bool open(const std::vector<StreamRequest>& streams) override;
+    void close() override;
+    // Any fps range is accepted and paces frames at its maximum, overriding
+    // SyntheticSourceOptions::fps. Captures report that period as their frame
+    // duration, and the manual exposure if one is set (else the full frame).
+    // Frames come with their complete capture result.
+    CaptureControls setControls(const CaptureControls& controls) override;
+    CaptureResultInfo lastCapture() const override;
+
+    uint64_t delivered(int stream = 0) const { return streams_[stream]->delivered.load(std::memory_order_relaxed); }
+    uint64_t dropped(int stream = 0) const { return streams_[stream]->dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Image {
+        std::vector<uint8_t> pixels;
+        FramePlane planes[Frame::kMaxPlanes];
+        std::atomic<bool> busy{false};
+    };
+
+    struct Stream {
+        StreamConfig config;
+        FrameCallback onFrame;
+        std::unique_ptr<FramePool> pool;
+        std::unique_ptr<Image[]> images;
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    static void releaseImage(void* image);
+    bool layoutPattern(const StreamConfig& config, Image& image);
+    bool loadFile(const StreamConfig& config);
+    void deliver(Stream& stream, int index, const CaptureResultInfo& capture);
+    void run();
+
+    SyntheticSourceOptions options_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::vector<uint8_t> file_;
+    size_t fileFrames_ = 0;
+
+    std::atomic<double> fps_;
+    std::atomic<int64_t> exposureTimeNs_{0};
+    std::atomic<int32_t> sensitivity_{0};
+    std::atomic<int64_t> lastFrameDurationNs_{0};
+    std::atomic<int64_t> lastExposureTimeNs_{0};
+    std::atomic<int32_t> lastSensitivity_{0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
@@ -0,0 +1,72 @@
+// Times YuvConverter::upload() for each staging PBO ring depth on a headless
+// GLES 3 context (Mesa on a Linux host), drawing every frame as the render
+// loop does. Depth 0 is the synchronous glTexSubImage2D path.
+//
+//   upload-bench [frame-width frame-height] [frames]
+//
+// Software rasterizers copy synchronously whatever the path, so the split
+// between upload and wait is only meaningful on a real GPU driver.
+
+#include "HeadlessGlContext.h"
+#include "MonotonicClock.h"
+#include "PipelineStats.h"
+#include "YuvConverter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    int frames = std::max(1, argc > 3 ? std::atoi(argv[3]) : 300);
+
+    HeadlessGlContext gl;
+    if (!gl.create(width, height)) {
+        std::fprintf(stderr, "%s\n", gl.error());
+        return 1;
+    }
+
+    // Two interleaved-chroma buffers, alternated like a camera reader's.
+    const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    std::vector<uint8_t> buffers[2];
+    Frame frame[2];
+    for (int b = 0; b < 2; ++b) {
+        buffers[b].resize(size_t(width) * height + size_t(cw) * 2 * ch);
+        for (size_t i = 0; i < buffers[b].size(); ++i) buffers[b][i] = uint8_t(i * 7 + b);
+        uint8_t* y = buffers[b].data();
+        uint8_t* uv = y + size_t(width) * height;
+        frame[b].width = width;
+        frame[b].height = height;
+        frame[b].planeCount = 3;
+        frame[b].planes[0] = {y, width * height, width, 1};
+        frame[b].planes[1] = {uv, cw * 2 * ch - 1, cw * 2, 2};
+        frame[b].planes[2] = {uv + 1, cw * 2 * ch - 1, cw * 2, 2};
+    }
+
+    std::printf("%dx%d, %d frames per depth\n", width, height, frames);
+    std::printf("%5s  %10s  %10s  %10s  %8s\n", "PBOs", "upload p50", "upload p95", "wait mean", "fps");
+    ShaderCache shaders;
+    for (int depth = 0; depth <= YuvConverter::kMaxUploadBuffers; ++depth) {
+        YuvConverter converter;
+        converter.setUploadBuffers(depth);
+        if (!converter.init(shaders)) return 1;
+        StageStats upload, wait;
+        int64_t startNs = monotonicNowNs();
+        for (int i = 0; i < frames; ++i) {
+            int64_t beforeNs = monotonicNowNs();
+            converter.upload(frame[i % 2]);
+            upload.add(monotonicNowNs() - beforeNs);
+            wait.add(converter.lastUploadWaitNs());
+            converter.draw();
+            glFlush();
+        }
+        glFinish();
+        double seconds = (monotonicNowNs() - startNs) / 1e9;
+        std::printf("%5d  %7.3f ms  %7.3f ms  %7.3f ms  %8.1f\n", depth, upload.percentileNs(50) / 1e6,
+                    upload.percentileNs(95) / 1e6, wait.meanNs() / 1e6, frames / seconds);
+        converter.release();
+    }
+    shaders.release();
+    return 0;
+}
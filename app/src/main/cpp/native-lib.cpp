@@ -1,233 +1,414 @@
 // this runs
 
 // grayscale_preview_es3.cpp
-// OpenGL ES 3.0 grayscale YUV camera preview with dedicated render thread
+// OpenGL ES 3.0 grayscale YUV camera preview with dedicated render thread.
+// The camera, renderer and render loop live in NativeCamera, Renderer and
+// FramePipeline; this file only wires them to the NativeActivity lifecycle.
 
+#define LOG_TAG "GrayscalePreview"
+
+#include <android/asset_manager.h>
+#include <android/configuration.h>
+#include <android/looper.h>
 #include <android/native_activity.h>
 #include <android/native_window.h>
-#include <android/log.h>
-#include <EGL/egl.h>
-#include <GLES3/gl3.h>
-#include <media/NdkImageReader.h>
-#include <camera/NdkCameraManager.h>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
-
-#ifndef EGL_OPENGL_ES3_BIT_KHR
-#define EGL_OPENGL_ES3_BIT_KHR 0x00000040
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+#include "ChoreographerVsync.h"
+#include "Log.h"
+#include "MonotonicClock.h"
+#include "FramePipeline.h"
+#include "FrameRecorder.h"
+#include "FrameTrace.h"
+#include "InferenceStage.h"
+#include "NativeCamera.h"
+#include "Overlay.h"
+#include "Renderer.h"
+#include "SurfaceLifecycle.h"
+#include "VideoEncoder.h"
+#ifdef PIPELINE_HAVE_TFLITE
+#include "TfLiteModel.h"
 #endif
 
-#define LOG_TAG "GrayscalePreview"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-static ANativeWindow* window_ = nullptr;
-static EGLDisplay display_ = EGL_NO_DISPLAY;
-static EGLSurface surface_ = EGL_NO_SURFACE;
-static EGLContext context_ = EGL_NO_CONTEXT;
-static GLuint shaderProgram_ = 0, texY_ = 0, vbo_ = 0;
-static ACameraManager* cameraManager_ = nullptr;
-static ACameraDevice* cameraDevice_ = nullptr;
-static ACameraCaptureSession* captureSession_ = nullptr;
-static ACaptureRequest* request_ = nullptr;
-static AImageReader* imageReader_ = nullptr;
-
-static std::thread renderThread;
-static std::mutex frameMutex;
-static std::condition_variable frameCV;
-static std::queue<std::pair<uint8_t*, int>> frameQueue;
-static bool running = true;
-
-const char* vertexShaderSrc = "#version 300 es\n"
-                              "layout(location = 0) in vec4 a_Position;\n"
-                              "layout(location = 1) in vec2 a_TexCoord;\n"
-                              "out vec2 v_TexCoord;\n"
-                              "void main() {\n"
-                              "    gl_Position = a_Position;\n"
-                              "    v_TexCoord = a_TexCoord;\n"
-                              "}\n";
-
-const char* fragmentShaderSrc = "#version 300 es\n"
-                                "precision mediump float;\n"
-                                "in vec2 v_TexCoord;\n"
-                                "uniform sampler2D texY;\n"
-                                "out vec4 fragColor;\n"
-                                "void main() {\n"
-                                "    float y = texture(texY, v_TexCoord).r;\n"
-                                "    fragColor = vec4(y, y, y, 1.0);\n"
-                                "}\n";
-
-GLuint compile(GLenum type, const char* src) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-    GLint ok = 0;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        char log[512];
-        glGetShaderInfoLog(shader, 512, nullptr, log);
-        LOGE("Shader compile failed: %s", log);
+static Renderer gRenderer;
+static NativeCamera gCamera;
+// Draws at most once per refresh, always the newest frame.
+static ChoreographerVsync gVsync;
+static FramePipeline gPipeline(gRenderer);
+static std::string gTracePath;
+static std::string gModelPath;
+// Preview frames are recorded for replay on a host while this file exists.
+static std::string gRecordFlagPath;
+static std::string gRecordPath;
+static FrameRecorder gRecorder;
+// The rendered preview is encoded to an MP4 while this file exists.
+static std::string gEncodeFlagPath;
+static std::string gEncodePath;
+static VideoEncoder gEncoder;
+static AAssetManager* gAssets = nullptr;
+// The interpreters and the inference stage outlive the session: stopping and
+// starting it only stops and restarts them. They are released in onDestroy.
+static std::vector<std::unique_ptr<InferenceModel>> gModels;
+static std::unique_ptr<InferenceStage> gInference;
+static bool gModelsLoaded = false;
+
+// Two interpreters of two threads each keep four big cores busy without
+// starving the camera and render threads.
+static constexpr int kInferenceWorkers = 2;
+static constexpr int kThreadsPerInterpreter = 2;
+// The SSD, DeepLab and MobileNet models the overlay decodes are trained on
+// [-1, 1] pixels when they are float models.
+static const InputNormalization kModelInput{127.5f, 1.0f / 127.5f};
+// PBOs for preview frames that cannot be sampled in place: two let one
+// frame's upload overlap the previous frame's draw.
+static constexpr int kUploadBuffers = 2;
+// Detections less certain than this are not drawn.
+static constexpr float kMinDetectionScore = 0.5f;
+// Nor are keypoints.
+static constexpr float kMinKeypointScore = 0.3f;
+// Stream sizes that cannot keep up with this are never picked.
+static constexpr double kMinFps = 30.0;
+
+#ifdef PIPELINE_HAVE_TFLITE
+// model.tflite from app storage if one was pushed there, else from the APK.
+// Either way the file is mmapped; assets must be stored uncompressed.
+static std::unique_ptr<TfLiteModel> loadModel() {
+    if (access(gModelPath.c_str(), R_OK) == 0) {
+        return TfLiteModel::load(gModelPath.c_str(), kThreadsPerInterpreter, kModelInput);
     }
-    return shader;
+    if (!gAssets) return nullptr;
+    AAsset* asset = AAssetManager_open(gAssets, "model.tflite", AASSET_MODE_UNKNOWN);
+    if (!asset) {
+        LOGI("No model.tflite in app storage or assets; running without inference");
+        return nullptr;
+    }
+    off_t offset = 0, length = 0;
+    int fd = AAsset_openFileDescriptor(asset, &offset, &length);
+    AAsset_close(asset);
+    if (fd < 0) {
+        LOGE("assets/model.tflite is compressed; it has to be stored to be mapped");
+        return nullptr;
+    }
+    std::unique_ptr<TfLiteModel> model =
+            TfLiteModel::load(fd, offset, size_t(length), "assets/model.tflite", kThreadsPerInterpreter, kModelInput);
+    close(fd);
+    return model;
 }
 
-void initGL() {
-    GLuint vs = compile(GL_VERTEX_SHADER, vertexShaderSrc);
-    GLuint fs = compile(GL_FRAGMENT_SHADER, fragmentShaderSrc);
-    shaderProgram_ = glCreateProgram();
-    glAttachShader(shaderProgram_, vs);
-    glAttachShader(shaderProgram_, fs);
-    glLinkProgram(shaderProgram_);
-    GLint linkOK = 0;
-    glGetProgramiv(shaderProgram_, GL_LINK_STATUS, &linkOK);
-    if (!linkOK) {
-        char log[512];
-        glGetProgramInfoLog(shaderProgram_, 512, nullptr, log);
-        LOGE("Program link failed: %s", log);
-    }
-    glUseProgram(shaderProgram_);
+// What the segmentation decoder reads the loaded model's output as.
+static MaskLayout gMaskLayout;
 
-    const GLfloat quad[] = {
-            -1, -1,  0, 1,
-            1, -1,  1, 1,
-            -1,  1,  0, 0,
-            1,  1,  1, 0,
-    };
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-
-    glGenTextures(1, &texY_);
-    glBindTexture(GL_TEXTURE_2D, texY_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 640, 480, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glUniform1i(glGetUniformLocation(shaderProgram_, "texY"), 0);
+// The overlay follows the model's outputs: a single [1][1][K][3] tensor is
+// MoveNet keypoints, a single [1][H][W][C] one a segmentation mask, and
+// anything else stays with the SSD detector's decoder.
+static void chooseOverlayDecoder(const TfLiteModel& model) {
+    const std::vector<int> dims = model.outputCount() == 1 ? model.outputDims(0) : std::vector<int>();
+    if (dims.size() != 4 || dims[0] != 1) return;
+    if (dims[1] == 1 && dims[3] == 3) {
+        LOGI("Drawing %d pose keypoints", dims[2]);
+        gRenderer.setOverlayDecoder([](const InferenceResult& result, Overlay& overlay) {
+            return decodePoseKeypoints(result, kMinKeypointScore, overlay);
+        });
+    } else if (dims[1] > 1 && dims[2] > 1) {
+        gMaskLayout.width = dims[2];
+        gMaskLayout.height = dims[1];
+        gMaskLayout.classes = dims[3];
+        LOGI("Drawing a %dx%d segmentation mask of %d classes", dims[2], dims[1], dims[3]);
+        gRenderer.setOverlayDecoder([](const InferenceResult& result, Overlay& overlay) {
+            return decodeSegmentationMask(result, gMaskLayout, overlay);
+        });
+    }
 }
+#endif
 
-void drawLoop() {
-    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
-        LOGE("eglMakeCurrent failed in drawLoop: 0x%x", eglGetError());
-        return;
+static void loadInference() {
+    gModelsLoaded = true;
+#ifdef PIPELINE_HAVE_TFLITE
+    std::unique_ptr<TfLiteModel> model = loadModel();
+    if (!model) return;
+    chooseOverlayDecoder(*model);
+    std::vector<std::unique_ptr<TfLiteModel>> loaded;
+    for (int i = 1; i < kInferenceWorkers; ++i) {
+        if (std::unique_ptr<TfLiteModel> clone = model->clone(kThreadsPerInterpreter)) loaded.push_back(std::move(clone));
     }
-    initGL();
-    while (running) {
-        LOGE("running");
-        std::unique_lock<std::mutex> lock(frameMutex);
-        frameCV.wait(lock, [] { return !frameQueue.empty() || !running; });
-        if (!running) break;
-        auto [yPlane, width] = frameQueue.front();
-        frameQueue.pop();
-        lock.unlock();
-
-        glClearColor(0.0, 0.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(shaderProgram_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texY_);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, 480, GL_RED, GL_UNSIGNED_BYTE, yPlane);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-        eglSwapBuffers(display_, surface_);
+    loaded.push_back(std::move(model));
+    // Pay for kernel preparation here rather than on the first camera frame.
+    for (auto& tflite : loaded) {
+        tflite->invoke();
+        tflite->logLoadTimes();
+        gModels.push_back(std::move(tflite));
     }
+#endif
+    if (gModels.empty()) return;
+    std::vector<InferenceModel*> models;
+    for (auto& model : gModels) models.push_back(model.get());
+    gInference = std::make_unique<InferenceStage>(models, DispatchPolicy::LeastLoaded);
 }
 
-void onImageAvailable(void* context, AImageReader* reader) {
-    AImage* image = nullptr;
-    if (AImageReader_acquireLatestImage(reader, &image) == AMEDIA_OK && image) {
-        uint8_t* yPlane = nullptr;
-        int yLen, width;
-        AImage_getPlaneData(image, 0, &yPlane, &yLen);
-        AImage_getWidth(image, &width);
-        frameMutex.lock();
-        frameQueue.emplace(yPlane, width);
-        frameMutex.unlock();
-        frameCV.notify_one();
-        AImage_delete(image);
-    }
+// The manifest handles orientation changes itself, so the activity survives a
+// rotation and only the surface is resized; the renderer picks the new size up
+// on its next frame. The camera just needs to know which way is up now.
+// AConfiguration only reports portrait or landscape, so reverse orientations
+// (180, 270) would need Display.getRotation() through JNI.
+static void applyDisplayRotation(ANativeActivity* activity) {
+    AConfiguration* config = AConfiguration_new();
+    AConfiguration_fromAssetManager(config, activity->assetManager);
+    const int rotation = AConfiguration_getOrientation(config) == ACONFIGURATION_ORIENTATION_LAND ? 90 : 0;
+    AConfiguration_delete(config);
+    gCamera.setDisplayRotation(rotation);
+    LOGI("Display rotation %d degrees", rotation);
+}
+
+static void onConfigurationChanged(ANativeActivity* activity) { applyDisplayRotation(activity); }
+
+// Snaps a stream to the closest size the sensor offers. Keeps the requested
+// size if the camera lists none.
+static void chooseStreamSize(const char* name, const SizeTarget& target, StreamConfig& config) {
+    const StreamSize size = gCamera.streamSizes().select(target);
+    if (!size) return;
+    config.width = size.width;
+    config.height = size.height;
+    LOGI("%s stream: %dx%d for a %dx%d target, up to %.0f fps", name, size.width, size.height, target.width,
+         target.height, size.maxFps());
 }
 
-void openCamera() {
-    cameraManager_ = ACameraManager_create();
-    ACameraIdList* cameraIds;
-    ACameraManager_getCameraIdList(cameraManager_, &cameraIds);
-    const char* camId = cameraIds->cameraIds[0];
+// The camera session, the GL context and inference run from the first window
+// until the activity has been without one for a few seconds; a window that
+// comes back sooner (app switch, lock screen) only gets a new surface and a
+// restarted render thread.
+class PreviewSession : public LifecycleHost {
+public:
+    bool startSession(ANativeWindow* window) override;
+    void stopSession() override;
+    bool attachWindow(ANativeWindow* window) override;
+    void detachWindow() override;
+};
+
+bool PreviewSession::startSession(ANativeWindow* window) {
+    int64_t startNs = monotonicNowNs();
+    if (!gRenderer.init()) return false;
 
-    ACameraDevice_StateCallbacks stateCallbacks = {};
-    ACameraManager_openCamera(cameraManager_, camId, &stateCallbacks, &cameraDevice_);
+    const bool cached = gModelsLoaded;
+    if (!cached) loadInference();
+    if (gInference) {
+        gPipeline.setInferenceResults(&gInference->results());
+        gInference->start();
+    } else {
+        gPipeline.setInferenceResults(nullptr);
+    }
 
-    AImageReader_new(640, 480, AIMAGE_FORMAT_YUV_420_888, 3, &imageReader_);
-    AImageReader_ImageListener listener = { .context = nullptr, .onImageAvailable = onImageAvailable };
-    AImageReader_setImageListener(imageReader_, &listener);
+    // Preview: two queued, one drawing, plus the one the reader is acquiring,
+    // plus the previous frame the GPU may still be sampling in place.
+    StreamRequest preview;
+    SizeTarget previewTarget;
+    previewTarget.width = 640;
+    previewTarget.height = 480;
+    previewTarget.aspect = 4.0 / 3.0;
+    previewTarget.minFps = kMinFps;
+    preview.config.width = previewTarget.width;
+    preview.config.height = previewTarget.height;
+    chooseStreamSize("Preview", previewTarget, preview.config);
+    preview.config.maxImages = 5;
+    preview.config.gpuSampled = true;
+    if (access(gEncodeFlagPath.c_str(), F_OK) == 0) {
+        // The video gets the preview stream's pixels, upright the way the
+        // window is.
+        VideoEncoderConfig video;
+        const bool portrait = ANativeWindow_getWidth(window) < ANativeWindow_getHeight(window);
+        video.width = portrait ? preview.config.height : preview.config.width;
+        video.height = portrait ? preview.config.width : preview.config.height;
+        video.fps = int(kMinFps);
+        gRenderer.setEncoder(gEncoder.start(gEncodePath.c_str(), video) ? &gEncoder : nullptr);
+    } else {
+        gRenderer.setEncoder(nullptr);
+    }
+    gPipeline.setVsync(&gVsync);
+    if (access(gRecordFlagPath.c_str(), F_OK) == 0) gRecorder.open(gRecordPath.c_str());
+    // With no window attached the pipeline turns frames away, straight back
+    // to the reader.
+    preview.onFrame = [](FrameHandle frame) {
+        if (gRecorder.isOpen()) gRecorder.record(*frame);
+        gPipeline.submit(std::move(frame));
+    };
+    std::vector<StreamRequest> streams{preview};
+    if (gInference) {
+        // The model only needs a few hundred pixels a side, so it gets its own
+        // small stream rather than downscaling every preview frame: the
+        // smallest one covering the model input, with the preview's field of
+        // view. Each worker holds two queued and one being preprocessed.
+        StreamRequest analysis;
+        const TensorShape& input = gModels.front()->inputShape();
+        SizeTarget analysisTarget;
+        analysisTarget.width = input.width;
+        analysisTarget.height = input.height;
+        analysisTarget.aspect = double(preview.config.width) / preview.config.height;
+        analysisTarget.minFps = kMinFps;
+        analysis.config.width = 320;
+        analysis.config.height = 240;
+        chooseStreamSize("Analysis", analysisTarget, analysis.config);
+        analysis.config.maxImages = 1 + 3 * gInference->workers();
+        analysis.onFrame = [](FrameHandle frame) { gInference->submit(std::move(frame)); };
+        streams.push_back(analysis);
+    }
+    // Inference throughput follows the frame rate, so hold it in low light.
+    CaptureControls controls;
+    controls.fps = {int(kMinFps), int(kMinFps)};
+    gCamera.setControls(controls);
+    // Without a camera the preview would sit black and nothing would retry;
+    // failing lets the next window start over.
+    if (!gCamera.open(streams)) return false;
+    LOGI("Session started in %.1f ms (%s)", (monotonicNowNs() - startNs) / 1e6,
+         !gInference ? "no model" : cached ? "model cached" : "model loaded");
+    return true;
+}
 
-    ANativeWindow* readerWindow;
-    AImageReader_getWindow(imageReader_, &readerWindow);
+bool PreviewSession::attachWindow(ANativeWindow* window) {
+    // The camera may have been taken away while the session waited without
+    // a window; resuming onto it would draw nothing, forever.
+    if (gCamera.lost()) {
+        LOGW("Camera lost while suspended");
+        return false;
+    }
+    if (!gRenderer.setWindow(window)) return false;
+    gPipeline.start();
+    return true;
+}
 
-    ACameraDevice_createCaptureRequest(cameraDevice_, TEMPLATE_PREVIEW, &request_);
-    ACameraOutputTarget* outputTarget;
-    ACameraOutputTarget_create(readerWindow, &outputTarget);
-    ACaptureRequest_addTarget(request_, outputTarget);
+void PreviewSession::detachWindow() {
+    // The render thread lets go of the surface (and of the encoder's) before
+    // the window does.
+    gPipeline.stop();
+    gRenderer.setWindow(nullptr);
+    const FramePipeline::Ring& ring = gPipeline.ring();
+    LOGI("Frame ring: %llu published, %llu evicted, %llu rejected, %llu skipped",
+         (unsigned long long)ring.published(), (unsigned long long)ring.droppedOldest(),
+         (unsigned long long)ring.droppedNewest(), (unsigned long long)ring.skipped());
+    gPipeline.stats().log();
+}
 
-    ACaptureSessionOutputContainer* outputs;
-    ACaptureSessionOutputContainer_create(&outputs);
-    ACaptureSessionOutput* sessionOutput;
-    ACaptureSessionOutput_create(readerWindow, &sessionOutput);
-    ACaptureSessionOutputContainer_add(outputs, sessionOutput);
+void PreviewSession::stopSession() {
+    // The render thread is already stopped, so every preview frame is back
+    // with the reader before the camera deletes it.
+    if (gInference) gInference->stop();
+    const CaptureResultInfo capture = gCamera.lastCapture();
+    gCamera.close();
+    gRecorder.close();
+    // The render thread has dropped the encoder's surface; finish the file.
+    gEncoder.stop();
+    gRenderer.shutdown();
+    LOGI("Last capture: %.1f fps, exposure %.2f ms, ISO %d", capture.fps(), capture.exposureTimeNs / 1e6,
+         capture.sensitivity);
+    if (gInference) gInference->logStats();
 
-    ACameraCaptureSession_stateCallbacks sessionCallbacks = {};
-    ACameraDevice_createCaptureSession(cameraDevice_, outputs, &sessionCallbacks, &captureSession_);
-    ACameraCaptureSession_setRepeatingRequest(captureSession_, nullptr, 1, &request_, nullptr);
+    for (int i = 0; i < gCamera.streamCount(); ++i) {
+        if (const FramePool* pool = gCamera.framePool(i)) {
+            LOGI("Stream %d frames in flight: %d (peak %d, pool exhausted %llu times)", i,
+                 pool->inFlight(), pool->peakInFlight(), (unsigned long long)pool->exhausted());
+        }
+    }
+    FrameTrace::logSummary();
+    if (!gTracePath.empty()) FrameTrace::writeChromeTrace(gTracePath.c_str());
 }
 
-void initEGL(ANativeWindow* win) {
-    window_ = win;
-    display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, nullptr, nullptr)) {
-        LOGE("EGL initialization failed");
-        return;
+static PreviewSession gSession;
+static SurfaceLifecycle gLifecycle(gSession);
+// Fires on the main thread's looper when the lifecycle's grace period runs
+// out, so every lifecycle call comes from the one thread.
+static int gLifecycleTimer = -1;
+
+static void armLifecycleTimer() {
+    if (gLifecycleTimer < 0) return;
+    itimerspec spec = {};  // zero disarms
+    const int64_t deadlineNs = gLifecycle.deadlineNs();
+    if (deadlineNs >= 0) {
+        spec.it_value.tv_sec = time_t(deadlineNs / 1000000000);
+        spec.it_value.tv_nsec = long(deadlineNs % 1000000000);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) spec.it_value.tv_nsec = 1;
     }
+    timerfd_settime(gLifecycleTimer, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
 
-    EGLConfig config;
-    EGLint numConfigs;
-    const EGLint attribs[] = {
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
-            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
-            EGL_ALPHA_SIZE, 8, EGL_NONE
-    };
-    const EGLint ctxAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+static int onLifecycleTimer(int fd, int, void*) {
+    uint64_t expirations = 0;
+    if (read(fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) return 1;
+    gLifecycle.poll(monotonicNowNs());
+    armLifecycleTimer();
+    return 1;  // keep the fd registered
+}
 
-    eglChooseConfig(display_, attribs, &config, 1, &numConfigs);
-    context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, ctxAttribs);
-    surface_ = eglCreateWindowSurface(display_, config, window_, nullptr);
+static void onWindowCreated(ANativeActivity* activity, ANativeWindow* window) {
+    int64_t startNs = monotonicNowNs();
+    applyDisplayRotation(activity);
+    const uint64_t resumed = gLifecycle.warmResumes();
+    const bool ready = gLifecycle.onWindowCreated(window);
+    armLifecycleTimer();
+    if (!ready) return;
+    LOGI("Window ready in %.1f ms (%s)", (monotonicNowNs() - startNs) / 1e6,
+         gLifecycle.warmResumes() > resumed ? "session resumed" : "session started");
 }
 
-extern "C" void ANativeActivity_onCreate(ANativeActivity* activity, void*, size_t) {
-    activity->callbacks->onNativeWindowCreated = [](ANativeActivity*, ANativeWindow* win) {
-        initEGL(win);
-        openCamera();
-        renderThread = std::thread(drawLoop);
-    };
+static void onWindowDestroyed(ANativeActivity*, ANativeWindow*) {
+    gLifecycle.onWindowDestroyed(monotonicNowNs());
+    armLifecycleTimer();
+}
 
-    activity->callbacks->onNativeWindowDestroyed = [](ANativeActivity*, ANativeWindow*) {
-        running = false;
-        frameCV.notify_all();
-        if (renderThread.joinable()) renderThread.join();
-        if (context_ != EGL_NO_CONTEXT) eglDestroyContext(display_, context_);
-        if (surface_ != EGL_NO_SURFACE) eglDestroySurface(display_, surface_);
-        if (display_ != EGL_NO_DISPLAY) eglTerminate(display_);
-        display_ = EGL_NO_DISPLAY;
-        surface_ = EGL_NO_SURFACE;
-        context_ = EGL_NO_CONTEXT;
-    };
+static void onDestroy(ANativeActivity*) {
+    gLifecycle.onDestroy();
+    if (gLifecycleTimer >= 0) {
+        if (ALooper* looper = ALooper_forThread()) ALooper_removeFd(looper, gLifecycleTimer);
+        close(gLifecycleTimer);
+        gLifecycleTimer = -1;
+    }
+    gInference.reset();
+    gModels.clear();
+    gModelsLoaded = false;
+    // The process may be killed any time after this; get the stats out.
+    Log::flush();
+}
+
+extern "C" void ANativeActivity_onCreate(ANativeActivity* activity, void*, size_t) {
+    // Pull with: adb shell run-as com.example.ndkcamera cat files/frame_trace.json
+    if (activity->internalDataPath) {
+        gTracePath = std::string(activity->internalDataPath) + "/frame_trace.json";
+        // Install with: adb push model.tflite /data/local/tmp/ &&
+        //   adb shell run-as com.example.ndkcamera cp /data/local/tmp/model.tflite files/
+        gModelPath = std::string(activity->internalDataPath) + "/model.tflite";
+        // Start with: adb shell run-as com.example.ndkcamera touch files/record
+        // Pull with: adb shell run-as com.example.ndkcamera cat files/preview.frames > preview.frames
+        gRecordFlagPath = std::string(activity->internalDataPath) + "/record";
+        gRecordPath = std::string(activity->internalDataPath) + "/preview.frames";
+        // Start with: adb shell run-as com.example.ndkcamera touch files/encode
+        // Pull with: adb shell run-as com.example.ndkcamera cat files/preview.mp4 > preview.mp4
+        gEncodeFlagPath = std::string(activity->internalDataPath) + "/encode";
+        gEncodePath = std::string(activity->internalDataPath) + "/preview.mp4";
+        // Linked shader binaries go to the app's cache directory, the files
+        // directory's sibling, which the system may clear whenever it likes.
+        std::string cacheDir = activity->internalDataPath;
+        cacheDir = cacheDir.substr(0, cacheDir.rfind('/')) + "/cache";
+        if (mkdir(cacheDir.c_str(), 0700) == 0 || errno == EEXIST) gRenderer.setShaderCacheDirectory(cacheDir);
+    }
+    gAssets = activity->assetManager;
+    gRenderer.setUploadBuffers(kUploadBuffers);
+    gRenderer.setOverlayDecoder([](const InferenceResult& result, Overlay& overlay) {
+        return decodeSsdDetections(result, kMinDetectionScore, overlay);
+    });
+    FrameTrace::setEnabled(true);
+    ALooper* looper = ALooper_forThread();
+    gLifecycleTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (gLifecycleTimer >= 0 &&
+        (!looper || ALooper_addFd(looper, gLifecycleTimer, ALOOPER_POLL_CALLBACK, ALOOPER_EVENT_INPUT,
+                                  onLifecycleTimer, nullptr) != 1)) {
+        close(gLifecycleTimer);
+        gLifecycleTimer = -1;
+    }
+    if (gLifecycleTimer < 0) LOGW("No lifecycle timer; a session without a window lasts until the next one");
+    activity->callbacks->onDestroy = onDestroy;
+    activity->callbacks->onNativeWindowCreated = onWindowCreated;
+    activity->callbacks->onNativeWindowDestroyed = onWindowDestroyed;
+    activity->callbacks->onConfigurationChanged = onConfigurationChanged;
 }
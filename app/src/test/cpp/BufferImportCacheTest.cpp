@@ -0,0 +1,105 @@
+#include "BufferImportCache.h"
+#include "FramePipeline.h"
+#include "HeadlessRenderer.h"
+#include "SyntheticFrameSource.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace {
+
+// Records what is live so tests can check nothing leaks or is imported twice.
+class RecordingImporter : public BufferImporter {
+public:
+    uint32_t import(void* buffer) override {
+        if (failing.count(buffer)) return 0;
+        ++importCalls[buffer];
+        uint32_t texture = ++lastTexture;
+        live[texture] = buffer;
+        return texture;
+    }
+    void release(void* buffer, uint32_t texture) override {
+        EXPECT_EQ(live[texture], buffer);
+        live.erase(texture);
+    }
+
+    std::map<void*, int> importCalls;
+    std::map<uint32_t, void*> live;
+    std::set<void*> failing;
+    uint32_t lastTexture = 0;
+};
+
+void* bufferId(int i) { return reinterpret_cast<void*>(uintptr_t(0x1000 + i * 16)); }
+
+TEST(BufferImportCacheTest, ImportsEachBufferOnce) {
+    RecordingImporter importer;
+    BufferImportCache cache(importer);
+    uint32_t first[4];
+    for (int lap = 0; lap < 10; ++lap) {
+        for (int i = 0; i < 4; ++i) {
+            uint32_t texture = cache.texture(bufferId(i));
+            if (lap == 0) first[i] = texture;
+            EXPECT_EQ(texture, first[i]);
+        }
+    }
+    EXPECT_EQ(cache.imports(), 4u);
+    EXPECT_EQ(cache.hits(), 36u);
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(importer.importCalls[bufferId(i)], 1);
+    cache.clear();
+    EXPECT_TRUE(importer.live.empty());
+}
+
+TEST(BufferImportCacheTest, EvictsLeastRecentlyUsed) {
+    RecordingImporter importer;
+    BufferImportCache cache(importer);
+    for (int i = 0; i < BufferImportCache::kCapacity; ++i) cache.texture(bufferId(i));
+    // Touch buffer 0 so buffer 1 becomes the oldest.
+    cache.texture(bufferId(0));
+    cache.texture(bufferId(100));
+    EXPECT_EQ(cache.evictions(), 1u);
+    EXPECT_EQ(cache.size(), BufferImportCache::kCapacity);
+    EXPECT_EQ(importer.live.size(), size_t(BufferImportCache::kCapacity));
+    for (const auto& entry : importer.live) EXPECT_NE(entry.second, bufferId(1));
+    cache.texture(bufferId(0));
+    EXPECT_EQ(importer.importCalls[bufferId(0)], 1);
+}
+
+TEST(BufferImportCacheTest, RemembersBuffersThatFailToImport) {
+    RecordingImporter importer;
+    importer.failing.insert(bufferId(7));
+    BufferImportCache cache(importer);
+    EXPECT_EQ(cache.texture(bufferId(7)), 0u);
+    EXPECT_EQ(cache.texture(bufferId(7)), 0u);
+    EXPECT_EQ(cache.failures(), 1u);
+    EXPECT_EQ(cache.imports(), 0u);
+}
+
+TEST(BufferImportCacheTest, ZeroCopyPipelineImportsEveryReaderBufferOnce) {
+    HeadlessRenderer renderer;
+    renderer.setImportBuffers(true);
+    FramePipeline pipeline(renderer);
+    SyntheticSourceOptions options;
+    options.fps = 500;
+    SyntheticFrameSource source(options);
+    StreamConfig config;
+    config.maxImages = 5;
+    config.gpuSampled = true;
+
+    pipeline.start();
+    ASSERT_TRUE(source.open(config, [&](FrameHandle frame) { pipeline.submit(std::move(frame)); }));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (source.delivered() < 50 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pipeline.stop();
+    source.close();
+
+    const BufferImportCache& imports = renderer.imports();
+    EXPECT_EQ(imports.hits() + imports.imports(), pipeline.stats().presented);
+    EXPECT_LE(imports.imports(), uint64_t(config.maxImages));
+    EXPECT_EQ(renderer.framesCopied(), 0u);
+}
+
+}  // namespace
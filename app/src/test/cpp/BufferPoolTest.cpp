@@ -0,0 +1,133 @@
+#include "BufferPool.h"
+#include "FrameCopy.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST(BufferPoolTest, BuffersAreAlignedAndRecycledWithinTheirClass) {
+    BufferPool pool;
+    PooledBuffer first = pool.acquire(1000);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first.data()) % BufferPool::kAlignment, 0u);
+    EXPECT_EQ(first.size(), 1000u);
+    uint8_t* data = first.data();
+    first.reset();
+
+    // Same class (1 KiB), so the cached buffer comes back.
+    PooledBuffer second = pool.acquire(600);
+    EXPECT_EQ(second.data(), data);
+    const int sizeClass = BufferPool::classFor(1000);
+    EXPECT_EQ(BufferPool::classBytes(sizeClass), 1024u);
+    EXPECT_EQ(pool.stats(sizeClass).acquires, 2u);
+    EXPECT_EQ(pool.stats(sizeClass).allocations, 1u);
+
+    EXPECT_FALSE(pool.acquire(0));
+    EXPECT_FALSE(pool.acquire(BufferPool::classBytes(BufferPool::kClassCount - 1) + 1));
+}
+
+TEST(BufferPoolTest, TracksHighWaterMarks) {
+    BufferPool pool;
+    pool.reserve(4096, 2);
+    const int sizeClass = BufferPool::classFor(4096);
+    {
+        std::vector<PooledBuffer> held;
+        for (int i = 0; i < 5; ++i) held.push_back(pool.acquire(4096));
+        EXPECT_EQ(pool.stats(sizeClass).outstanding, 5);
+    }
+    BufferPool::ClassStats stats = pool.stats(sizeClass);
+    EXPECT_EQ(stats.outstanding, 0);
+    EXPECT_EQ(stats.peakOutstanding, 5);
+    EXPECT_EQ(stats.allocations, 5u);  // two reserved, three on demand
+    EXPECT_EQ(pool.peakBytes(), 5u * 4096);
+
+    // Warm: the same pattern no longer allocates.
+    std::vector<PooledBuffer> again;
+    for (int i = 0; i < 5; ++i) again.push_back(pool.acquire(4096));
+    EXPECT_EQ(pool.stats(sizeClass).allocations, 5u);
+}
+
+TEST(BufferPoolTest, BuffersCrossThreadsWithoutLosingAny) {
+    BufferPool pool;
+    constexpr int kPerThread = 20000;
+    std::atomic<uint8_t*> handoff[4] = {};
+    std::atomic<bool> done{false};
+    // Producers acquire and hand buffers over; the consumer recycles them.
+    std::thread consumer([&] {
+        while (!done.load() || [&] {
+            for (auto& slot : handoff) if (slot.load()) return true;
+            return false;
+        }()) {
+            for (auto& slot : handoff) {
+                if (uint8_t* data = slot.exchange(nullptr)) BufferPool::recycle(data);
+            }
+            std::this_thread::yield();
+        }
+    });
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 2; ++t) {
+        producers.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                PooledBuffer buffer = pool.acquire(size_t(256) << (i % 3));
+                buffer.data()[0] = uint8_t(i);
+                uint8_t* data = buffer.release();
+                auto& slot = handoff[t * 2 + i % 2];
+                uint8_t* expected = nullptr;
+                // Yielding lets the consumer run even on a single core.
+                while (!slot.compare_exchange_weak(expected, data)) {
+                    expected = nullptr;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    done = true;
+    consumer.join();
+
+    uint64_t acquires = 0;
+    for (int c = 0; c < BufferPool::kClassCount; ++c) {
+        EXPECT_EQ(pool.stats(c).outstanding, 0);
+        acquires += pool.stats(c).acquires;
+    }
+    EXPECT_EQ(acquires, 2u * kPerThread);
+}
+
+TEST(BufferPoolTest, CopiedFrameKeepsInterleavedChromaAndOutlivesTheSource) {
+    constexpr int kWidth = 16, kHeight = 8, kStride = 20;
+    std::vector<uint8_t> source(size_t(kStride) * kHeight * 3 / 2);
+    for (size_t i = 0; i < source.size(); ++i) source[i] = uint8_t(i * 7);
+    bool sourceReleased = false;
+
+    FramePool sourcePool(1), copyPool(2);
+    BufferPool buffers;
+    FrameHandle frame = sourcePool.acquire(&sourceReleased, [](void* flag) { *static_cast<bool*>(flag) = true; });
+    ASSERT_TRUE(frame);
+    uint8_t* chroma = source.data() + kStride * kHeight;
+    const int chromaLength = kStride * kHeight / 2;
+    frame->width = kWidth;
+    frame->height = kHeight;
+    frame->timestampNs = 1234;
+    frame->rotation = 90;
+    frame->planeCount = 3;
+    frame->planes[0] = {source.data(), kStride * kHeight, kStride, 1};
+    frame->planes[1] = {chroma, chromaLength - 1, kStride, 2};      // U
+    frame->planes[2] = {chroma + 1, chromaLength - 1, kStride, 2};  // V
+
+    FrameHandle copy = copyFrame(*frame, copyPool, buffers);
+    frame.reset();
+    EXPECT_TRUE(sourceReleased);
+    ASSERT_TRUE(copy);
+    EXPECT_EQ(copy->timestampNs, 1234);
+    EXPECT_EQ(copy->rotation, 90);
+    EXPECT_EQ(copy->planes[2].data, copy->planes[1].data + 1);
+    EXPECT_EQ(copy->planes[1].rowStride, kStride);
+    EXPECT_EQ(0, std::memcmp(copy->planes[0].data, source.data(), kStride * kHeight));
+    EXPECT_EQ(0, std::memcmp(copy->planes[1].data, chroma, chromaLength));
+
+    const int sizeClass = BufferPool::classFor(source.size());
+    EXPECT_EQ(buffers.stats(sizeClass).outstanding, 1);
+    copy.reset();
+    EXPECT_EQ(buffers.stats(sizeClass).outstanding, 0);
+}
@@ -0,0 +1,94 @@
+#include "CaptureControls.h"
+#include <gtest/gtest.h>
+#include <iterator>
+
+namespace {
+
+// A typical phone back camera: AE ranges as listed in
+// ACAMERA_CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES, with manual sensor control.
+CaptureCapabilities phoneCamera() {
+    const int32_t ranges[] = {15, 15, 7, 30, 15, 30, 24, 24, 30, 30};
+    CaptureCapabilities capabilities;
+    capabilities.setFpsRanges(ranges, std::size(ranges));
+    capabilities.minExposureNs = 10000;
+    capabilities.maxExposureNs = 200000000;
+    capabilities.minSensitivity = 50;
+    capabilities.maxSensitivity = 3200;
+    capabilities.minCompensation = -12;
+    capabilities.maxCompensation = 12;
+    capabilities.minFocusDistance = 10.0f;
+    capabilities.focusModes = {FocusMode::Fixed, FocusMode::Auto, FocusMode::Continuous};
+    capabilities.manualSensor = true;
+    return capabilities;
+}
+
+}  // namespace
+
+TEST(CaptureControlsTest, FpsRangeSnapsToTheClosestListedOne) {
+    CaptureControls controls;
+    controls.fps = {30, 30};
+    EXPECT_EQ(resolveControls(controls, phoneCamera()).fps, (FpsRange{30, 30}));
+    // Nothing reaches 60: the fastest fixed range wins over a variable one.
+    controls.fps = {60, 60};
+    EXPECT_EQ(resolveControls(controls, phoneCamera()).fps, (FpsRange{30, 30}));
+    controls.fps = {10, 30};
+    EXPECT_EQ(resolveControls(controls, phoneCamera()).fps, (FpsRange{7, 30}));
+    // Unset stays unset, and without a list the request stands.
+    EXPECT_EQ(resolveControls(CaptureControls(), phoneCamera()).fps, FpsRange());
+    controls.fps = {24, 24};
+    EXPECT_EQ(resolveControls(controls, CaptureCapabilities()).fps, (FpsRange{24, 24}));
+}
+
+TEST(CaptureControlsTest, ManualExposureIsClampedToTheSensorAndTheFrame) {
+    CaptureControls controls;
+    controls.fps = {30, 30};
+    controls.exposureTimeNs = 100000000;  // 100 ms does not fit a 30 fps frame
+    controls.sensitivity = 12800;
+    CaptureControls resolved = resolveControls(controls, phoneCamera());
+    EXPECT_EQ(resolved.exposureTimeNs, 1000000000 / 30);
+    EXPECT_EQ(resolved.sensitivity, 3200);
+
+    CaptureCapabilities noManual = phoneCamera();
+    noManual.manualSensor = false;
+    resolved = resolveControls(controls, noManual);
+    EXPECT_EQ(resolved.exposureTimeNs, 0);
+    EXPECT_EQ(resolved.sensitivity, 0);
+}
+
+TEST(CaptureControlsTest, CompensationAndFocusStayInRange) {
+    CaptureControls controls;
+    controls.exposureCompensation = -20;
+    controls.focus = FocusMode::Fixed;
+    controls.focusDistance = 25.0f;
+    CaptureControls resolved = resolveControls(controls, phoneCamera());
+    EXPECT_EQ(resolved.exposureCompensation, -12);
+    EXPECT_EQ(resolved.focus, FocusMode::Fixed);
+    EXPECT_FLOAT_EQ(resolved.focusDistance, 10.0f);
+
+}
+
+TEST(CaptureControlsTest, UnlistedFocusModesFallBackToOnesTheCameraHas) {
+    // A fixed-focus lens lists AF off and nothing else.
+    CaptureCapabilities fixedFocus = phoneCamera();
+    fixedFocus.minFocusDistance = 0.0f;
+    fixedFocus.focusModes = {FocusMode::Fixed};
+    CaptureControls controls;
+    for (FocusMode mode : {FocusMode::Continuous, FocusMode::Auto, FocusMode::Fixed}) {
+        controls.focus = mode;
+        controls.focusDistance = 2.0f;
+        const CaptureControls resolved = resolveControls(controls, fixedFocus);
+        EXPECT_EQ(resolved.focus, FocusMode::Fixed);
+        EXPECT_FLOAT_EQ(resolved.focusDistance, 0.0f);
+    }
+
+    // Without continuous video AF, single-sweep AF is the next best.
+    CaptureCapabilities sweepOnly = phoneCamera();
+    sweepOnly.focusModes = {FocusMode::Fixed, FocusMode::Auto};
+    controls.focus = FocusMode::Continuous;
+    EXPECT_EQ(resolveControls(controls, sweepOnly).focus, FocusMode::Auto);
+
+    // Modes the camera did not report are taken as given.
+    CaptureCapabilities unreported = phoneCamera();
+    unreported.focusModes.clear();
+    EXPECT_EQ(resolveControls(controls, unreported).focus, FocusMode::Continuous);
+}
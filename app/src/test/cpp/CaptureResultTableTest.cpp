@@ -0,0 +1,132 @@
+#include "CaptureResult.h"
+#include "FrameHandle.h"
+#include "FramePipeline.h"
+#include "HeadlessRenderer.h"
+#include "SyntheticFrameSource.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+CaptureResultInfo result(int64_t timestampNs, int64_t frameNumber, int64_t frameDurationNs = 33333333) {
+    CaptureResultInfo info;
+    info.timestampNs = timestampNs;
+    info.frameNumber = frameNumber;
+    info.frameDurationNs = frameDurationNs;
+    info.exposureTimeNs = frameDurationNs / 2;
+    info.sensitivity = 400;
+    return info;
+}
+
+}  // namespace
+
+TEST(CaptureResultTableTest, FindsResultsByTimestampUntilOverwritten) {
+    CaptureResultTable table;
+    for (int i = 1; i <= CaptureResultTable::kCapacity + 4; ++i) table.record(result(i * 1000, i));
+
+    CaptureResultInfo found;
+    ASSERT_TRUE(table.find((CaptureResultTable::kCapacity + 4) * 1000, found));
+    EXPECT_EQ(found.frameNumber, CaptureResultTable::kCapacity + 4);
+    EXPECT_EQ(found.sensitivity, 400);
+    ASSERT_TRUE(table.find(5 * 1000, found));
+    EXPECT_EQ(found.frameNumber, 5);
+    // The oldest four were overwritten.
+    EXPECT_FALSE(table.find(4 * 1000, found));
+    EXPECT_FALSE(table.find(12345, found));
+}
+
+TEST(CaptureResultTableTest, LaterRecordsFillInTheSameCapture) {
+    CaptureResultTable table;
+    CaptureResultInfo started;
+    started.timestampNs = 7000;
+    started.frameNumber = 3;
+    table.record(started);
+
+    CaptureResultInfo found;
+    ASSERT_TRUE(table.find(7000, found));
+    EXPECT_FALSE(found.complete());
+
+    // A full result without a frame number keeps the one already there.
+    CaptureResultInfo full = result(7000, -1);
+    table.record(full);
+    ASSERT_TRUE(table.find(7000, found));
+    EXPECT_TRUE(found.complete());
+    EXPECT_EQ(found.frameNumber, 3);
+    EXPECT_EQ(found.frameDurationNs, 33333333);
+}
+
+TEST(CaptureResultTableTest, FrameJoinsAResultThatArrivesLater) {
+    CaptureResultTable table;
+    FramePool pool(1);
+    int owner = 0;
+    FrameHandle frame = pool.acquire(&owner, [](void*) {});
+    ASSERT_TRUE(frame);
+    frame->timestampNs = 9000;
+    frame->captureResults = &table;
+    EXPECT_EQ(frame->captureResult().frameNumber, -1);
+
+    table.record(result(9000, 42));
+    EXPECT_EQ(frame->captureResult().frameNumber, 42);
+    EXPECT_TRUE(frame->captureResult().complete());
+}
+
+TEST(CaptureResultTableTest, ReadersNeverSeeTornResults) {
+    // The writer can lap all 32 slots before the reader finishes one
+    // lookup, so it keeps going until the reader has caught it a few times.
+    constexpr uint64_t kMinHits = 100;
+    CaptureResultTable table;
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+    std::atomic<int64_t> latest{0};
+    std::atomic<uint64_t> hits{0};
+    std::thread writer([&] {
+        // Every field is derived from the frame number, so a torn read shows.
+        for (int64_t n = 1; !torn && (n <= 200000 || hits.load(std::memory_order_relaxed) < kMinHits); ++n) {
+            table.record(result(n * 10, n, n * 100));
+            latest.store(n, std::memory_order_release);
+        }
+        done = true;
+    });
+    while (!done) {
+        const int64_t n = latest.load(std::memory_order_acquire);
+        CaptureResultInfo found;
+        if (n > 0 && table.find(n * 10, found)) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            if (found.frameNumber != n || found.frameDurationNs != n * 100 || found.exposureTimeNs != n * 50) {
+                ADD_FAILURE() << "torn result for frame " << n << ": frame " << found.frameNumber << ", duration "
+                              << found.frameDurationNs << ", exposure " << found.exposureTimeNs;
+                torn = true;
+            }
+        }
+    }
+    writer.join();
+    EXPECT_GE(hits.load(), kMinHits);
+}
+
+TEST(CaptureResultTableTest, PipelineCountsCapturesItNeverPresented) {
+    // Presenting takes 10 ms against a 2 ms frame period, so most captures
+    // are skipped and show up as frame number gaps.
+    HeadlessRenderer renderer(10000000);
+    FramePipeline pipeline(renderer);
+    SyntheticSourceOptions options;
+    options.fps = 500;
+    SyntheticFrameSource source(options);
+
+    pipeline.start();
+    ASSERT_TRUE(source.open(StreamConfig(), [&](FrameHandle frame) { pipeline.submit(std::move(frame)); }));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (source.delivered() < 100 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pipeline.stop();
+    source.close();
+
+    const PipelineStats& stats = pipeline.stats();
+    ASSERT_GT(stats.presented, 1u);
+    EXPECT_EQ(stats.frameDuration.count(), stats.presented);
+    EXPECT_EQ(stats.frameDuration.maxNs(), 2000000);
+    EXPECT_GT(stats.captureGaps, 0u);
+    EXPECT_LE(stats.presented + stats.captureGaps, source.delivered());
+}
@@ -0,0 +1,96 @@
+#include "EncoderThrottle.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int64_t kFrame60 = 16666667;
+constexpr int64_t kFrame30 = 33333333;
+
+}  // namespace
+
+TEST(EncoderThrottleTest, SkipsWhileTheCodecIsBehindAndResumes) {
+    EncoderThrottle throttle(2);
+    int64_t t = 1000000000;
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    // Two in the codec: drawing a third would block the render thread.
+    EXPECT_FALSE(throttle.admit(t += kFrame30));
+    EXPECT_FALSE(throttle.admit(t += kFrame30));
+    EXPECT_EQ(throttle.inFlight(), 2);
+    EXPECT_EQ(throttle.skippedBehind(), 2u);
+
+    throttle.onEncoded();
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    EXPECT_FALSE(throttle.admit(t += kFrame30));
+
+    // A frame that never reached the codec frees its slot.
+    throttle.onEncoded();
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    throttle.cancel();
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    EXPECT_EQ(throttle.submitted(), 4u);
+    EXPECT_EQ(throttle.encoded(), 2u);
+}
+
+TEST(EncoderThrottleTest, ResyncReopensAfterTheCodecDropsFrames) {
+    EncoderThrottle throttle(2);
+    int64_t t = 1000000000;
+    EXPECT_EQ(throttle.resync(), 0);
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+    // The codec swallowed both: nothing will ever bring inFlight down.
+    EXPECT_FALSE(throttle.admit(t += kFrame30));
+    EXPECT_EQ(throttle.resync(), 2);
+    EXPECT_EQ(throttle.inFlight(), 0);
+    EXPECT_EQ(throttle.lost(), 2u);
+    EXPECT_TRUE(throttle.admit(t += kFrame30));
+
+    // One of them was only late: its output stands in for the new frame's,
+    // and the new frame's own output comes off the lost count.
+    throttle.onEncoded();
+    EXPECT_EQ(throttle.inFlight(), 0);
+    throttle.onEncoded();
+    EXPECT_EQ(throttle.inFlight(), 0);
+    EXPECT_EQ(throttle.lost(), 1u);
+    EXPECT_EQ(throttle.encoded(), 3u);
+}
+
+TEST(EncoderThrottleTest, TimestampsOnlyMoveForward) {
+    EncoderThrottle throttle;
+    EXPECT_TRUE(throttle.admit(2000));
+    EXPECT_FALSE(throttle.admit(2000));
+    EXPECT_FALSE(throttle.admit(1000));
+    EXPECT_TRUE(throttle.admit(3000));
+    EXPECT_EQ(throttle.skippedStale(), 2u);
+}
+
+TEST(EncoderThrottleTest, RateCapHalvesJitteryInputWithoutDrift) {
+    EncoderThrottle throttle(1000, kFrame30);
+    int admitted = 0;
+    int64_t last = 0;
+    for (int i = 0; i < 600; ++i) {
+        // 60 fps, each frame up to 3 ms early or late.
+        const int64_t jitter = (i * 7919 % 7 - 3) * 1000000;
+        const int64_t t = 1000000000 + i * kFrame60 + jitter;
+        if (!throttle.admit(t)) continue;
+        if (admitted++) {
+            EXPECT_GT(t - last, kFrame30 * 3 / 4);
+            EXPECT_LT(t - last, kFrame30 * 3 / 2);
+        }
+        last = t;
+    }
+    EXPECT_EQ(admitted, 300);
+    EXPECT_EQ(throttle.skippedRate(), 300u);
+}
+
+TEST(EncoderThrottleTest, RateCapRestartsAfterAGap) {
+    EncoderThrottle throttle(1000, kFrame30);
+    EXPECT_TRUE(throttle.admit(1000000000));
+    EXPECT_TRUE(throttle.admit(1000000000 + kFrame30));
+    // The camera stalled for a second; the grid starts over rather than
+    // letting a burst through to catch up.
+    const int64_t resumed = 2000000000;
+    EXPECT_TRUE(throttle.admit(resumed));
+    EXPECT_FALSE(throttle.admit(resumed + kFrame60));
+    EXPECT_TRUE(throttle.admit(resumed + 2 * kFrame60));
+}
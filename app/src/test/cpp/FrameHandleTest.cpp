@@ -0,0 +1,157 @@
+#include "FrameHandle.h"
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Stands in for AImageReader: hands out fixed buffers and records which ones
+// have been given back.
+class FakeImageSource {
+public:
+    explicit FakeImageSource(int count) : images_(count) {
+        for (int i = 0; i < count; ++i) {
+            images_[i].index = i;
+            images_[i].source = this;
+            images_[i].pixels.assign(640 * 480, static_cast<uint8_t>(i));
+        }
+    }
+
+    struct Image {
+        int index = 0;
+        FakeImageSource* source = nullptr;
+        std::vector<uint8_t> pixels;
+        std::atomic<bool> acquired{false};
+    };
+
+    FrameHandle acquire(FramePool& pool, int index) {
+        Image& image = images_[index];
+        image.acquired = true;
+        FrameHandle frame = pool.acquire(&image, &FakeImageSource::release);
+        if (!frame) {
+            image.acquired = false;
+            return frame;
+        }
+        frame->width = 640;
+        frame->height = 480;
+        frame->planeCount = 1;
+        frame->planes[0].data = image.pixels.data();
+        frame->planes[0].length = static_cast<int>(image.pixels.size());
+        frame->planes[0].rowStride = 640;
+        frame->planes[0].pixelStride = 1;
+        return frame;
+    }
+
+    bool acquired(int index) const { return images_[index].acquired; }
+    int released() const { return released_; }
+
+private:
+    static void release(void* owner) {
+        auto* image = static_cast<Image*>(owner);
+        image->acquired = false;
+        image->source->released_++;
+    }
+
+    std::vector<Image> images_;
+    std::atomic<int> released_{0};
+};
+
+}  // namespace
+
+TEST(FrameHandleTest, ReleasesOwnerWithLastReference) {
+    FramePool pool(3);
+    FakeImageSource source(3);
+
+    FrameHandle frame = source.acquire(pool, 0);
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(pool.inFlight(), 1);
+
+    FrameHandle copy = frame;
+    frame.reset();
+    EXPECT_TRUE(source.acquired(0));
+    EXPECT_EQ(copy->planes[0].data[0], 0);
+
+    copy.reset();
+    EXPECT_FALSE(source.acquired(0));
+    EXPECT_EQ(source.released(), 1);
+    EXPECT_EQ(pool.inFlight(), 0);
+}
+
+TEST(FrameHandleTest, MoveDoesNotTouchRefCount) {
+    FramePool pool(2);
+    FakeImageSource source(1);
+
+    FrameHandle frame = source.acquire(pool, 0);
+    FrameHandle moved = std::move(frame);
+    EXPECT_FALSE(frame);
+    EXPECT_TRUE(source.acquired(0));
+    moved = FrameHandle();
+    EXPECT_EQ(source.released(), 1);
+}
+
+TEST(FrameHandleTest, ExhaustedPoolLeavesOwnershipWithCaller) {
+    FramePool pool(2);
+    FakeImageSource source(3);
+
+    FrameHandle a = source.acquire(pool, 0);
+    FrameHandle b = source.acquire(pool, 1);
+    FrameHandle c = source.acquire(pool, 2);
+    EXPECT_TRUE(a);
+    EXPECT_TRUE(b);
+    EXPECT_FALSE(c);
+    EXPECT_EQ(pool.inFlight(), 2);
+    EXPECT_EQ(pool.peakInFlight(), 2);
+    EXPECT_EQ(pool.exhausted(), 1u);
+
+    a.reset();
+    FrameHandle d = source.acquire(pool, 2);
+    EXPECT_TRUE(d);
+    EXPECT_EQ(d->planes[0].data[0], 2);
+}
+
+TEST(FrameHandleTest, ConsumerThreadReleasesAfterUpload) {
+    FramePool pool(3);
+    FakeImageSource source(3);
+    constexpr int kFrames = 500;
+
+    std::atomic<int> next{0};
+    FrameHandle slot;
+    std::mutex mutex;
+    long checksum = 0;
+
+    std::thread consumer([&] {
+        int seen = 0;
+        while (seen < kFrames) {
+            FrameHandle frame;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                frame = std::move(slot);
+            }
+            if (!frame) {
+                std::this_thread::yield();
+                continue;
+            }
+            checksum += frame->planes[0].data[frame->planes[0].length - 1];
+            ++seen;
+        }
+    });
+
+    int produced = 0;
+    while (produced < kFrames) {
+        FrameHandle frame = source.acquire(pool, next++ % 3);
+        if (!frame) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (slot) continue;
+        slot = std::move(frame);
+        ++produced;
+    }
+    consumer.join();
+
+    EXPECT_EQ(pool.inFlight(), 0);
+    EXPECT_LE(pool.peakInFlight(), 3);
+    EXPECT_GT(checksum, 0);
+}
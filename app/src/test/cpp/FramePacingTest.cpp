@@ -0,0 +1,145 @@
+#include "FramePipeline.h"
+#include "HeadlessRenderer.h"
+#include "PipelineStats.h"
+#include "SimulatedVsync.h"
+#include "SyntheticFrameSource.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST(FramePacingTest, StageStatsReportSpread) {
+    StageStats steady;
+    for (int i = 0; i < 10; ++i) steady.add(16000000);
+    EXPECT_DOUBLE_EQ(steady.stddevNs(), 0.0);
+
+    StageStats jittery;
+    for (int i = 0; i < 10; ++i) jittery.add(i % 2 ? 20000000 : 12000000);
+    EXPECT_DOUBLE_EQ(jittery.meanNs(), 16000000.0);
+    EXPECT_DOUBLE_EQ(jittery.stddevNs(), 4000000.0);
+    jittery.reset();
+    EXPECT_DOUBLE_EQ(jittery.stddevNs(), 0.0);
+}
+
+namespace {
+
+// A display that never delivers a vsync, like a thread with no choreographer.
+class FailingVsync : public VsyncSource {
+public:
+    void start() override {
+        open();
+        fail();
+    }
+    void stop() override { close(); }
+};
+
+}  // namespace
+
+TEST(FramePacingTest, SimulatedVsyncTicksOnItsGrid) {
+    const int64_t periodNs = 4000000;
+    SimulatedVsync vsync(periodNs);
+    vsync.start();
+    int64_t first = vsync.waitNext();
+    ASSERT_GT(first, 0);
+    int64_t last = first;
+    for (int i = 0; i < 5; ++i) {
+        int64_t next = vsync.waitNext();
+        EXPECT_GT(next, last);
+        EXPECT_EQ((next - first) % periodNs, 0);
+        last = next;
+    }
+    EXPECT_EQ(vsync.periodNs(), periodNs);
+
+    // A busy caller skips the ticks it slept through and gets the latest.
+    std::this_thread::sleep_for(std::chrono::nanoseconds(periodNs * 3));
+    int64_t caughtUp = vsync.waitNext();
+    EXPECT_GE(caughtUp - last, 2 * periodNs);
+    vsync.stop();
+}
+
+TEST(FramePacingTest, StopWakesAWaitingRenderThread) {
+    SimulatedVsync vsync(1000000000);  // never ticks within the test
+    vsync.start();
+    std::atomic<int64_t> result{0};
+    std::thread waiter([&] { result = vsync.waitNext(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    vsync.stop();
+    waiter.join();
+    EXPECT_EQ(result.load(), -1);
+}
+
+TEST(FramePacingTest, PacedPipelinePresentsOncePerVsyncAndDropsTheRest) {
+    // Frames every 2 ms against a 20 ms refresh: about nine in ten must be
+    // dropped, and presents follow the refresh rather than the camera.
+    const int64_t periodNs = 20000000;
+    HeadlessRenderer renderer;
+    SimulatedVsync vsync(periodNs);
+    FramePipeline pipeline(renderer);
+    pipeline.setVsync(&vsync);
+    SyntheticSourceOptions options;
+    options.fps = 500;
+    SyntheticFrameSource source(options);
+
+    pipeline.start();
+    ASSERT_TRUE(source.open(StreamConfig(), [&](FrameHandle frame) { pipeline.submit(std::move(frame)); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    pipeline.stop();
+    source.close();
+
+    const PipelineStats& stats = pipeline.stats();
+    ASSERT_GT(stats.presented, 5u);
+    EXPECT_LE(stats.presented, 400000000 / periodNs + 2);
+    EXPECT_GT(stats.dropped, stats.presented);
+    EXPECT_LE(stats.presented + stats.dropped, pipeline.ring().published());
+    // Presents land on whole refreshes, so the frame time is the period
+    // (or a multiple, when the host stalls the test).
+    EXPECT_GE(stats.frameInterval.percentileNs(50), periodNs * 9 / 10);
+    EXPECT_LE(stats.frameInterval.percentileNs(50), periodNs * 11 / 10);
+    EXPECT_EQ(stats.vsyncLatency.count(), stats.presented);
+    EXPECT_LT(stats.vsyncLatency.percentileNs(50), periodNs);
+}
+
+TEST(FramePacingTest, UnpacedPipelineFollowsTheSource) {
+    // Without a vsync every frame the renderer can keep up with is drawn.
+    HeadlessRenderer renderer;
+    FramePipeline pipeline(renderer);
+    SyntheticSourceOptions options;
+    options.fps = 100;
+    SyntheticFrameSource source(options);
+
+    pipeline.start();
+    ASSERT_TRUE(source.open(StreamConfig(), [&](FrameHandle frame) { pipeline.submit(std::move(frame)); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    source.close();
+    pipeline.stop();
+
+    const PipelineStats& stats = pipeline.stats();
+    ASSERT_GT(stats.presented, 10u);
+    EXPECT_EQ(stats.vsyncLatency.count(), 0u);
+    EXPECT_EQ(stats.lateFrames, 0u);
+    EXPECT_GE(stats.frameInterval.percentileNs(50), 5000000);
+    EXPECT_LE(stats.frameInterval.percentileNs(50), 15000000);
+}
+
+TEST(FramePacingTest, PipelineDrawsUnpacedWhenTheVsyncSourceFails) {
+    HeadlessRenderer renderer;
+    FailingVsync vsync;
+    FramePipeline pipeline(renderer);
+    pipeline.setVsync(&vsync);
+    SyntheticSourceOptions options;
+    options.fps = 100;
+    SyntheticFrameSource source(options);
+
+    pipeline.start();
+    EXPECT_EQ(vsync.waitNext(), 0);
+    ASSERT_TRUE(source.open(StreamConfig(), [&](FrameHandle frame) { pipeline.submit(std::move(frame)); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    source.close();
+    pipeline.stop();
+    EXPECT_EQ(vsync.waitNext(), -1);
+
+    const PipelineStats& stats = pipeline.stats();
+    ASSERT_GT(stats.presented, 10u);
+    EXPECT_EQ(stats.vsyncLatency.count(), 0u);
+    EXPECT_EQ(stats.lateFrames, 0u);
+}
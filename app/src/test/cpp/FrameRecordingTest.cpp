@@ -0,0 +1,190 @@
+#include "FrameRecorder.h"
+#include "FrameRecording.h"
+#include "ReplayFrameSource.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+constexpr int kRowStride = 80;  // padded rows, as ISPs deliver them
+
+// A frame laid out like most devices' YUV_420_888: padded luma rows and
+// interleaved chroma, U and V planes one byte apart in the same buffer.
+struct TestImage {
+    std::vector<uint8_t> pixels;
+    Frame frame;
+
+    TestImage(int index, int64_t timestampNs) : pixels(size_t(kRowStride) * kHeight * 3 / 2) {
+        for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = uint8_t(i * 7 + index * 13);
+        const int ySize = kRowStride * kHeight;
+        const int cSize = kRowStride * kHeight / 2;
+        frame.width = kWidth;
+        frame.height = kHeight;
+        frame.format = 0x23;
+        frame.rotation = 90;
+        frame.timestampNs = timestampNs;
+        frame.capture.timestampNs = timestampNs;
+        frame.capture.frameNumber = 100 + index;
+        frame.capture.frameDurationNs = 33333333;
+        frame.capture.exposureTimeNs = 10000000;
+        frame.capture.sensitivity = 200 + index;
+        frame.planeCount = 3;
+        frame.planes[0] = {pixels.data(), ySize, kRowStride, 1};
+        frame.planes[1] = {pixels.data() + ySize, cSize - 1, kRowStride, 2};
+        frame.planes[2] = {pixels.data() + ySize + 1, cSize - 1, kRowStride, 2};
+    }
+};
+
+std::string tempPath() {
+    char path[] = "/tmp/frame-recording-test-XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    return path;
+}
+
+// Records `count` frames `intervalNs` apart and returns the images.
+std::vector<std::unique_ptr<TestImage>> recordFrames(const std::string& path, int count, int64_t intervalNs) {
+    std::vector<std::unique_ptr<TestImage>> images;
+    FrameRecorder recorder;
+    EXPECT_TRUE(recorder.open(path.c_str()));
+    for (int i = 0; i < count; ++i) {
+        images.push_back(std::make_unique<TestImage>(i, 1000000000 + i * intervalNs));
+        // The queue drops rather than blocks; pace the test so none are lost.
+        while (!recorder.record(images.back()->frame)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    recorder.close();
+    EXPECT_EQ(recorder.recorded(), uint64_t(count));
+    return images;
+}
+
+void expectSamePixels(const Frame& replayed, const Frame& original) {
+    for (int p = 0; p < 3; ++p) {
+        const FramePlane& a = replayed.planes[p];
+        const FramePlane& b = original.planes[p];
+        ASSERT_EQ(a.rowStride, b.rowStride);
+        ASSERT_EQ(a.pixelStride, b.pixelStride);
+        ASSERT_EQ(a.length, b.length);
+        EXPECT_EQ(std::memcmp(a.data, b.data, size_t(a.length)), 0) << "plane " << p;
+    }
+    // Interleaved chroma still aliases.
+    EXPECT_EQ(replayed.planes[2].data - replayed.planes[1].data, 1);
+}
+
+}  // namespace
+
+TEST(FrameRecordingTest, RoundTripKeepsPixelsStridesAndResults) {
+    const std::string path = tempPath();
+    auto images = recordFrames(path, 5, 33333333);
+
+    std::unique_ptr<FrameRecording> recording = FrameRecording::open(path.c_str());
+    ASSERT_TRUE(recording);
+    EXPECT_TRUE(recording->indexed());
+    ASSERT_EQ(recording->size(), 5u);
+    for (size_t i = 0; i < recording->size(); ++i) {
+        Frame frame;
+        recording->describe(i, frame);
+        const Frame& original = images[i]->frame;
+        EXPECT_EQ(frame.width, kWidth);
+        EXPECT_EQ(frame.height, kHeight);
+        EXPECT_EQ(frame.rotation, 90);
+        EXPECT_EQ(frame.timestampNs, original.timestampNs);
+        EXPECT_EQ(frame.capture.frameNumber, original.capture.frameNumber);
+        EXPECT_EQ(frame.capture.sensitivity, original.capture.sensitivity);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.planes[0].data) % kRecordingAlignment, 0u);
+        expectSamePixels(frame, original);
+    }
+    unlink(path.c_str());
+}
+
+TEST(FrameRecordingTest, RecoversARecordingThatWasNeverClosed) {
+    const std::string path = tempPath();
+    auto images = recordFrames(path, 3, 33333333);
+
+    // Cut the index off and clear the header, as if the app died mid-recording.
+    RecordingHeader header;
+    int fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(pread(fd, &header, sizeof(header), 0), ssize_t(sizeof(header)));
+    ASSERT_EQ(ftruncate(fd, off_t(header.indexOffset)), 0);
+    header.frameCount = header.indexOffset = 0;
+    ASSERT_EQ(pwrite(fd, &header, sizeof(header), 0), ssize_t(sizeof(header)));
+    close(fd);
+
+    std::unique_ptr<FrameRecording> recording = FrameRecording::open(path.c_str());
+    ASSERT_TRUE(recording);
+    EXPECT_FALSE(recording->indexed());
+    ASSERT_EQ(recording->size(), 3u);
+    Frame frame;
+    recording->describe(2, frame);
+    expectSamePixels(frame, images[2]->frame);
+    unlink(path.c_str());
+}
+
+TEST(FrameRecordingTest, ReplayHandsOutTheMappingInOrder) {
+    const std::string path = tempPath();
+    auto images = recordFrames(path, 4, 10000000);
+
+    ReplayOptions options;
+    options.path = path;
+    options.realtime = false;
+    ReplayFrameSource source(options);
+    std::mutex mutex;
+    std::vector<int64_t> timestamps;
+    std::vector<const uint8_t*> luma;
+    StreamConfig config;
+    config.maxImages = 2;
+    ASSERT_TRUE(source.open(config, [&](FrameHandle frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (timestamps.size() < 8) {
+            timestamps.push_back(frame->timestampNs);
+            luma.push_back(frame->planes[0].data);
+            if (luma.size() <= 4) expectSamePixels(*frame, images[luma.size() - 1]->frame);
+        }
+    }));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (source.delivered() < 8 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    source.close();
+
+    ASSERT_EQ(timestamps.size(), 8u);
+    EXPECT_EQ(source.dropped(), 0u);
+    for (size_t i = 1; i < timestamps.size(); ++i) EXPECT_EQ(timestamps[i] - timestamps[i - 1], 10000000);
+    // The second pass gets the same bytes: nothing was copied out.
+    for (size_t i = 0; i < 4; ++i) EXPECT_EQ(luma[i], luma[i + 4]);
+    EXPECT_GE(source.lastCapture().frameNumber, 100);
+    EXPECT_LE(source.lastCapture().frameNumber, 103);
+    unlink(path.c_str());
+}
+
+TEST(FrameRecordingTest, RealtimeReplayKeepsTheRecordedPace) {
+    const std::string path = tempPath();
+    recordFrames(path, 6, 20000000);
+
+    ReplayOptions options;
+    options.path = path;
+    options.loop = false;
+    ReplayFrameSource source(options);
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(source.open(StreamConfig(), [](FrameHandle) {}));
+    auto deadline = start + std::chrono::seconds(5);
+    while (!source.finished() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    source.close();
+
+    EXPECT_EQ(source.delivered(), 6u);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(100));
+    unlink(path.c_str());
+}
@@ -0,0 +1,100 @@
+#include "FrameRing.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+TEST(FrameRingTest, DropOldestKeepsNewestItems) {
+    FrameRing<int, 4> ring(OverflowPolicy::DropOldest);
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(ring.publish(int(i)));
+
+    EXPECT_EQ(ring.size(), 4u);
+    EXPECT_EQ(ring.droppedOldest(), 6u);
+    int value = -1;
+    for (int expected = 6; expected < 10; ++expected) {
+        ASSERT_TRUE(ring.consume(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_FALSE(ring.consume(value));
+}
+
+TEST(FrameRingTest, DropNewestRejectsWhenFull) {
+    FrameRing<int, 2> ring(OverflowPolicy::DropNewest);
+    EXPECT_TRUE(ring.publish(1));
+    EXPECT_TRUE(ring.publish(2));
+    EXPECT_FALSE(ring.publish(3));
+    EXPECT_EQ(ring.droppedNewest(), 1u);
+
+    int value = 0;
+    ASSERT_TRUE(ring.consume(value));
+    EXPECT_EQ(value, 1);
+}
+
+TEST(FrameRingTest, ConsumeLatestDiscardsBacklog) {
+    FrameRing<std::shared_ptr<int>, 4> ring;
+    auto first = std::make_shared<int>(1);
+    ring.publish(std::shared_ptr<int>(first));
+    ring.publish(std::make_shared<int>(2));
+    ring.publish(std::make_shared<int>(3));
+
+    std::shared_ptr<int> latest;
+    ASSERT_TRUE(ring.consumeLatest(latest));
+    EXPECT_EQ(*latest, 3);
+    EXPECT_EQ(ring.skipped(), 2u);
+    EXPECT_EQ(first.use_count(), 1);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(FrameRingTest, BlockingProducerLosesNothing) {
+    FrameRing<int, 2> ring(OverflowPolicy::Block);
+    constexpr int kItems = 20000;
+
+    std::thread producer([&] {
+        for (int i = 0; i < kItems; ++i) ring.publish(int(i));
+    });
+
+    int expected = 0;
+    while (expected < kItems) {
+        int value = -1;
+        if (!ring.consume(value)) {
+            ring.wait(1000000);
+            continue;
+        }
+        ASSERT_EQ(value, expected);
+        ++expected;
+    }
+    producer.join();
+    EXPECT_EQ(ring.published(), uint64_t(kItems));
+}
+
+TEST(FrameRingTest, CloseWakesWaitingConsumer) {
+    FrameRing<int, 2> ring;
+    std::thread consumer([&] { EXPECT_FALSE(ring.wait()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ring.close();
+    consumer.join();
+    EXPECT_FALSE(ring.publish(1));
+}
+
+TEST(FrameRingTest, ConcurrentEvictionNeverDuplicatesItems) {
+    FrameRing<int, 4> ring(OverflowPolicy::DropOldest);
+    constexpr int kItems = 200000;
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        for (int i = 0; i < kItems; ++i) ring.publish(int(i));
+        done = true;
+    });
+
+    int last = -1;
+    uint64_t consumed = 0;
+    while (!done || !ring.empty()) {
+        int value;
+        if (ring.consume(value)) {
+            ASSERT_GT(value, last);
+            last = value;
+            ++consumed;
+        }
+    }
+    producer.join();
+    EXPECT_EQ(consumed + ring.droppedOldest() + ring.droppedNewest(), uint64_t(kItems));
+}
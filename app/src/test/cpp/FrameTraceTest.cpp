@@ -0,0 +1,124 @@
+#include "FrameTrace.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int32_t currentTid() { return int32_t(syscall(SYS_gettid)); }
+
+class FrameTraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        FrameTrace::clear();
+        FrameTrace::setEnabled(true);
+    }
+    void TearDown() override {
+        FrameTrace::setEnabled(false);
+        FrameTrace::clear();
+    }
+};
+
+}  // namespace
+
+TEST_F(FrameTraceTest, ConcurrentWritersKeepTheirOwnEvents) {
+    constexpr int kThreads = 4;
+    constexpr int kFrames = 1000;
+    int32_t tids[kThreads] = {};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([t, &tids] {
+            tids[t] = currentTid();
+            for (int i = 0; i < kFrames; ++i) {
+                const int64_t frameId = int64_t(t) * kFrames + i;
+                FrameTrace::record(TraceStage::Acquire, frameId, frameId * 10);
+                FrameTrace::record(TraceStage::Swap, frameId, frameId * 10 + 5);
+            }
+        });
+    }
+    for (std::thread& writer : writers) writer.join();
+
+    const std::vector<FrameTrace::Event> events = FrameTrace::snapshot();
+    ASSERT_EQ(events.size(), size_t(kThreads * kFrames * 2));
+    for (const FrameTrace::Event& e : events) {
+        EXPECT_EQ(e.tid, tids[e.frameId / kFrames]);
+        EXPECT_EQ(e.timeNs, e.frameId * 10 + (e.stage == TraceStage::Swap ? 5 : 0));
+    }
+
+    FrameTrace::Summary summary;
+    FrameTrace::summarize(summary);
+    EXPECT_EQ(summary.frames, uint64_t(kThreads * kFrames));
+    EXPECT_EQ(summary.total.count(), uint64_t(kThreads * kFrames));
+    EXPECT_EQ(summary.total.percentileNs(50), 5);
+}
+
+TEST_F(FrameTraceTest, WrappedBufferKeepsTheNewestEvents) {
+    const int64_t recorded = int64_t(FrameTrace::kEventsPerThread) * 2 + 100;
+    for (int64_t i = 0; i < recorded; ++i) FrameTrace::record(TraceStage::Draw, i, i);
+
+    const std::vector<FrameTrace::Event> events = FrameTrace::snapshot();
+    ASSERT_EQ(events.size(), size_t(FrameTrace::kEventsPerThread));
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(events[i].frameId, recorded - int64_t(events.size()) + int64_t(i));
+    }
+}
+
+TEST_F(FrameTraceTest, ReclaimedBufferKeepsTheEarlierThreadsEvents) {
+    // The second thread takes over the buffer the first one let go of.
+    int32_t firstTid = 0, secondTid = 0;
+    std::thread first([&] {
+        firstTid = currentTid();
+        for (int64_t i = 0; i < 10; ++i) FrameTrace::record(TraceStage::Upload, i, i);
+    });
+    first.join();
+    std::thread second([&] {
+        secondTid = currentTid();
+        for (int64_t i = 10; i < 20; ++i) FrameTrace::record(TraceStage::Upload, i, i);
+    });
+    second.join();
+
+    const std::vector<FrameTrace::Event> events = FrameTrace::snapshot();
+    ASSERT_EQ(events.size(), 20u);
+    for (const FrameTrace::Event& e : events) EXPECT_EQ(e.tid, e.frameId < 10 ? firstTid : secondTid);
+}
+
+TEST_F(FrameTraceTest, ChromeTraceHasThreadNamesSlicesAndInstants) {
+    int32_t tid = 0;
+    std::thread renderer([&] {
+        prctl(PR_SET_NAME, "trace-renderer");
+        tid = currentTid();
+        FrameTrace::record(TraceStage::Acquire, 7, 1000000);
+        FrameTrace::record(TraceStage::Upload, 7, 1250000);
+        FrameTrace::record(TraceStage::Swap, 7, 3000000);
+    });
+    renderer.join();
+
+    char path[] = "/tmp/frame-trace-test-XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    ASSERT_TRUE(FrameTrace::writeChromeTrace(path));
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    unlink(path);
+    const std::string json = text.str();
+
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", 0), 0u);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+    const std::string t = std::to_string(tid);
+    EXPECT_NE(json.find("\"tid\":" + t + ",\"args\":{\"name\":\"trace-renderer\"}"), std::string::npos);
+    // The first stage is an instant; the rest are slices from the stage before.
+    EXPECT_NE(json.find("{\"name\":\"acquire\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"t\",\"pid\":" +
+                        std::to_string(getpid()) + ",\"tid\":" + t + ",\"ts\":1000.000,\"args\":{\"frame\":7}}"),
+              std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"upload\",\"cat\":\"frame\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":1000.000,\"dur\":250.000,\"args\":{\"frame\":7}"), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":1250.000,\"dur\":1750.000,\"args\":{\"frame\":7}"), std::string::npos);
+}
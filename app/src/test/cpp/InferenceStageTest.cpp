@@ -0,0 +1,216 @@
+#include "InferenceStage.h"
+#include "MonotonicClock.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Model whose invoke() blocks until the test lets it finish, so the test
+// decides exactly which frames arrive while it is busy.
+// Its outputs count up from the input's first pixel.
+class GatedModel : public InferenceModel {
+public:
+    explicit GatedModel(int outputs = 1) : input_(64), outputs_(outputs) {
+        shape_.width = shape_.height = 8;
+        shape_.channels = 1;
+        shape_.type = TensorType::UInt8;
+    }
+
+    const TensorShape& inputShape() const override { return shape_; }
+    void* inputData() override { return input_.data(); }
+
+    bool invoke() override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++entered_;
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return permits_ > 0; });
+        --permits_;
+        return true;
+    }
+
+    int outputValues() const override { return outputs_; }
+    int readOutputs(float* dst, int capacity) const override {
+        const int n = std::min(capacity, outputs_);
+        for (int i = 0; i < n; ++i) dst[i] = float(input_[0] + i);
+        return n;
+    }
+
+    void waitEntered(int count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return entered_ >= count; });
+    }
+
+    void finishOne() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++permits_;
+        cv_.notify_all();
+    }
+
+private:
+    TensorShape shape_;
+    std::vector<uint8_t> input_;
+    int outputs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int entered_ = 0;
+    int permits_ = 0;
+};
+
+void releaseNothing(void*) {}
+
+// A uniform grey frame whose pixel value and timestamp identify it.
+FrameHandle makeFrame(FramePool& pool, std::vector<uint8_t>& pixels, int64_t timestampNs) {
+    FrameHandle frame = pool.acquire(&pixels, &releaseNothing);
+    frame->width = frame->height = 16;
+    frame->timestampNs = timestampNs;
+    frame->acquiredNs = monotonicNowNs();
+    frame->planeCount = 1;
+    frame->planes[0] = {pixels.data(), int(pixels.size()), 16, 1};
+    return frame;
+}
+
+template <typename Pred>
+bool waitFor(Pred pred) {
+    for (int i = 0; i < 2000 && !pred(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return pred();
+}
+
+}  // namespace
+
+TEST(InferenceStageTest, RunsNewestFrameAndSkipsTheRest) {
+    GatedModel model;
+    InferenceStage stage(model);
+    FramePool pool(8);
+    std::vector<std::vector<uint8_t>> pixels;
+    for (int i = 0; i < 6; ++i) pixels.emplace_back(256, uint8_t(10 * (i + 1)));
+
+    stage.start();
+    stage.submit(makeFrame(pool, pixels[0], 1));
+    model.waitEntered(1);
+    // The busy model has already given its frame back.
+    EXPECT_EQ(pool.inFlight(), 0);
+
+    for (int i = 1; i < 6; ++i) stage.submit(makeFrame(pool, pixels[i], i + 1));
+    // Only the ring's two newest frames are still held.
+    EXPECT_EQ(pool.inFlight(), 2);
+
+    model.finishOne();
+    model.waitEntered(2);
+    model.finishOne();
+    ASSERT_TRUE(waitFor([&] { return stage.completed() == 2; }));
+    stage.stop();
+
+    InferenceResults& results = stage.results();
+    ASSERT_TRUE(results.update());
+    EXPECT_EQ(results.read().sequence, 2u);
+    EXPECT_EQ(results.read().frameTimestampNs, 6);
+    EXPECT_EQ(results.read().values[0], 60.0f);
+    // The square model saw all of the square frame.
+    EXPECT_EQ(results.read().frameWidth, 16);
+    EXPECT_EQ(results.read().crop.width, 16);
+    EXPECT_EQ(results.read().crop.height, 16);
+
+    EXPECT_EQ(stage.submitted(), 6u);
+    EXPECT_EQ(stage.skipped(), 4u);
+    EXPECT_EQ(pool.inFlight(), 0);
+}
+
+TEST(InferenceStageTest, LatencyRunsFromAcquireToResult) {
+    GatedModel model;
+    InferenceStage stage(model);
+    FramePool pool(2);
+    std::vector<uint8_t> pixels(256, 1);
+
+    stage.start();
+    FrameHandle frame = makeFrame(pool, pixels, 1);
+    frame->acquiredNs = monotonicNowNs() - 20000000;
+    stage.submit(std::move(frame));
+    model.finishOne();
+    ASSERT_TRUE(waitFor([&] { return stage.completed() == 1; }));
+    stage.stop();
+
+    const StageStats& latency = stage.latencyStats();
+    ASSERT_EQ(latency.count(), 1u);
+    EXPECT_GE(latency.maxNs(), 20000000);
+    EXPECT_EQ(stage.skipped(), 0u);
+}
+
+TEST(InferenceStageTest, ResultsHoldEveryOutputValue) {
+    // A 257x257 segmentation output of 21 classes arrives whole.
+    constexpr int kOutputs = 257 * 257 * 21;
+    GatedModel model(kOutputs);
+    InferenceStage stage(model);
+    FramePool pool(2);
+    std::vector<uint8_t> pixels(256, 3);
+
+    stage.start();
+    stage.submit(makeFrame(pool, pixels, 1));
+    model.finishOne();
+    ASSERT_TRUE(waitFor([&] { return stage.completed() == 1; }));
+    stage.stop();
+
+    InferenceResults& results = stage.results();
+    ASSERT_TRUE(results.update());
+    ASSERT_EQ(results.read().count, kOutputs);
+    ASSERT_EQ(results.read().values.size(), size_t(kOutputs));
+    EXPECT_EQ(results.read().values[0], 3.0f);
+    EXPECT_EQ(results.read().values[kOutputs - 1], float(3 + kOutputs - 1));
+}
+
+TEST(InferenceStageTest, ReleasesResultsInFrameOrder) {
+    GatedModel first, second;
+    InferenceStage stage({&first, &second}, DispatchPolicy::RoundRobin);
+    FramePool pool(4);
+    std::vector<uint8_t> older(256, 1), newer(256, 2);
+
+    stage.start();
+    stage.submit(makeFrame(pool, older, 1));
+    stage.submit(makeFrame(pool, newer, 2));
+    first.waitEntered(1);
+    second.waitEntered(1);
+
+    // The newer frame finishes first but must wait for the older one.
+    second.finishOne();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(stage.completed(), 0u);
+
+    first.finishOne();
+    ASSERT_TRUE(waitFor([&] { return stage.completed() == 2; }));
+    stage.stop();
+
+    InferenceResults& results = stage.results();
+    ASSERT_TRUE(results.update());
+    EXPECT_EQ(results.read().sequence, 2u);
+    EXPECT_EQ(results.read().frameTimestampNs, 2);
+    EXPECT_EQ(results.read().worker, 1);
+    EXPECT_EQ(stage.discarded(), 0u);
+}
+
+TEST(InferenceStageTest, LeastLoadedPrefersIdleWorker) {
+    GatedModel first, second;
+    InferenceStage stage({&first, &second}, DispatchPolicy::LeastLoaded);
+    FramePool pool(4);
+    std::vector<uint8_t> pixels(256, 1);
+
+    stage.start();
+    stage.submit(makeFrame(pool, pixels, 1));
+    first.waitEntered(1);
+    stage.submit(makeFrame(pool, pixels, 2));
+    second.waitEntered(1);
+    second.finishOne();
+    ASSERT_TRUE(waitFor([&] { return stage.completedBy(1) == 1; }));
+
+    // Round-robin would hand this one to the busy first worker.
+    stage.submit(makeFrame(pool, pixels, 3));
+    second.waitEntered(2);
+    second.finishOne();
+    first.finishOne();
+    ASSERT_TRUE(waitFor([&] { return stage.completedBy(0) == 1 && stage.completedBy(1) == 2; }));
+    stage.stop();
+    EXPECT_EQ(stage.skipped(), 0u);
+}
@@ -0,0 +1,119 @@
+#define LOG_TAG "LogTest"
+
+#include "Log.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Captured {
+    int priority;
+    std::string tag;
+    std::string text;
+};
+
+std::mutex gMutex;
+std::vector<Captured> gCaptured;
+
+void capture(int priority, const char* tag, const char* text) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gCaptured.push_back({priority, tag, text});
+}
+
+class LogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Log::flush();
+        Log::setSink(&capture);
+        std::lock_guard<std::mutex> lock(gMutex);
+        gCaptured.clear();
+    }
+    void TearDown() override {
+        Log::flush();
+        Log::setSink(nullptr);
+    }
+
+    std::vector<Captured> captured() {
+        Log::flush();
+        std::lock_guard<std::mutex> lock(gMutex);
+        return gCaptured;
+    }
+};
+
+void logHot(int i) { LOGI("hot %d", i); }
+
+int gEvaluated = 0;
+int sideEffect() { return ++gEvaluated; }
+
+}  // namespace
+
+TEST_F(LogTest, FormatsOnTheWriterThreadFromCopiedArguments) {
+    {
+        std::string name = "preview";
+        LOGI("%s stream %dx%d at %.1f fps, %llu frames, %zu bytes", name.c_str(), 640, 480, 29.97,
+             (unsigned long long)1234567890123ull, size_t(460800));
+        name.assign("overwritten before the writer runs");
+    }
+    LOGE("no arguments, 100%% literal");
+
+    std::vector<Captured> lines = captured();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0].priority, LOG_LEVEL_INFO);
+    EXPECT_EQ(lines[0].tag, "LogTest");
+    EXPECT_EQ(lines[0].text, "preview stream 640x480 at 30.0 fps, 1234567890123 frames, 460800 bytes");
+    EXPECT_EQ(lines[1].priority, LOG_LEVEL_ERROR);
+    EXPECT_EQ(lines[1].text, "no arguments, 100% literal");
+}
+
+TEST_F(LogTest, LongStringsAreTruncatedToFit) {
+    const std::string longPath(1000, 'x');
+    const char* missing = nullptr;
+    LOGI("%s|%s|%d", longPath.c_str(), missing, 7);
+
+    std::vector<Captured> lines = captured();
+    ASSERT_EQ(lines.size(), 1u);
+    const std::string& text = lines[0].text;
+    EXPECT_LT(text.size(), LogRecord::kPayloadBytes);
+    EXPECT_EQ(text.substr(text.size() - 9), "|(null)|7");
+    EXPECT_EQ(text.find_first_not_of('x'), text.size() - 9);
+}
+
+TEST_F(LogTest, EachCallSiteIsRateLimited) {
+    for (int i = 0; i < 100; ++i) {
+        logHot(i);
+        if (i % 10 == 0) LOGI("cold %d", i);  // its own site, its own budget
+    }
+    std::vector<Captured> lines = captured();
+    int hot = 0, cold = 0;
+    for (const Captured& line : lines) (line.text.compare(0, 3, "hot") == 0 ? hot : cold)++;
+    EXPECT_EQ(hot, int(kLogBurst));
+    EXPECT_EQ(cold, 10);
+
+    // The next window lets the site through again and owns up to the rest.
+    std::this_thread::sleep_for(std::chrono::nanoseconds(kLogWindowNs + 50000000));
+    for (int i = 0; i < 3; ++i) logHot(i);
+    lines = captured();
+    ASSERT_GE(lines.size(), 3u);
+    EXPECT_EQ(lines[lines.size() - 3].text, "hot 0 (" + std::to_string(100 - kLogBurst) + " similar suppressed)");
+    EXPECT_EQ(lines.back().text, "hot 2");
+}
+
+TEST_F(LogTest, LevelsBelowTheMinimumCompileAway) {
+    gEvaluated = 0;
+    LOGV("verbose %d", sideEffect());
+    LOGD("debug %d", sideEffect());
+    std::vector<Captured> lines = captured();
+#if LOG_MIN_LEVEL > LOG_LEVEL_DEBUG
+    EXPECT_EQ(gEvaluated, 0);
+    EXPECT_TRUE(lines.empty());
+#else
+    // Debug builds keep LOGD; LOGV's arguments are still never evaluated.
+    EXPECT_EQ(gEvaluated, 1);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0].text, "debug 1");
+#endif
+}
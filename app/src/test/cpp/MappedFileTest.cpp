@@ -0,0 +1,52 @@
+#include "MappedFile.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Writes `size` bytes where byte i is (i * 31) & 0xff to a fresh temp file.
+std::string writeTempFile(size_t size) {
+    char path[] = "/tmp/mapped-file-test-XXXXXX";
+    int fd = mkstemp(path);
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; ++i) bytes[i] = uint8_t(i * 31);
+    EXPECT_EQ(write(fd, bytes.data(), size), ssize_t(size));
+    close(fd);
+    return path;
+}
+
+}  // namespace
+
+TEST(MappedFileTest, MapsWholeFile) {
+    std::string path = writeTempFile(10000);
+    std::unique_ptr<MappedFile> file = MappedFile::open(path.c_str());
+    ASSERT_TRUE(file);
+    ASSERT_EQ(file->size(), 10000u);
+    for (size_t i = 0; i < file->size(); i += 997) EXPECT_EQ(uint8_t(file->data()[i]), uint8_t(i * 31));
+    unlink(path.c_str());
+}
+
+TEST(MappedFileTest, MapsUnalignedRange) {
+    // Like an asset inside an APK: the data starts mid-page.
+    std::string path = writeTempFile(3 * 4096);
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    std::unique_ptr<MappedFile> file = MappedFile::map(fd, 4096 + 123, 5000);
+    close(fd);  // the mapping outlives the descriptor
+    ASSERT_TRUE(file);
+    ASSERT_EQ(file->size(), 5000u);
+    for (size_t i = 0; i < file->size(); ++i) {
+        ASSERT_EQ(uint8_t(file->data()[i]), uint8_t((4096 + 123 + i) * 31)) << i;
+    }
+    unlink(path.c_str());
+}
+
+TEST(MappedFileTest, MissingFileFails) {
+    EXPECT_FALSE(MappedFile::open("/nonexistent/model.tflite"));
+    EXPECT_FALSE(MappedFile::map(-1, 0, 16));
+}
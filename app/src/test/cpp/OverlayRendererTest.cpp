@@ -0,0 +1,163 @@
+#include "HeadlessGlContext.h"
+#include "OverlayRenderer.h"
+#include "YuvConverter.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+constexpr uint32_t kRed = 0xFFFF0000;
+constexpr uint32_t kGreen = 0xFF00FF00;
+
+class OverlayRendererTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!gl_.create(kWidth, kHeight)) GTEST_SKIP() << gl_.error();
+        ASSERT_TRUE(overlay_.init(shaders_));
+    }
+
+    void TearDown() override {
+        overlay_.release();
+        shaders_.release();
+        gl_.destroy();
+    }
+
+    // Draws over black with a frame the viewport's size and shape, so frame
+    // coordinates map straight onto it unless a transform says otherwise.
+    void render(const PreviewTransform& transform = PreviewTransform()) {
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+        overlay_.draw(transform, kWidth, kHeight);
+        read();
+    }
+
+    void read() {
+        rgba_.resize(size_t(kWidth) * kHeight * 4);
+        glReadPixels(0, 0, kWidth, kHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba_.data());
+        ASSERT_EQ(glGetError(), GLenum(GL_NO_ERROR));
+    }
+
+    // Readback row 0 is the bottom of the viewport.
+    const uint8_t* pixel(int col, int rowFromTop) const {
+        return &rgba_[(size_t(kHeight - 1 - rowFromTop) * kWidth + col) * 4];
+    }
+
+    HeadlessGlContext gl_;
+    ShaderCache shaders_;
+    OverlayRenderer overlay_;
+    std::vector<uint8_t> rgba_;
+};
+
+}  // namespace
+
+TEST_F(OverlayRendererTest, BoxesAreOutlinedAndPointsAreRound) {
+    Overlay overlay;
+    overlay.boxes.push_back({0.25f, 0.25f, 0.75f, 0.75f, kRed});  // x 16-48, y 12-36
+    overlay.points.push_back({0.5f, 0.5f, kGreen});
+    overlay_.setStyle(2, 4);
+    overlay_.update(overlay);
+    EXPECT_EQ(overlay_.instances(), 2);
+    render();
+
+    EXPECT_EQ(pixel(17, 24)[0], 255);  // left edge
+    EXPECT_EQ(pixel(32, 13)[0], 255);  // top edge
+    EXPECT_EQ(pixel(46, 24)[0], 255);  // right edge
+    EXPECT_EQ(pixel(20, 24)[0], 0);    // inside the outline
+    EXPECT_EQ(pixel(8, 24)[0], 0);     // outside the box
+    EXPECT_EQ(pixel(32, 24)[1], 255);  // the point
+    EXPECT_EQ(pixel(35, 27)[1], 0);    // the point's square corner is cut away
+}
+
+TEST_F(OverlayRendererTest, MaskIsBlendedIntoTheFrameUnderTheShapes) {
+    // A black frame filling the viewport; the converter blends the mask.
+    std::vector<uint8_t> luma(size_t(kWidth) * kHeight, 0);
+    Frame frame;
+    frame.width = kWidth;
+    frame.height = kHeight;
+    frame.planeCount = 1;
+    frame.planes[0] = {luma.data(), int(luma.size()), kWidth, 1};
+    YuvConverter yuv;
+    ASSERT_TRUE(yuv.init(shaders_));
+    yuv.setViewport(kWidth, kHeight);
+    yuv.upload(frame);
+
+    Overlay overlay;
+    overlay.maskWidth = 4;
+    overlay.maskHeight = 1;
+    overlay.mask = {255, 255, 0, 0};
+    overlay.maskColor = 0x80FFFFFF;  // half-transparent white
+    overlay.boxes.push_back({0.0f, 0.0f, 1.0f, 1.0f, kRed});
+    overlay_.setStyle(2, 4);
+    overlay_.update(overlay);
+    EXPECT_EQ(overlay_.instances(), 1);  // the mask is not an instance
+    ASSERT_NE(overlay_.maskTexture(), 0u);
+    auto compose = [&] {
+        yuv.setMask(overlay_.maskTexture(), overlay_.maskColor());
+        yuv.draw();
+        overlay_.draw(yuv.transform(), kWidth, kHeight);
+        read();
+    };
+    compose();
+
+    EXPECT_NEAR(pixel(8, 24)[1], 128, 2);  // covered half
+    EXPECT_EQ(pixel(56, 24)[1], 0);        // clear half
+    const uint8_t* edge = pixel(0, 24);    // the outline is drawn over the mask
+    EXPECT_EQ(edge[0], 255);
+    EXPECT_EQ(edge[1], 0);
+
+    // A mask of the same size is updated in place.
+    overlay.mask = {0, 0, 255, 255};
+    overlay_.update(overlay);
+    compose();
+    EXPECT_EQ(pixel(8, 24)[1], 0);
+    EXPECT_NEAR(pixel(56, 24)[1], 128, 2);
+    EXPECT_EQ(overlay_.maskAllocations(), 1u);
+
+    // Without a mask the frame is drawn untouched.
+    overlay_.clear();
+    EXPECT_EQ(overlay_.maskTexture(), 0u);
+    compose();
+    EXPECT_EQ(pixel(56, 24)[1], 0);
+    yuv.release();
+}
+
+TEST_F(OverlayRendererTest, FollowsTheFrameRotation) {
+    // A filled box over the frame's top-left quadrant, on a sensor mounted a
+    // quarter turn clockwise: upright, it is the top-right quadrant.
+    Overlay overlay;
+    overlay.boxes.push_back({0.0f, 0.0f, 0.5f, 0.5f, kRed});
+    overlay_.setStyle(1000, 4);
+    overlay_.update(overlay);
+    render(previewTransform(kWidth, kHeight, 90, kWidth, kHeight));
+
+    // Upright the frame is 48x64; fit to 64x48 it is 36x48, centred at x 14-50.
+    EXPECT_EQ(pixel(41, 12)[0], 255);
+    EXPECT_EQ(pixel(23, 12)[0], 0);
+    EXPECT_EQ(pixel(41, 36)[0], 0);
+    EXPECT_EQ(pixel(4, 12)[0], 0);
+}
+
+TEST_F(OverlayRendererTest, InstanceBufferIsReusedOnceBigEnough) {
+    Overlay overlay;
+    for (int i = 0; i < 200; ++i) overlay.points.push_back({(i % 20) / 20.0f, (i / 20) / 10.0f, kGreen});
+    overlay_.update(overlay);
+    const uint64_t growths = overlay_.bufferGrowths();
+    EXPECT_GE(growths, 1u);
+    EXPECT_EQ(overlay_.instances(), 200);
+
+    for (int frame = 0; frame < 10; ++frame) {
+        overlay.points.resize(size_t(50 + frame * 15));
+        overlay_.update(overlay);
+        render();
+    }
+    EXPECT_EQ(overlay_.bufferGrowths(), growths);
+    EXPECT_EQ(overlay_.instances(), 185);
+
+    overlay.clear();
+    overlay_.update(overlay);
+    EXPECT_EQ(overlay_.instances(), 0);
+    render();
+    EXPECT_EQ(pixel(0, 0)[1], 0);
+}
@@ -0,0 +1,193 @@
+#include "InferenceStage.h"
+#include "Overlay.h"
+#include "Preprocess.h"
+#include <gtest/gtest.h>
+#include <set>
+
+namespace {
+
+struct Detection {
+    float ymin, xmin, ymax, xmax;
+    int classIndex;
+    float score;
+};
+
+// Lays detections out as the TFLite postprocess op's four output tensors,
+// flattened, with room for `capacity` of them.
+InferenceResult ssdOutput(const std::vector<Detection>& detections, int capacity) {
+    InferenceResult result;
+    result.frameTimestampNs = 123456789;
+    result.count = 6 * capacity + 1;
+    result.values.assign(size_t(result.count), 0.0f);
+    float* boxes = result.values.data();
+    float* classes = boxes + 4 * capacity;
+    float* scores = classes + capacity;
+    for (size_t i = 0; i < detections.size(); ++i) {
+        const Detection& d = detections[i];
+        boxes[4 * i + 0] = d.ymin;
+        boxes[4 * i + 1] = d.xmin;
+        boxes[4 * i + 2] = d.ymax;
+        boxes[4 * i + 3] = d.xmax;
+        classes[i] = float(d.classIndex);
+        scores[i] = d.score;
+    }
+    scores[capacity] = float(detections.size());
+    return result;
+}
+
+}  // namespace
+
+TEST(OverlayTest, DecodesConfidentDetectionsIntoBoxes) {
+    InferenceResult result = ssdOutput({{0.1f, 0.2f, 0.5f, 0.6f, 3, 0.9f},
+                                        {0.0f, 0.0f, 1.0f, 1.0f, 1, 0.3f},
+                                        {-0.2f, 0.5f, 0.4f, 1.3f, 0, 0.7f}},
+                                       10);
+    Overlay overlay;
+    overlay.points.push_back({0.5f, 0.5f, 0});  // left over from the last result
+    ASSERT_TRUE(decodeSsdDetections(result, 0.5f, overlay));
+    EXPECT_EQ(overlay.frameTimestampNs, 123456789);
+    EXPECT_TRUE(overlay.points.empty());
+    ASSERT_EQ(overlay.boxes.size(), 2u);
+    const OverlayBox& first = overlay.boxes[0];
+    EXPECT_FLOAT_EQ(first.left, 0.2f);
+    EXPECT_FLOAT_EQ(first.top, 0.1f);
+    EXPECT_FLOAT_EQ(first.right, 0.6f);
+    EXPECT_FLOAT_EQ(first.bottom, 0.5f);
+    EXPECT_EQ(first.color, overlayClassColor(3));
+    // Boxes hanging off the frame are clipped to it.
+    const OverlayBox& clipped = overlay.boxes[1];
+    EXPECT_FLOAT_EQ(clipped.top, 0.0f);
+    EXPECT_FLOAT_EQ(clipped.right, 1.0f);
+}
+
+TEST(OverlayTest, BoxesAreMappedFromTheModelCropOntoTheFrame) {
+    // A square model sees the middle 480x480 of a 640x480 frame.
+    TensorShape square;
+    square.width = 300;
+    square.height = 300;
+    InferenceResult result = ssdOutput({{0.0f, 0.0f, 1.0f, 1.0f, 0, 0.9f}, {0.25f, 0.5f, 0.75f, 1.0f, 0, 0.9f}}, 4);
+    result.crop = centerCrop(640, 480, square);
+    result.frameWidth = 640;
+    result.frameHeight = 480;
+    Overlay overlay;
+    ASSERT_TRUE(decodeSsdDetections(result, 0.5f, overlay));
+    ASSERT_EQ(overlay.boxes.size(), 2u);
+    const OverlayBox& whole = overlay.boxes[0];
+    EXPECT_FLOAT_EQ(whole.left, 0.125f);
+    EXPECT_FLOAT_EQ(whole.right, 0.875f);
+    EXPECT_FLOAT_EQ(whole.top, 0.0f);
+    EXPECT_FLOAT_EQ(whole.bottom, 1.0f);
+    const OverlayBox& right = overlay.boxes[1];
+    EXPECT_FLOAT_EQ(right.left, 0.5f);
+    EXPECT_FLOAT_EQ(right.right, 0.875f);
+    EXPECT_FLOAT_EQ(right.top, 0.25f);
+    EXPECT_FLOAT_EQ(right.bottom, 0.75f);
+}
+
+TEST(OverlayTest, OnlyTheReportedCountIsRead) {
+    InferenceResult result = ssdOutput({{0.1f, 0.1f, 0.2f, 0.2f, 0, 0.9f}, {0.3f, 0.3f, 0.4f, 0.4f, 0, 0.9f}}, 4);
+    result.values[6 * 4] = 1;  // the model only vouches for the first
+    Overlay overlay;
+    ASSERT_TRUE(decodeSsdDetections(result, 0.5f, overlay));
+    EXPECT_EQ(overlay.boxes.size(), 1u);
+
+    result.values[6 * 4] = 1000;  // more than fit: clamped to the capacity
+    ASSERT_TRUE(decodeSsdDetections(result, 0.5f, overlay));
+    EXPECT_EQ(overlay.boxes.size(), 2u);
+}
+
+TEST(OverlayTest, RejectsOutputsOfAnotherShape) {
+    InferenceResult result;
+    result.count = 1001;  // a classifier's scores
+    Overlay overlay;
+    overlay.boxes.push_back({0, 0, 1, 1, 0});
+    EXPECT_FALSE(decodeSsdDetections(result, 0.5f, overlay));
+    EXPECT_TRUE(overlay.boxes.empty());
+    result.count = 1;
+    EXPECT_FALSE(decodeSsdDetections(result, 0.5f, overlay));
+}
+
+TEST(OverlayTest, ClassColorsAreOpaqueAndDistinct) {
+    std::set<uint32_t> colors;
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_EQ(overlayClassColor(i) >> 24, 0xFFu);
+        colors.insert(overlayClassColor(i));
+    }
+    EXPECT_EQ(colors.size(), 12u);
+    EXPECT_EQ(overlayClassColor(-1), overlayClassColor(11));
+}
+
+TEST(OverlayTest, SegmentationMaskCoversTheCropOnly) {
+    // A 4x2 output of two classes over the middle half of an 8x2 frame: the
+    // mask keeps the output's pitch, so the frame gets 8 cells across.
+    InferenceResult result;
+    result.frameTimestampNs = 42;
+    result.frameWidth = 8;
+    result.frameHeight = 2;
+    result.crop = {2, 0, 4, 2};
+    const float background[2] = {0.9f, 0.1f};
+    const float person[2] = {0.2f, 0.8f};
+    const bool covered[2][4] = {{true, false, false, true}, {false, true, true, false}};
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            const float* cell = covered[y][x] ? person : background;
+            result.values.insert(result.values.end(), cell, cell + 2);
+        }
+    }
+    result.count = int(result.values.size());
+    MaskLayout layout;
+    layout.width = 4;
+    layout.height = 2;
+    layout.classes = 2;
+    Overlay overlay;
+    overlay.boxes.push_back({0, 0, 1, 1, 0});
+    ASSERT_TRUE(decodeSegmentationMask(result, layout, overlay));
+    EXPECT_EQ(overlay.frameTimestampNs, 42);
+    EXPECT_TRUE(overlay.boxes.empty());
+    ASSERT_EQ(overlay.maskWidth, 8);
+    ASSERT_EQ(overlay.maskHeight, 2);
+    const std::vector<uint8_t> expected = {0, 0, 255, 0, 0, 255, 0, 0,
+                                           0, 0, 0, 255, 255, 0, 0, 0};
+    EXPECT_EQ(overlay.mask, expected);
+}
+
+TEST(OverlayTest, SingleClassMaskIsPartialCoverage) {
+    InferenceResult result;
+    result.values = {0.0f, 0.5f, 1.0f, 2.0f};
+    result.count = 4;
+    MaskLayout layout;
+    layout.width = 2;
+    layout.height = 2;
+    Overlay overlay;
+    ASSERT_TRUE(decodeSegmentationMask(result, layout, overlay));
+    EXPECT_EQ(overlay.mask, (std::vector<uint8_t>{0, 128, 255, 255}));
+
+    // Fewer values than the layout promises.
+    layout.width = 4;
+    EXPECT_FALSE(decodeSegmentationMask(result, layout, overlay));
+    EXPECT_TRUE(overlay.mask.empty());
+}
+
+TEST(OverlayTest, KeypointsAreMappedThroughTheCrop) {
+    TensorShape square;
+    square.width = square.height = 192;
+    InferenceResult result;
+    result.crop = centerCrop(640, 480, square);
+    result.frameWidth = 640;
+    result.frameHeight = 480;
+    // y, x, score
+    result.values = {0.5f, 0.0f, 0.9f, 0.2f, 0.2f, 0.1f, 1.5f, 1.0f, 0.6f};
+    result.count = 9;
+    Overlay overlay;
+    ASSERT_TRUE(decodePoseKeypoints(result, 0.3f, overlay));
+    ASSERT_EQ(overlay.points.size(), 2u);
+    EXPECT_FLOAT_EQ(overlay.points[0].x, 0.125f);
+    EXPECT_FLOAT_EQ(overlay.points[0].y, 0.5f);
+    EXPECT_EQ(overlay.points[0].color, overlayClassColor(0));
+    EXPECT_FLOAT_EQ(overlay.points[1].x, 0.875f);
+    EXPECT_FLOAT_EQ(overlay.points[1].y, 1.0f);
+    EXPECT_EQ(overlay.points[1].color, overlayClassColor(2));
+
+    result.count = 8;
+    EXPECT_FALSE(decodePoseKeypoints(result, 0.3f, overlay));
+}
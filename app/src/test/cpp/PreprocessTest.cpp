@@ -0,0 +1,156 @@
+#include "Preprocess.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// YUV_420_888 frame in host memory with the layouts AImageReader produces:
+// planar I420 (pixel stride 1) or interleaved NV21-style chroma (stride 2),
+// optionally with padded rows.
+struct TestImage {
+    TestImage(int width, int height, int pixelStride, int rowPadding) {
+        const int yStride = width + rowPadding;
+        const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+        const int cStride = cw * pixelStride + rowPadding;
+        y.resize(size_t(yStride) * height);
+        uint32_t seed = 12345;
+        auto next = [&seed] { return uint8_t((seed = seed * 1103515245u + 12345u) >> 16); };
+        for (auto& p : y) p = next();
+
+        frame.width = width;
+        frame.height = height;
+        frame.planeCount = 3;
+        frame.planes[0] = {y.data(), int(y.size()), yStride, 1};
+        if (pixelStride == 1) {
+            u.resize(size_t(cStride) * ch);
+            v.resize(size_t(cStride) * ch);
+            for (auto& p : u) p = next();
+            for (auto& p : v) p = next();
+            frame.planes[1] = {u.data(), int(u.size()), cStride, 1};
+            frame.planes[2] = {v.data(), int(v.size()), cStride, 1};
+        } else {
+            u.resize(size_t(cStride) * ch + 1);
+            for (auto& p : u) p = next();
+            frame.planes[2] = {u.data(), int(u.size()) - 1, cStride, 2};
+            frame.planes[1] = {u.data() + 1, int(u.size()) - 1, cStride, 2};
+        }
+    }
+
+    std::vector<uint8_t> y, u, v;
+    Frame frame;
+};
+
+TensorShape shapeOf(int width, int height, int channels, TensorType type) {
+    TensorShape shape;
+    shape.width = width;
+    shape.height = height;
+    shape.channels = channels;
+    shape.type = type;
+    if (type == TensorType::Float32) {
+        shape.mean = 127.5f;
+        shape.scale = 1.0f / 127.5f;
+    }
+    return shape;
+}
+
+std::vector<Preprocessor::Isa> supportedIsas() {
+    std::vector<Preprocessor::Isa> isas;
+    for (auto isa : {Preprocessor::Isa::Scalar, Preprocessor::Isa::Sse2,
+                     Preprocessor::Isa::Avx2, Preprocessor::Isa::Neon}) {
+        if (Preprocessor::supported(isa)) isas.push_back(isa);
+    }
+    return isas;
+}
+
+void expectMatchesReference(const TestImage& image, const TensorShape& shape, const CropRect& crop = {}) {
+    const size_t bytes = shape.bytes();
+    std::vector<uint8_t> expected(bytes), actual(bytes);
+    preprocessReference(image.frame, crop, shape, expected.data());
+    for (auto isa : supportedIsas()) {
+        Preprocessor preprocessor;
+        preprocessor.setIsa(isa);
+        preprocessor.setCrop(crop);
+        std::memset(actual.data(), 0xcd, bytes);
+        preprocessor.run(image.frame, shape, actual.data());
+        EXPECT_EQ(0, std::memcmp(expected.data(), actual.data(), bytes))
+                << Preprocessor::isaName(isa) << " " << shape.width << "x" << shape.height
+                << "x" << shape.channels;
+    }
+}
+
+}  // namespace
+
+TEST(PreprocessTest, CenterCropKeepsModelAspect) {
+    TensorShape square = shapeOf(224, 224, 3, TensorType::Float32);
+    CropRect crop = centerCrop(640, 480, square);
+    EXPECT_EQ(crop.x, 80);
+    EXPECT_EQ(crop.y, 0);
+    EXPECT_EQ(crop.width, 480);
+    EXPECT_EQ(crop.height, 480);
+
+    TensorShape wide = shapeOf(320, 120, 3, TensorType::Float32);
+    crop = centerCrop(640, 480, wide);
+    EXPECT_EQ(crop.width, 640);
+    EXPECT_EQ(crop.height, 240);
+    EXPECT_EQ(crop.y % 2, 0);
+}
+
+TEST(PreprocessTest, KernelsMatchReference) {
+    for (int pixelStride : {1, 2}) {
+        for (int padding : {0, 24}) {
+            TestImage image(640, 480, pixelStride, padding);
+            for (auto type : {TensorType::Float32, TensorType::UInt8}) {
+                expectMatchesReference(image, shapeOf(224, 224, 3, type));
+                expectMatchesReference(image, shapeOf(224, 224, 1, type));
+            }
+        }
+    }
+}
+
+TEST(PreprocessTest, OddSizesAndCrops) {
+    TestImage image(97, 61, 2, 3);
+    for (auto type : {TensorType::Float32, TensorType::UInt8}) {
+        for (int width : {1, 3, 4, 5, 8, 9, 17, 33}) {
+            expectMatchesReference(image, shapeOf(width, 7, 3, type));
+        }
+        expectMatchesReference(image, shapeOf(128, 128, 3, type));  // upscale
+        expectMatchesReference(image, shapeOf(20, 20, 3, type), CropRect{10, 4, 40, 40});
+    }
+}
+
+TEST(PreprocessTest, TablesFollowGeometryChanges) {
+    TestImage small(64, 48, 1, 0);
+    TestImage large(320, 240, 2, 16);
+    TensorShape shape = shapeOf(32, 32, 3, TensorType::UInt8);
+    std::vector<uint8_t> expected(shape.bytes()), actual(shape.bytes());
+
+    Preprocessor preprocessor;
+    for (const TestImage* image : {&small, &large, &small}) {
+        preprocessReference(image->frame, CropRect{}, shape, expected.data());
+        preprocessor.run(image->frame, shape, actual.data());
+        EXPECT_EQ(expected, actual);
+    }
+}
+
+TEST(PreprocessTest, ConvertsKnownColours) {
+    // Uniform mid-grey luma with strong chroma: BT.601 full range gives
+    // R = 128 + 1.402 * 100 clips, G = 128 - (0.344 * -100 + 0.714 * 100) = 92,
+    // B = 128 + 1.772 * -100 clips.
+    std::vector<uint8_t> y(16, 128), u(4, 28), v(4, 228);
+    Frame frame;
+    frame.width = 4;
+    frame.height = 4;
+    frame.planeCount = 3;
+    frame.planes[0] = {y.data(), 16, 4, 1};
+    frame.planes[1] = {u.data(), 4, 2, 1};
+    frame.planes[2] = {v.data(), 4, 2, 1};
+
+    TensorShape shape = shapeOf(4, 4, 3, TensorType::UInt8);
+    std::vector<uint8_t> out(shape.bytes());
+    Preprocessor preprocessor;
+    preprocessor.run(frame, shape, out.data());
+    EXPECT_EQ(out[0], 255);
+    EXPECT_EQ(out[1], 92);
+    EXPECT_EQ(out[2], 0);
+}
@@ -0,0 +1,53 @@
+#include "PreviewTransform.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+struct Point {
+    float x, y;
+};
+
+Point apply(const PreviewTransform& t, float x, float y) {
+    return {t.matrix[0] * x + t.matrix[2] * y, t.matrix[1] * x + t.matrix[3] * y};
+}
+
+void expectPoint(Point got, float x, float y) {
+    EXPECT_NEAR(got.x, x, 1e-5f);
+    EXPECT_NEAR(got.y, y, 1e-5f);
+}
+
+}  // namespace
+
+TEST(PreviewTransformTest, IdentityUntilSizesAreKnown) {
+    for (PreviewTransform t : {previewTransform(0, 0, 90, 1080, 1920), previewTransform(640, 480, 90, 0, 0)}) {
+        expectPoint(apply(t, 1, 1), 1, 1);
+        expectPoint(apply(t, -1, 1), -1, 1);
+    }
+}
+
+TEST(PreviewTransformTest, FitLetterboxesAndFillCrops) {
+    // 4:3 frame in a 16:9 landscape viewport: full height, 0.75 of the width.
+    PreviewTransform fit = previewTransform(640, 480, 0, 1920, 1080, ScaleMode::Fit);
+    expectPoint(apply(fit, 1, 1), 0.75f, 1);
+    // Fill covers the width and crops top and bottom.
+    PreviewTransform fill = previewTransform(640, 480, 0, 1920, 1080, ScaleMode::Fill);
+    expectPoint(apply(fill, 1, 1), 1, 4.0f / 3);
+}
+
+TEST(PreviewTransformTest, QuarterTurnsRotateClockwiseAndSwapAspect) {
+    // A 640x480 landscape sensor frame on a 480x640 portrait screen fills it
+    // exactly once turned upright.
+    PreviewTransform t = previewTransform(640, 480, 90, 480, 640);
+    // Top-left of the frame ends up top-right, bottom-left top-left.
+    expectPoint(apply(t, -1, 1), 1, 1);
+    expectPoint(apply(t, -1, -1), -1, 1);
+
+    PreviewTransform half = previewTransform(640, 480, 180, 640, 480);
+    expectPoint(apply(half, -1, 1), 1, -1);
+
+    PreviewTransform three = previewTransform(640, 480, 270, 480, 640);
+    expectPoint(apply(three, -1, 1), -1, -1);
+    // Negative angles normalise.
+    PreviewTransform negative = previewTransform(640, 480, -90, 480, 640);
+    for (int i = 0; i < 4; ++i) EXPECT_FLOAT_EQ(negative.matrix[i], three.matrix[i]);
+}
@@ -0,0 +1,166 @@
+#include "HeadlessGlContext.h"
+#include "ShaderCache.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kSize = 8;
+
+// A triangle covering the viewport, so no vertex buffers are needed.
+const char* kVertexSrc = "#version 300 es\n"
+                         "void main() {\n"
+                         "    vec2 p = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);\n"
+                         "    gl_Position = vec4(p, 0.0, 1.0);\n"
+                         "}\n";
+
+const char* kFragmentSrc = "#version 300 es\n"
+                           "precision mediump float;\n"
+                           "uniform vec4 u_Color;\n"
+                           "out vec4 fragColor;\n"
+                           "void main() { fragColor = u_Color; }\n";
+
+const char* kEditedFragmentSrc = "#version 300 es\n"
+                                 "precision mediump float;\n"
+                                 "uniform vec4 u_Color;\n"
+                                 "out vec4 fragColor;\n"
+                                 "void main() { fragColor = u_Color.bgra; }\n";
+
+class ShaderCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char path[] = "/tmp/shader-cache-test-XXXXXX";
+        ASSERT_TRUE(mkdtemp(path));
+        directory_ = path;
+        if (!gl_.create(kSize, kSize)) GTEST_SKIP() << gl_.error();
+    }
+
+    void TearDown() override {
+        gl_.destroy();
+        std::system(("rm -rf " + directory_).c_str());
+    }
+
+    // A fresh context, as after the process restarts.
+    void recreateContext() {
+        gl_.destroy();
+        ASSERT_TRUE(gl_.create(kSize, kSize));
+    }
+
+    bool binariesSupported() {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    bool saved(const char* name) {
+        struct stat info;
+        return stat((directory_ + "/" + name + ".glbin").c_str(), &info) == 0 && info.st_size > 0;
+    }
+
+    // Draws with the program and returns the red channel it produced.
+    int drawRed(GLuint program) {
+        glUseProgram(program);
+        glUniform4f(glGetUniformLocation(program, "u_Color"), 1.0f, 0.0f, 0.0f, 1.0f);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        uint8_t rgba[4] = {};
+        glReadPixels(kSize / 2, kSize / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        EXPECT_EQ(glGetError(), GLenum(GL_NO_ERROR));
+        return rgba[0];
+    }
+
+    HeadlessGlContext gl_;
+    std::string directory_;
+};
+
+}  // namespace
+
+TEST_F(ShaderCacheTest, BuildsEachProgramOncePerContext) {
+    ShaderCache shaders;
+    const GLuint program = shaders.program("solid", kVertexSrc, kFragmentSrc);
+    ASSERT_NE(program, 0u);
+    EXPECT_EQ(shaders.program("solid", kVertexSrc, kFragmentSrc), program);
+    EXPECT_EQ(shaders.stats().requests, 2);
+    EXPECT_EQ(shaders.stats().compiled, 1);
+    EXPECT_GT(shaders.stats().compileNs, 0);
+    EXPECT_EQ(drawRed(program), 255);
+    // No directory, nothing saved.
+    EXPECT_FALSE(saved("solid"));
+    shaders.release();
+}
+
+TEST_F(ShaderCacheTest, NextContextLoadsTheSavedBinary) {
+    if (!binariesSupported()) GTEST_SKIP() << "driver offers no program binary formats";
+    {
+        ShaderCache shaders;
+        shaders.setDirectory(directory_);
+        ASSERT_NE(shaders.program("solid", kVertexSrc, kFragmentSrc), 0u);
+        EXPECT_EQ(shaders.stats().compiled, 1);
+        shaders.abandon();
+    }
+    EXPECT_TRUE(saved("solid"));
+
+    recreateContext();
+    ShaderCache shaders;
+    shaders.setDirectory(directory_);
+    const GLuint program = shaders.program("solid", kVertexSrc, kFragmentSrc);
+    ASSERT_NE(program, 0u);
+    EXPECT_EQ(shaders.stats().loaded, 1);
+    EXPECT_EQ(shaders.stats().compiled, 0);
+    EXPECT_EQ(drawRed(program), 255);
+    shaders.release();
+}
+
+TEST_F(ShaderCacheTest, EditedSourceOrDamagedFileIsRebuilt) {
+    if (!binariesSupported()) GTEST_SKIP() << "driver offers no program binary formats";
+    {
+        ShaderCache shaders;
+        shaders.setDirectory(directory_);
+        ASSERT_NE(shaders.program("solid", kVertexSrc, kFragmentSrc), 0u);
+        shaders.release();
+    }
+
+    // Same name, new source: the old binary must not be used.
+    recreateContext();
+    {
+        ShaderCache shaders;
+        shaders.setDirectory(directory_);
+        const GLuint program = shaders.program("solid", kVertexSrc, kEditedFragmentSrc);
+        ASSERT_NE(program, 0u);
+        EXPECT_EQ(shaders.stats().rejected, 1);
+        EXPECT_EQ(shaders.stats().compiled, 1);
+        EXPECT_EQ(drawRed(program), 0);  // red went to blue
+        shaders.release();
+    }
+
+    // The rewritten file serves the edited source, until it is cut short.
+    recreateContext();
+    {
+        ShaderCache shaders;
+        shaders.setDirectory(directory_);
+        ASSERT_NE(shaders.program("solid", kVertexSrc, kEditedFragmentSrc), 0u);
+        EXPECT_EQ(shaders.stats().loaded, 1);
+        shaders.release();
+    }
+    const std::string path = directory_ + "/solid.glbin";
+    struct stat info;
+    ASSERT_EQ(stat(path.c_str(), &info), 0);
+    ASSERT_EQ(truncate(path.c_str(), info.st_size / 2), 0);
+    recreateContext();
+    ShaderCache shaders;
+    shaders.setDirectory(directory_);
+    EXPECT_NE(shaders.program("solid", kVertexSrc, kEditedFragmentSrc), 0u);
+    EXPECT_EQ(shaders.stats().rejected, 1);
+    EXPECT_EQ(shaders.stats().compiled, 1);
+    shaders.release();
+}
+
+TEST_F(ShaderCacheTest, BrokenSourceGivesNoProgramAndNoFile) {
+    ShaderCache shaders;
+    shaders.setDirectory(directory_);
+    EXPECT_EQ(shaders.program("broken", kVertexSrc, "#version 300 es\nnot glsl\n"), 0u);
+    EXPECT_FALSE(saved("broken"));
+    EXPECT_EQ(shaders.stats().compiled, 0);
+}
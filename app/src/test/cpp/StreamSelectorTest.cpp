@@ -0,0 +1,105 @@
+#include "StreamSelector.h"
+#include <gtest/gtest.h>
+#include <iterator>
+
+namespace {
+
+constexpr int32_t kYuv = 0x23;
+constexpr int32_t kJpeg = 0x21;
+constexpr int32_t kOutput = 0, kInput = 1;
+constexpr int64_t k30Fps = 33333333, k20Fps = 50000000, k60Fps = 16666666;
+
+// Laid out like a phone back camera's characteristics: YUV and JPEG outputs,
+// a YUV reprocessing input, and a full-resolution mode that tops out at 20 fps.
+const int32_t kConfigurations[] = {
+        kYuv,  4032, 3024, kOutput,
+        kYuv,  4032, 3024, kInput,
+        kJpeg, 4032, 3024, kOutput,
+        kYuv,  1920, 1080, kOutput,
+        kYuv,  1440, 1080, kOutput,
+        kYuv,  1280, 720,  kOutput,
+        kJpeg, 1280, 720,  kOutput,
+        kYuv,  640,  480,  kOutput,
+        kYuv,  352,  288,  kOutput,
+        kYuv,  320,  240,  kOutput,
+        kYuv,  176,  144,  kOutput,
+};
+const int64_t kDurations[] = {
+        kYuv,  4032, 3024, k20Fps,
+        kJpeg, 4032, 3024, k20Fps,
+        kYuv,  1920, 1080, k30Fps,
+        kYuv,  1440, 1080, k30Fps,
+        kYuv,  1280, 720,  k60Fps,
+        kJpeg, 1280, 720,  k30Fps,
+        kYuv,  640,  480,  k30Fps,
+        kYuv,  352,  288,  k30Fps,
+        kYuv,  320,  240,  k30Fps,
+        kYuv,  176,  144,  k30Fps,
+};
+
+StreamSelector fixture() {
+    return StreamSelector(kConfigurations, std::size(kConfigurations), kDurations, std::size(kDurations));
+}
+
+SizeTarget target(int width, int height, double aspect = 0, double minFps = 0) {
+    SizeTarget t;
+    t.width = width;
+    t.height = height;
+    t.aspect = aspect;
+    t.minFps = minFps;
+    return t;
+}
+
+}  // namespace
+
+TEST(StreamSelectorTest, KeepsYuvOutputsWithTheirFrameDurations) {
+    StreamSelector selector = fixture();
+    ASSERT_EQ(selector.sizes().size(), 8u);
+    EXPECT_EQ(selector.sizes().front().width, 4032);  // largest first
+    EXPECT_EQ(selector.sizes().front().minFrameDurationNs, k20Fps);
+    EXPECT_EQ(selector.find(1280, 720).minFrameDurationNs, k60Fps);  // the YUV entry, not JPEG's
+    EXPECT_FALSE(selector.find(800, 600));
+}
+
+TEST(StreamSelectorTest, PicksTheSmallestCoveringSizeOfTheRightShape) {
+    StreamSelector selector = fixture();
+    // Model input: 224x224 at the preview's 4:3 field of view.
+    StreamSize analysis = selector.select(target(224, 224, 4.0 / 3.0));
+    EXPECT_EQ(analysis.width, 320);
+    EXPECT_EQ(analysis.height, 240);
+    // Without an aspect preference the smallest covering size wins.
+    StreamSize any = selector.select(target(224, 224));
+    EXPECT_EQ(any.width, 320);
+    // 1080p preview on a 16:9 screen.
+    StreamSize preview = selector.select(target(1920, 1080, 16.0 / 9.0));
+    EXPECT_EQ(preview.width, 1920);
+    EXPECT_EQ(preview.height, 1080);
+}
+
+TEST(StreamSelectorTest, FallsBackToTheLargestSizeBelowTheTarget) {
+    EXPECT_EQ(fixture().select(target(8000, 6000, 4.0 / 3.0)).width, 4032);
+    // At 30 fps full resolution is out, so 4:3 tops out at 1440x1080.
+    StreamSize size = fixture().select(target(8000, 6000, 4.0 / 3.0, 30));
+    EXPECT_EQ(size.width, 1440);
+    EXPECT_EQ(size.height, 1080);
+    EXPECT_NEAR(size.maxFps(), 30.0, 0.01);
+}
+
+TEST(StreamSelectorTest, FastestPrefersFrameRateOverSize) {
+    SizeTarget t = target(1920, 1080);
+    t.fastest = true;
+    StreamSize size = fixture().select(t);
+    EXPECT_EQ(size.width, 1280);
+    EXPECT_EQ(size.minFrameDurationNs, k60Fps);
+
+    // A size with no listed duration is not taken for the fastest.
+    const int32_t configurations[] = {kYuv, 1920, 1080, kOutput, kYuv, 640, 480, kOutput};
+    const int64_t durations[] = {kYuv, 1920, 1080, k30Fps};
+    size = StreamSelector(configurations, std::size(configurations), durations, std::size(durations)).select(t);
+    EXPECT_EQ(size.width, 1920);
+}
+
+TEST(StreamSelectorTest, EmptyWithoutSizesOrWhenNothingIsFastEnough) {
+    EXPECT_FALSE(StreamSelector().select(target(640, 480)));
+    EXPECT_FALSE(fixture().select(target(640, 480, 0, 120)));
+}
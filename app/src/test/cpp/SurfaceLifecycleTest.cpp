@@ -0,0 +1,241 @@
+#include "FramePipeline.h"
+#include "HeadlessRenderer.h"
+#include "SurfaceLifecycle.h"
+#include "SyntheticFrameSource.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int64_t kGraceNs = 1000;
+
+// Windows are only ever compared, never dereferenced.
+ANativeWindow* fakeWindow(int id) { return reinterpret_cast<ANativeWindow*>(uintptr_t(id)); }
+
+// Writes down what the lifecycle asked of it.
+class RecordingHost : public LifecycleHost {
+public:
+    bool startSession(ANativeWindow* window) override {
+        calls.push_back("start " + name(window));
+        return startOk;
+    }
+    void stopSession() override { calls.push_back("stop"); }
+    bool attachWindow(ANativeWindow* window) override {
+        calls.push_back("attach " + name(window));
+        return attachOk;
+    }
+    void detachWindow() override { calls.push_back("detach"); }
+
+    // What was asked since the last call to this.
+    std::vector<std::string> take() {
+        std::vector<std::string> taken;
+        taken.swap(calls);
+        return taken;
+    }
+
+    bool startOk = true;
+    bool attachOk = true;
+    std::vector<std::string> calls;
+
+private:
+    static std::string name(ANativeWindow* window) { return std::to_string(uintptr_t(window)); }
+};
+
+using Calls = std::vector<std::string>;
+using State = SurfaceLifecycle::State;
+
+}  // namespace
+
+TEST(SurfaceLifecycleTest, WindowBackWithinTheGracePeriodResumesTheSession) {
+    RecordingHost host;
+    SurfaceLifecycle lifecycle(host, kGraceNs);
+    EXPECT_TRUE(lifecycle.onWindowCreated(fakeWindow(1)));
+    EXPECT_EQ(host.take(), (Calls{"start 1", "attach 1"}));
+    EXPECT_EQ(lifecycle.state(), State::Running);
+    EXPECT_EQ(lifecycle.deadlineNs(), -1);
+
+    lifecycle.onWindowDestroyed(5000);
+    EXPECT_EQ(host.take(), (Calls{"detach"}));
+    EXPECT_EQ(lifecycle.state(), State::Suspended);
+    EXPECT_EQ(lifecycle.deadlineNs(), 5000 + kGraceNs);
+    lifecycle.poll(5000 + kGraceNs - 1);
+    EXPECT_TRUE(host.take().empty());
+
+    // Only the window changes hands.
+    EXPECT_TRUE(lifecycle.onWindowCreated(fakeWindow(2)));
+    EXPECT_EQ(host.take(), (Calls{"attach 2"}));
+    EXPECT_EQ(lifecycle.state(), State::Running);
+    EXPECT_EQ(lifecycle.deadlineNs(), -1);
+    lifecycle.poll(1000000);
+    EXPECT_TRUE(host.take().empty());
+    EXPECT_EQ(lifecycle.coldStarts(), 1u);
+    EXPECT_EQ(lifecycle.warmResumes(), 1u);
+
+    // A window replaced without a destroy in between is handed over too.
+    EXPECT_TRUE(lifecycle.onWindowCreated(fakeWindow(3)));
+    EXPECT_EQ(host.take(), (Calls{"detach", "attach 3"}));
+    EXPECT_EQ(lifecycle.warmResumes(), 2u);
+}
+
+TEST(SurfaceLifecycleTest, SessionStopsWhenTheGracePeriodRunsOut) {
+    RecordingHost host;
+    SurfaceLifecycle lifecycle(host, kGraceNs);
+    lifecycle.onWindowCreated(fakeWindow(1));
+    lifecycle.onWindowDestroyed(5000);
+    host.take();
+
+    lifecycle.poll(5000 + kGraceNs);
+    EXPECT_EQ(host.take(), (Calls{"stop"}));
+    EXPECT_EQ(lifecycle.state(), State::Stopped);
+    EXPECT_EQ(lifecycle.deadlineNs(), -1);
+    EXPECT_EQ(lifecycle.expired(), 1u);
+    lifecycle.poll(1000000);
+    lifecycle.onWindowDestroyed(1000000);  // stray: nothing to detach
+    EXPECT_TRUE(host.take().empty());
+
+    // The next window starts over.
+    EXPECT_TRUE(lifecycle.onWindowCreated(fakeWindow(2)));
+    EXPECT_EQ(host.take(), (Calls{"start 2", "attach 2"}));
+    EXPECT_EQ(lifecycle.coldStarts(), 2u);
+    EXPECT_EQ(lifecycle.warmResumes(), 0u);
+
+    // Without a grace period a lost window stops the session at once.
+    SurfaceLifecycle impatient(host, 0);
+    impatient.onWindowCreated(fakeWindow(3));
+    host.take();
+    impatient.onWindowDestroyed(0);
+    EXPECT_EQ(host.take(), (Calls{"detach", "stop"}));
+    EXPECT_EQ(impatient.state(), State::Stopped);
+}
+
+TEST(SurfaceLifecycleTest, DestroyStopsWhateverIsLeft) {
+    RecordingHost host;
+    SurfaceLifecycle lifecycle(host, kGraceNs);
+    lifecycle.onDestroy();
+    EXPECT_TRUE(host.take().empty());
+
+    lifecycle.onWindowCreated(fakeWindow(1));
+    host.take();
+    lifecycle.onDestroy();
+    EXPECT_EQ(host.take(), (Calls{"detach", "stop"}));
+    EXPECT_EQ(lifecycle.state(), State::Stopped);
+
+    lifecycle.onWindowCreated(fakeWindow(2));
+    lifecycle.onWindowDestroyed(0);
+    host.take();
+    lifecycle.onDestroy();
+    EXPECT_EQ(host.take(), (Calls{"stop"}));
+    EXPECT_EQ(lifecycle.deadlineNs(), -1);
+}
+
+TEST(SurfaceLifecycleTest, FailuresLeaveNothingHalfStarted) {
+    RecordingHost host;
+    SurfaceLifecycle lifecycle(host, kGraceNs);
+    host.startOk = false;
+    // The host tears down whatever did start.
+    EXPECT_FALSE(lifecycle.onWindowCreated(fakeWindow(1)));
+    EXPECT_EQ(host.take(), (Calls{"start 1", "stop"}));
+    EXPECT_EQ(lifecycle.state(), State::Stopped);
+
+    host.startOk = true;
+    host.attachOk = false;
+    EXPECT_FALSE(lifecycle.onWindowCreated(fakeWindow(1)));
+    EXPECT_EQ(host.take(), (Calls{"start 1", "attach 1", "stop"}));
+    EXPECT_EQ(lifecycle.state(), State::Stopped);
+
+    // A suspended session that cannot take the new window is restarted
+    // for it, rather than left without one.
+    host.attachOk = true;
+    lifecycle.onWindowCreated(fakeWindow(1));
+    lifecycle.onWindowDestroyed(0);
+    host.take();
+    host.attachOk = false;
+    EXPECT_FALSE(lifecycle.onWindowCreated(fakeWindow(2)));
+    EXPECT_EQ(host.take(), (Calls{"attach 2", "stop", "start 2", "attach 2", "stop"}));
+    EXPECT_EQ(lifecycle.state(), State::Stopped);
+    EXPECT_EQ(lifecycle.deadlineNs(), -1);
+}
+
+TEST(SurfaceLifecycleTest, SuspendedSessionKeepsItsSourceAndDrawsAgainOnResume) {
+    // The shape of the app's host: the source is the session, the render
+    // thread is the window.
+    struct PipelineHost : LifecycleHost {
+        HeadlessRenderer renderer;
+        FramePipeline pipeline{renderer};
+        SyntheticFrameSource source;
+        int opens = 0;
+
+        bool startSession(ANativeWindow*) override {
+            ++opens;
+            return source.open(StreamConfig(), [this](FrameHandle frame) { pipeline.submit(std::move(frame)); });
+        }
+        void stopSession() override { source.close(); }
+        bool attachWindow(ANativeWindow*) override {
+            pipeline.start();
+            return true;
+        }
+        void detachWindow() override { pipeline.stop(); }
+    };
+
+    PipelineHost host;
+    SurfaceLifecycle lifecycle(host);
+    ASSERT_TRUE(lifecycle.onWindowCreated(fakeWindow(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    lifecycle.onWindowDestroyed(0);
+    EXPECT_GT(host.pipeline.stats().presented, 0u);
+
+    // Frames that arrive with no window are turned away, not queued.
+    const uint64_t rejected = host.pipeline.ring().droppedNewest();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_GT(host.pipeline.ring().droppedNewest(), rejected);
+
+    ASSERT_TRUE(lifecycle.onWindowCreated(fakeWindow(2)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    lifecycle.onDestroy();
+    EXPECT_EQ(host.opens, 1);
+    EXPECT_GT(host.pipeline.stats().presented, 0u);
+}
+
+TEST(SurfaceLifecycleTest, SourceLostWhileSuspendedIsReopenedOnResume) {
+    // Another app takes the camera while the window is gone.
+    struct LosableSource : SyntheticFrameSource {
+        void lose() { setLost(true); }
+    };
+    struct PipelineHost : LifecycleHost {
+        HeadlessRenderer renderer;
+        FramePipeline pipeline{renderer};
+        LosableSource source;
+        int opens = 0;
+
+        bool startSession(ANativeWindow*) override {
+            ++opens;
+            return source.open(StreamConfig(), [this](FrameHandle frame) { pipeline.submit(std::move(frame)); });
+        }
+        void stopSession() override { source.close(); }
+        bool attachWindow(ANativeWindow*) override {
+            if (source.lost()) return false;
+            pipeline.start();
+            return true;
+        }
+        void detachWindow() override { pipeline.stop(); }
+    };
+
+    PipelineHost host;
+    SurfaceLifecycle lifecycle(host);
+    ASSERT_TRUE(lifecycle.onWindowCreated(fakeWindow(1)));
+    lifecycle.onWindowDestroyed(0);
+    host.source.lose();
+
+    // The resume falls through to a cold start, which draws again.
+    ASSERT_TRUE(lifecycle.onWindowCreated(fakeWindow(2)));
+    EXPECT_EQ(host.opens, 2);
+    EXPECT_FALSE(host.source.lost());
+    EXPECT_EQ(lifecycle.coldStarts(), 2u);
+    EXPECT_EQ(lifecycle.warmResumes(), 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    lifecycle.onDestroy();
+    EXPECT_GT(host.pipeline.stats().presented, 0u);
+}
@@ -0,0 +1,106 @@
+#include "SyntheticFrameSource.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Received {
+    std::mutex mutex;
+    std::vector<FrameHandle> held;
+    std::vector<int64_t> timestamps;
+    int width = 0;
+    int height = 0;
+    int stream = -1;
+
+    FrameCallback collect(bool hold) {
+        return [this, hold](FrameHandle frame) {
+            std::lock_guard<std::mutex> lock(mutex);
+            width = frame->width;
+            height = frame->height;
+            stream = frame->stream;
+            timestamps.push_back(frame->timestampNs);
+            if (hold) held.push_back(std::move(frame));
+        };
+    }
+};
+
+StreamRequest request(int width, int height, int maxImages, FrameCallback onFrame) {
+    StreamRequest request;
+    request.config.width = width;
+    request.config.height = height;
+    request.config.maxImages = maxImages;
+    request.onFrame = std::move(onFrame);
+    return request;
+}
+
+bool waitFor(const std::function<bool()>& done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST(SyntheticFrameSourceTest, DeliversEachStreamAtItsOwnSize) {
+    SyntheticSourceOptions options;
+    options.fps = 200;
+    SyntheticFrameSource source(options);
+    Received preview, analysis;
+    ASSERT_TRUE(source.open({request(640, 480, 4, preview.collect(false)),
+                             request(320, 240, 2, analysis.collect(false))}));
+    ASSERT_TRUE(waitFor([&] { return source.delivered(0) >= 5 && source.delivered(1) >= 5; }));
+    source.close();
+
+    EXPECT_EQ(preview.width, 640);
+    EXPECT_EQ(preview.height, 480);
+    EXPECT_EQ(preview.stream, 0);
+    EXPECT_EQ(analysis.width, 320);
+    EXPECT_EQ(analysis.height, 240);
+    EXPECT_EQ(analysis.stream, 1);
+    // One capture fills both targets, so both streams see the same timestamps.
+    size_t n = std::min(preview.timestamps.size(), analysis.timestamps.size());
+    for (size_t i = 0; i < n; ++i) EXPECT_EQ(preview.timestamps[i], analysis.timestamps[i]);
+}
+
+TEST(SyntheticFrameSourceTest, HeldBuffersOnlyStarveTheirOwnStream) {
+    SyntheticSourceOptions options;
+    options.fps = 200;
+    SyntheticFrameSource source(options);
+    Received preview, analysis;
+    ASSERT_TRUE(source.open({request(640, 480, 3, preview.collect(false)),
+                             request(320, 240, 2, analysis.collect(true))}));
+    ASSERT_TRUE(waitFor([&] { return source.dropped(1) >= 5; }));
+    ASSERT_TRUE(waitFor([&] { return source.delivered(0) >= 10; }));
+    source.close();
+
+    EXPECT_EQ(source.delivered(1), 2u);
+    EXPECT_EQ(source.dropped(0), 0u);
+}
+
+TEST(SyntheticFrameSourceTest, ControlsRetimeTheRunningCapture) {
+    SyntheticSourceOptions options;
+    options.fps = 50;
+    SyntheticFrameSource source(options);
+    ASSERT_TRUE(source.open(StreamConfig(), [](FrameHandle) {}));
+    ASSERT_TRUE(waitFor([&] { return source.lastCapture().frameDurationNs == 20000000; }));
+
+    CaptureControls controls;
+    controls.fps = {100, 100};
+    controls.exposureTimeNs = 4000000;
+    controls.sensitivity = 800;
+    EXPECT_EQ(source.setControls(controls).fps, (FpsRange{100, 100}));
+    ASSERT_TRUE(waitFor([&] { return source.lastCapture().frameDurationNs == 10000000; }));
+    CaptureResultInfo capture = source.lastCapture();
+    EXPECT_EQ(capture.exposureTimeNs, 4000000);
+    EXPECT_EQ(capture.sensitivity, 800);
+    EXPECT_DOUBLE_EQ(capture.fps(), 100.0);
+    source.close();
+}
+
+}  // namespace
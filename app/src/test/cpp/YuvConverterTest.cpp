@@ -0,0 +1,217 @@
+#include "HeadlessGlContext.h"
+#include "YuvConverter.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+// Chroma is constant over 16x16 luma blocks so bilinear chroma upsampling
+// cannot blur it away from the reference away from block edges.
+constexpr int kBlock = 16;
+
+// YUV_420_888 test image in any of the layouts a camera hands out.
+struct YuvImage {
+    std::vector<uint8_t> y, u, v;  // tightly packed source values
+    std::vector<uint8_t> buffer;
+    Frame frame;
+
+    YuvImage(int width, int height, unsigned seed) {
+        std::mt19937 rng(seed);
+        const int cw = width / 2, ch = height / 2;
+        y.resize(size_t(width) * height);
+        u.resize(size_t(cw) * ch);
+        v.resize(size_t(cw) * ch);
+        for (uint8_t& sample : y) sample = uint8_t(rng());
+        std::vector<uint8_t> blockU((cw / (kBlock / 2)) * (ch / (kBlock / 2)));
+        std::vector<uint8_t> blockV(blockU.size());
+        for (size_t i = 0; i < blockU.size(); ++i) {
+            blockU[i] = uint8_t(rng());
+            blockV[i] = uint8_t(rng());
+        }
+        const int blocksPerRow = cw / (kBlock / 2);
+        for (int row = 0; row < ch; ++row) {
+            for (int col = 0; col < cw; ++col) {
+                int block = (row / (kBlock / 2)) * blocksPerRow + col / (kBlock / 2);
+                u[row * cw + col] = blockU[block];
+                v[row * cw + col] = blockV[block];
+            }
+        }
+        frame.width = width;
+        frame.height = height;
+        frame.planeCount = 3;
+    }
+
+    // pixelStride 1: I420. pixelStride 2: NV12 (vFirst = false) or NV21.
+    void layout(int pixelStride, int rowPadding, bool vFirst = false) {
+        const int w = frame.width, h = frame.height, cw = w / 2, ch = h / 2;
+        const int yStride = w + rowPadding;
+        const int cStride = cw * pixelStride + rowPadding;
+        const size_t ySize = size_t(yStride) * h, cSize = size_t(cStride) * ch;
+        buffer.assign(ySize + cSize * (pixelStride == 1 ? 2 : 1), 0xEE);
+        uint8_t* yDst = buffer.data();
+        for (int row = 0; row < h; ++row) std::copy_n(&y[row * w], w, yDst + row * yStride);
+        uint8_t* uDst = yDst + ySize;
+        uint8_t* vDst = pixelStride == 1 ? uDst + cSize : uDst + 1;
+        if (pixelStride == 2 && vFirst) std::swap(uDst, vDst);
+        for (int row = 0; row < ch; ++row) {
+            for (int col = 0; col < cw; ++col) {
+                uDst[row * cStride + col * pixelStride] = u[row * cw + col];
+                vDst[row * cStride + col * pixelStride] = v[row * cw + col];
+            }
+        }
+        frame.planes[0] = {yDst, int(ySize), yStride, 1};
+        frame.planes[1] = {uDst, int(cSize) - (pixelStride - 1), cStride, pixelStride};
+        frame.planes[2] = {vDst, int(cSize) - (pixelStride - 1), cStride, pixelStride};
+    }
+};
+
+struct Rgb {
+    double r, g, b;
+};
+
+// Textbook equations, independent of yuvCoefficients().
+Rgb referenceRgb(int y, int u, int v, YuvMatrix matrix, YuvRange range) {
+    const double cb = u - 128.0, cr = v - 128.0;
+    Rgb rgb;
+    if (matrix == YuvMatrix::Bt601 && range == YuvRange::Full) {
+        rgb = {y + 1.402 * cr, y - 0.344136 * cb - 0.714136 * cr, y + 1.772 * cb};
+    } else if (matrix == YuvMatrix::Bt709 && range == YuvRange::Limited) {
+        const double yl = 1.164384 * (y - 16);
+        rgb = {yl + 1.792741 * cr, yl - 0.213249 * cb - 0.532909 * cr, yl + 2.112402 * cb};
+    } else {
+        ADD_FAILURE() << "no reference for this color space";
+        rgb = {0, 0, 0};
+    }
+    auto clamp = [](double c) { return std::min(255.0, std::max(0.0, c)); };
+    return {clamp(rgb.r), clamp(rgb.g), clamp(rgb.b)};
+}
+
+class YuvConverterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!gl_.create(kWidth, kHeight)) GTEST_SKIP() << gl_.error();
+        ASSERT_TRUE(converter_.init(shaders_));
+    }
+
+    void TearDown() override {
+        converter_.release();
+        shaders_.release();
+        gl_.destroy();
+    }
+
+    // Renders the image and compares every pixel away from chroma block
+    // edges against the reference; returns the largest channel error.
+    double renderAndCompare(const YuvImage& image, YuvMatrix matrix, YuvRange range) {
+        converter_.setColorSpace(matrix, range);
+        converter_.upload(image.frame);
+        converter_.draw();
+        std::vector<uint8_t> rgba(size_t(kWidth) * kHeight * 4);
+        glReadPixels(0, 0, kWidth, kHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        EXPECT_EQ(glGetError(), GLenum(GL_NO_ERROR));
+
+        double worst = 0;
+        for (int row = 0; row < kHeight; ++row) {
+            for (int col = 0; col < kWidth; ++col) {
+                if (row % kBlock < 2 || row % kBlock >= kBlock - 2) continue;
+                if (col % kBlock < 2 || col % kBlock >= kBlock - 2) continue;
+                const int c = (row / 2) * (kWidth / 2) + col / 2;
+                Rgb want = referenceRgb(image.y[row * kWidth + col], image.u[c], image.v[c], matrix, range);
+                // The quad puts the first image row at the top; readback starts at the bottom.
+                const uint8_t* got = &rgba[(size_t(kHeight - 1 - row) * kWidth + col) * 4];
+                worst = std::max({worst, std::abs(got[0] - want.r), std::abs(got[1] - want.g),
+                                  std::abs(got[2] - want.b)});
+            }
+        }
+        return worst;
+    }
+
+    HeadlessGlContext gl_;
+    ShaderCache shaders_;
+    YuvConverter converter_;
+};
+
+TEST_F(YuvConverterTest, PlanarWithRowPaddingMatchesReference) {
+    YuvImage image(kWidth, kHeight, 1);
+    image.layout(1, 24);
+    EXPECT_LE(renderAndCompare(image, YuvMatrix::Bt601, YuvRange::Full), 2.0);
+    EXPECT_EQ(converter_.stagedUploads(), 0u);  // no buffers asked for
+}
+
+TEST_F(YuvConverterTest, InterleavedChromaInEitherOrderMatchesReference) {
+    YuvImage image(kWidth, kHeight, 2);
+    image.layout(2, 16, false);
+    EXPECT_LE(renderAndCompare(image, YuvMatrix::Bt601, YuvRange::Full), 2.0);
+    image.layout(2, 16, true);
+    EXPECT_LE(renderAndCompare(image, YuvMatrix::Bt601, YuvRange::Full), 2.0);
+}
+
+TEST_F(YuvConverterTest, Bt709LimitedRangeMatchesReference) {
+    YuvImage image(kWidth, kHeight, 3);
+    image.layout(2, 0);
+    EXPECT_LE(renderAndCompare(image, YuvMatrix::Bt709, YuvRange::Limited), 2.0);
+}
+
+TEST_F(YuvConverterTest, OddInterleavedStrideIsRepacked) {
+    YuvImage image(kWidth, kHeight, 4);
+    image.layout(2, 3);
+    EXPECT_LE(renderAndCompare(image, YuvMatrix::Bt601, YuvRange::Full), 2.0);
+}
+
+TEST_F(YuvConverterTest, StagedUploadsMatchReferenceAcrossTheRing) {
+    for (int buffers = 1; buffers <= YuvConverter::kMaxUploadBuffers; ++buffers) {
+        converter_.release();
+        converter_.setUploadBuffers(buffers);
+        ASSERT_TRUE(converter_.init(shaders_));
+        // More frames than slots, so every slot is reused behind its fence.
+        const unsigned frames = 2 * unsigned(buffers) + 1;
+        for (unsigned frame = 0; frame < frames; ++frame) {
+            YuvImage image(kWidth, kHeight, 10 * buffers + frame);
+            image.layout(frame % 2 ? 2 : 1, 8 * frame);
+            EXPECT_LE(renderAndCompare(image, YuvMatrix::Bt601, YuvRange::Full), 2.0)
+                    << buffers << " buffers, frame " << frame;
+        }
+        // None of them fell back to a direct upload.
+        EXPECT_EQ(converter_.stagedUploads(), frames) << buffers << " buffers";
+    }
+}
+
+TEST_F(YuvConverterTest, RotatedFrameIsUprightAndLetterboxed) {
+    // Gray frame with a white top-left quadrant, seen by a sensor mounted a
+    // quarter turn clockwise: upright, that quadrant is top-right.
+    std::vector<uint8_t> y(size_t(kWidth) * kHeight, 64), chroma(size_t(kWidth / 2) * (kHeight / 2), 128);
+    for (int row = 0; row < kHeight / 2; ++row) std::fill_n(&y[row * kWidth], kWidth / 2, 255);
+    Frame frame;
+    frame.width = kWidth;
+    frame.height = kHeight;
+    frame.rotation = 90;
+    frame.planeCount = 3;
+    frame.planes[0] = {y.data(), int(y.size()), kWidth, 1};
+    frame.planes[1] = frame.planes[2] = {chroma.data(), int(chroma.size()), kWidth / 2, 1};
+
+    converter_.setViewport(kWidth, kHeight);
+    converter_.upload(frame);
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    converter_.draw();
+    std::vector<uint8_t> rgba(size_t(kWidth) * kHeight * 4);
+    glReadPixels(0, 0, kWidth, kHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    ASSERT_EQ(glGetError(), GLenum(GL_NO_ERROR));
+    // Readback row 0 is the bottom of the viewport.
+    auto luma = [&](int col, int rowFromTop) { return rgba[(size_t(kHeight - 1 - rowFromTop) * kWidth + col) * 4]; };
+
+    // Upright the frame is 48x64; fit to 64x48 it is 36x48, centred at x 14-50.
+    EXPECT_EQ(luma(4, kHeight / 2), 0);
+    EXPECT_EQ(luma(kWidth - 5, kHeight / 2), 0);
+    EXPECT_NEAR(luma(41, 12), 255, 2);  // top-right: the white quadrant
+    EXPECT_NEAR(luma(23, 12), 64, 2);
+    EXPECT_NEAR(luma(41, 36), 64, 2);
+    EXPECT_NEAR(luma(23, 36), 64, 2);
+}
+
+}  // namespace